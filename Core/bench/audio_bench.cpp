@@ -0,0 +1,290 @@
+/**
+ * Audio Benchmarks
+ * FloatMixer, UserAudioBuffer, JitterBuffer, capture analysis, VAD,
+ * preprocessor, echo canceller and resampler hot paths
+ */
+
+#include "audio_kernels.h"
+#include "bench_signal.h"
+#include "jitter_buffer.h"
+#include "speex_dsp.h"
+#include "user_audio_buffer.h"
+#include "vad.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sayses {
+namespace {
+
+using bench::kFrameSize;
+
+// =============================================================================
+// FloatMixer
+// =============================================================================
+
+void BM_FloatMixer(benchmark::State& state) {
+    const int inputs = static_cast<int>(state.range(0));
+    auto mixer = FloatMixer::create(kFrameSize);
+
+    std::vector<std::vector<float>> users;
+    for (int u = 0; u < inputs; u++) {
+        users.push_back(bench::makeSpeechFloat(kFrameSize, u + 1));
+    }
+    std::vector<int16_t> output(kFrameSize);
+
+    for (auto _ : state) {
+        mixer->clear();
+        for (const auto& user : users) {
+            mixer->add(user.data(), kFrameSize);
+        }
+        mixer->getMixed(output.data(), kFrameSize);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * inputs * kFrameSize);
+}
+BENCHMARK(BM_FloatMixer)->RangeMultiplier(2)->Range(1, 32);
+
+// Per-user gain ramps, as used for volume changes and ducking
+void BM_FloatMixerGainRamp(benchmark::State& state) {
+    const int inputs = static_cast<int>(state.range(0));
+    auto mixer = FloatMixer::create(kFrameSize);
+
+    std::vector<std::vector<float>> users;
+    for (int u = 0; u < inputs; u++) {
+        users.push_back(bench::makeSpeechFloat(kFrameSize, u + 1));
+    }
+    std::vector<int16_t> output(kFrameSize);
+
+    for (auto _ : state) {
+        mixer->clear();
+        for (const auto& user : users) {
+            mixer->add(user.data(), kFrameSize, 1.0f, 0.3f);
+        }
+        mixer->getMixed(output.data(), kFrameSize);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * inputs * kFrameSize);
+}
+BENCHMARK(BM_FloatMixerGainRamp)->RangeMultiplier(2)->Range(1, 32);
+
+// =============================================================================
+// UserAudioBuffer
+// =============================================================================
+
+// One network frame in, one render frame out (steady state)
+void BM_UserAudioBufferAddRead(benchmark::State& state) {
+    UserAudioBuffer::Config config;
+    config.storeInt16 = state.range(0) != 0;
+    auto buffer = UserAudioBuffer::create(1, config);
+
+    std::vector<int16_t> frame = bench::makeSpeech(kFrameSize);
+    std::vector<float> output(kFrameSize);
+
+    // Fill to the playback threshold first
+    int64_t sequence = 0;
+    const int primeFrames = config.minBufferMs / 10 + 1;
+    for (int i = 0; i < primeFrames; i++) {
+        buffer->addSamples(frame.data(), kFrameSize, sequence++);
+    }
+
+    for (auto _ : state) {
+        buffer->addSamples(frame.data(), kFrameSize, sequence++);
+        benchmark::DoNotOptimize(buffer->readFloat(output.data(), kFrameSize));
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_UserAudioBufferAddRead)->ArgName("int16")->Arg(0)->Arg(1);
+
+// =============================================================================
+// JitterBuffer
+// =============================================================================
+
+// Packets arrive with every pair swapped plus an occasional late packet
+void BM_JitterBufferReordered(benchmark::State& state) {
+    JitterBuffer::Config config;
+    auto jitter = JitterBuffer::create(config);
+
+    std::vector<int16_t> frame = bench::makeSpeech(kFrameSize);
+    std::vector<int16_t> output(kFrameSize);
+
+    // Precomputed arrival order so the loop only measures the buffer
+    constexpr uint32_t kPattern = 64;
+    std::vector<uint32_t> order(kPattern);
+    for (uint32_t i = 0; i < kPattern; i++) {
+        order[i] = i ^ 1;
+    }
+    std::swap(order[10], order[14]);
+    std::swap(order[41], order[45]);
+
+    uint32_t base = 0;
+    size_t index = 0;
+    for (auto _ : state) {
+        uint32_t sequence = base + order[index];
+        jitter->put(frame.data(), kFrameSize, sequence, sequence * kFrameSize);
+        benchmark::DoNotOptimize(jitter->get(output.data(), kFrameSize));
+
+        if (++index == kPattern) {
+            index = 0;
+            base += kPattern;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_JitterBufferReordered);
+
+// =============================================================================
+// Capture analysis: three separate RMS loops (level meter, VAD, preprocessor)
+// versus the fused kernels::analyzeFrame pass
+// =============================================================================
+
+float legacyRms(const int16_t* samples, size_t frames) {
+    double sum = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        double normalized = samples[i] / 32768.0;
+        sum += normalized * normalized;
+    }
+    return static_cast<float>(std::sqrt(sum / frames));
+}
+
+void BM_CaptureAnalysisSeparate(benchmark::State& state) {
+    std::vector<int16_t> frame = bench::makeSpeech(kFrameSize);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacyRms(frame.data(), kFrameSize));
+        benchmark::DoNotOptimize(legacyRms(frame.data(), kFrameSize));
+        benchmark::DoNotOptimize(legacyRms(frame.data(), kFrameSize));
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_CaptureAnalysisSeparate);
+
+void BM_CaptureAnalysisFused(benchmark::State& state) {
+    std::vector<int16_t> frame = bench::makeSpeech(kFrameSize);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels::analyzeFrame(frame.data(), kFrameSize));
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_CaptureAnalysisFused);
+
+// =============================================================================
+// VoiceActivityDetector
+// =============================================================================
+
+void BM_VadProcess(benchmark::State& state) {
+    VoiceActivityDetector::Config config;
+    auto vad = VoiceActivityDetector::create(config);
+
+    constexpr size_t kFrames = 100;
+    std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kFrames);
+
+    size_t frame = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(vad->process(signal.data() + frame * kFrameSize, kFrameSize));
+        frame = (frame + 1) % kFrames;
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_VadProcess);
+
+// =============================================================================
+// Preprocessor (denoise + AGC): libspeexdsp vs the float implementation
+// =============================================================================
+
+void BM_Preprocess(benchmark::State& state) {
+    const bool useFloat = state.range(0) != 0;
+    SpeexPreprocessor::Config config;
+    config.dereverbEnabled = false;
+    auto preprocessor = useFloat ? SpeexPreprocessor::createFloat(config)
+                                 : SpeexPreprocessor::create(config);
+
+    constexpr size_t kFrames = 100;
+    const std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kFrames);
+    std::vector<int16_t> frame(signal.begin(), signal.begin() + kFrameSize);
+    if (!preprocessor->process(frame.data(), kFrameSize)) {
+        state.SkipWithError("libspeexdsp built without the preprocessor");
+        return;
+    }
+
+    size_t index = 0;
+    for (auto _ : state) {
+        std::copy_n(signal.begin() + index * kFrameSize, kFrameSize, frame.begin());
+        preprocessor->process(frame.data(), kFrameSize);
+        benchmark::DoNotOptimize(frame.data());
+        index = (index + 1) % kFrames;
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_Preprocess)->ArgName("float")->Arg(0)->Arg(1);
+
+// =============================================================================
+// SpeexEchoCanceller (cost grows with the tail length)
+// =============================================================================
+
+void BM_EchoCanceller(benchmark::State& state) {
+    const int tailMs = static_cast<int>(state.range(0));
+    auto canceller = SpeexEchoCanceller::create(48000, static_cast<int>(kFrameSize), tailMs);
+
+    // Capture = far end delayed by 5 ms and attenuated, plus a quiet near talker
+    constexpr size_t kFrames = 100;
+    constexpr size_t kEchoDelay = 240;
+    const std::vector<int16_t> far = bench::makeSpeech(kFrameSize * kFrames + kEchoDelay, bench::kSampleRate, 1);
+    const std::vector<int16_t> near = bench::makeSpeech(kFrameSize * kFrames, bench::kSampleRate, 2);
+    std::vector<int16_t> captured(kFrameSize * kFrames);
+    for (size_t i = 0; i < captured.size(); i++) {
+        captured[i] = static_cast<int16_t>(far[i] / 2 + near[i] / 8);
+    }
+    std::vector<int16_t> output(kFrameSize);
+
+    size_t index = 0;
+    for (auto _ : state) {
+        canceller->process(captured.data() + index * kFrameSize,
+                           far.data() + kEchoDelay + index * kFrameSize,
+                           output.data(), kFrameSize);
+        benchmark::DoNotOptimize(output.data());
+        index = (index + 1) % kFrames;
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_EchoCanceller)->ArgName("tail_ms")->Arg(50)->Arg(100)->Arg(200);
+
+// =============================================================================
+// SpeexResampler (Bluetooth HFP <-> Opus rate): libspeexdsp vs the polyphase
+// resampler create() picks for integer ratios
+// =============================================================================
+
+void BM_Resampler(benchmark::State& state) {
+    const int inputRate = static_cast<int>(state.range(0));
+    const int outputRate = static_cast<int>(state.range(1));
+    const bool polyphase = state.range(2) != 0;
+    auto resampler = polyphase ? SpeexResampler::createPolyphase(1, inputRate, outputRate)
+                               : SpeexResampler::createSpeex(1, inputRate, outputRate);
+    if (!resampler) {
+        state.SkipWithError("No polyphase resampler for this ratio");
+        return;
+    }
+
+    const size_t inputFrames = static_cast<size_t>(inputRate / 100);
+    std::vector<int16_t> input = bench::makeSpeech(inputFrames, inputRate);
+    std::vector<int16_t> output(static_cast<size_t>(outputRate / 100) + 16);
+
+    for (auto _ : state) {
+        size_t consumed = inputFrames;
+        size_t produced = output.size();
+        resampler->process(input.data(), consumed, output.data(), produced);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * inputFrames);
+}
+BENCHMARK(BM_Resampler)
+    ->ArgNames({"in", "out", "polyphase"})
+    ->ArgsProduct({{16000}, {48000}, {0, 1}})
+    ->ArgsProduct({{48000}, {16000}, {0, 1}})
+    ->ArgsProduct({{8000}, {48000}, {0, 1}})
+    ->ArgsProduct({{48000}, {8000}, {0, 1}})
+    ->Args({44100, 48000, 0});
+
+}  // namespace
+}  // namespace sayses
@@ -0,0 +1,58 @@
+/**
+ * Benchmark Signals
+ * Deterministic speech-like test audio shared by the SaysesCore benchmarks
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace sayses {
+namespace bench {
+
+constexpr int kSampleRate = 48000;
+constexpr size_t kFrameSize = 480;  // 10ms at 48kHz
+
+/**
+ * Voiced-speech stand-in: a few harmonics with a 4Hz syllable envelope and
+ * a little deterministic noise, so codecs and VAD do real work.
+ * @param seed Varies pitch and noise between users
+ */
+inline std::vector<int16_t> makeSpeech(size_t samples, int sampleRate = kSampleRate, uint32_t seed = 1) {
+    std::vector<int16_t> out(samples);
+    const double pitch = 110.0 + 15.0 * (seed % 8);
+    uint32_t noise = 0x9E3779B9u * seed;
+
+    for (size_t i = 0; i < samples; i++) {
+        double t = static_cast<double>(i) / sampleRate;
+        double envelope = 0.55 + 0.45 * std::sin(2.0 * M_PI * 4.0 * t);
+        double voiced = 0.0;
+        for (int h = 1; h <= 5; h++) {
+            voiced += std::sin(2.0 * M_PI * pitch * h * t) / h;
+        }
+
+        noise = noise * 1664525u + 1013904223u;
+        double hiss = (static_cast<int32_t>(noise) / 2147483648.0) * 0.02;
+
+        out[i] = static_cast<int16_t>((voiced * 0.25 * envelope + hiss) * 32767.0);
+    }
+    return out;
+}
+
+/**
+ * Float copy of makeSpeech() in [-1, 1], as the mixer consumes it.
+ */
+inline std::vector<float> makeSpeechFloat(size_t samples, uint32_t seed = 1) {
+    std::vector<int16_t> pcm = makeSpeech(samples, kSampleRate, seed);
+    std::vector<float> out(samples);
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = pcm[i] / 32768.0f;
+    }
+    return out;
+}
+
+}  // namespace bench
+}  // namespace sayses
@@ -0,0 +1,164 @@
+/**
+ * Codec Benchmarks
+ * Opus encode/decode at every encoder complexity, short-frame and low-delay
+ * encode, and int16 vs float decode into a user buffer
+ */
+
+#include "bench_signal.h"
+#include "codec.h"
+#include "user_audio_buffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+
+namespace sayses {
+namespace {
+
+using bench::kFrameSize;
+
+constexpr size_t kMaxPacketSize = 4000;
+constexpr size_t kSignalFrames = 100;  // 1s of speech, cycled
+
+Codec::Config opusConfig(int complexity) {
+    Codec::Config config;
+    config.complexity = complexity;
+    return config;
+}
+
+void BM_OpusEncode(benchmark::State& state) {
+    auto codec = Codec::createOpus(opusConfig(static_cast<int>(state.range(0))));
+    std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kSignalFrames);
+    uint8_t packet[kMaxPacketSize];
+
+    size_t frame = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        int encoded = codec->encode(signal.data() + frame * kFrameSize, kFrameSize,
+                                    packet, kMaxPacketSize);
+        benchmark::DoNotOptimize(packet);
+        bytes += encoded > 0 ? encoded : 0;
+        frame = (frame + 1) % kSignalFrames;
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+    state.counters["bytes_per_frame"] = benchmark::Counter(
+        static_cast<double>(bytes) / static_cast<double>(state.iterations()));
+}
+BENCHMARK(BM_OpusEncode)->ArgName("complexity")->DenseRange(0, 10);
+
+// Encode cost of short frames: 10ms of speech per iteration, cut into
+// 2.5/5/10ms frames, with the VoIP or the restricted low-delay application
+void BM_OpusEncodeFrameSize(benchmark::State& state) {
+    const size_t frameSize = static_cast<size_t>(state.range(0)) * kFrameSize / 10000;
+    Codec::Config config;
+    config.frameSize = static_cast<int>(frameSize);
+    config.lowDelay = state.range(1) != 0;
+    auto codec = Codec::createOpus(config);
+    std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kSignalFrames);
+    uint8_t packet[kMaxPacketSize];
+
+    size_t frame = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        const int16_t* input = signal.data() + frame * kFrameSize;
+        for (size_t offset = 0; offset < kFrameSize; offset += frameSize) {
+            int encoded = codec->encode(input + offset, frameSize, packet, kMaxPacketSize);
+            benchmark::DoNotOptimize(packet);
+            bytes += encoded > 0 ? encoded : 0;
+        }
+        frame = (frame + 1) % kSignalFrames;
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+    state.counters["bytes_per_10ms"] = benchmark::Counter(
+        static_cast<double>(bytes) / static_cast<double>(state.iterations()));
+}
+BENCHMARK(BM_OpusEncodeFrameSize)
+    ->ArgNames({"frame_us", "low_delay"})
+    ->ArgsProduct({{2500, 5000, 10000}, {0, 1}});
+
+void BM_OpusDecode(benchmark::State& state) {
+    auto codec = Codec::createOpus(opusConfig(static_cast<int>(state.range(0))));
+    std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kSignalFrames);
+
+    // Decode cost depends on what the encoder chose, so encode at the same complexity
+    std::vector<std::vector<uint8_t>> packets;
+    uint8_t packet[kMaxPacketSize];
+    for (size_t f = 0; f < kSignalFrames; f++) {
+        int encoded = codec->encode(signal.data() + f * kFrameSize, kFrameSize,
+                                    packet, kMaxPacketSize);
+        if (encoded > 0) {
+            packets.emplace_back(packet, packet + encoded);
+        }
+    }
+    if (packets.empty()) {
+        state.SkipWithError("encoder produced no packets");
+        return;
+    }
+
+    std::vector<int16_t> output(kFrameSize);
+    size_t index = 0;
+    for (auto _ : state) {
+        const auto& p = packets[index];
+        benchmark::DoNotOptimize(codec->decode(p.data(), p.size(), output.data(), kFrameSize));
+        index = (index + 1) % packets.size();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_OpusDecode)->ArgName("complexity")->DenseRange(0, 10);
+
+void BM_OpusDecodePLC(benchmark::State& state) {
+    auto codec = Codec::createOpus(opusConfig(5));
+    std::vector<int16_t> output(kFrameSize);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(codec->decodePLC(output.data(), kFrameSize));
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_OpusDecodePLC);
+
+// Receive path per packet: decode, hand to the user buffer, read for mixing.
+// The float decoder output goes into the float ring without conversions.
+void BM_OpusDecodeToBuffer(benchmark::State& state) {
+    const bool useFloat = state.range(0) != 0;
+    auto codec = Codec::createOpus(opusConfig(5));
+    std::vector<int16_t> signal = bench::makeSpeech(kFrameSize * kSignalFrames);
+
+    std::vector<std::vector<uint8_t>> packets;
+    uint8_t packet[kMaxPacketSize];
+    for (size_t f = 0; f < kSignalFrames; f++) {
+        int encoded = codec->encode(signal.data() + f * kFrameSize, kFrameSize,
+                                    packet, kMaxPacketSize);
+        if (encoded > 0) {
+            packets.emplace_back(packet, packet + encoded);
+        }
+    }
+    if (packets.empty()) {
+        state.SkipWithError("encoder produced no packets");
+        return;
+    }
+
+    auto buffer = UserAudioBuffer::create(1, UserAudioBuffer::Config());
+    std::vector<int16_t> pcm(kFrameSize);
+    std::vector<float> pcmFloat(kFrameSize);
+    std::vector<float> mix(kFrameSize);
+    int64_t sequence = 0;
+    size_t index = 0;
+    for (auto _ : state) {
+        const auto& p = packets[index];
+        if (useFloat) {
+            int frames = codec->decode(p.data(), p.size(), pcmFloat.data(), kFrameSize);
+            buffer->addSamples(pcmFloat.data(), static_cast<size_t>(std::max(frames, 0)), sequence++);
+        } else {
+            int frames = codec->decode(p.data(), p.size(), pcm.data(), kFrameSize);
+            buffer->addSamples(pcm.data(), static_cast<size_t>(std::max(frames, 0)), sequence++);
+        }
+        benchmark::DoNotOptimize(buffer->readFloat(mix.data(), kFrameSize));
+        index = (index + 1) % packets.size();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameSize);
+}
+BENCHMARK(BM_OpusDecodeToBuffer)->ArgName("float")->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace sayses
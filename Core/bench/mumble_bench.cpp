@@ -0,0 +1,192 @@
+/**
+ * Mumble Protocol Benchmarks
+ * CryptState OCB-AES128 and TCP control-message parsing
+ */
+
+#include "crypto.h"
+#include "Mumble.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace sayses {
+namespace {
+
+// =============================================================================
+// CryptState
+// =============================================================================
+
+void initCrypt(CryptState& client, CryptState& server) {
+    uint8_t key[16];
+    uint8_t clientNonce[16];
+    uint8_t serverNonce[16];
+    for (int i = 0; i < 16; i++) {
+        key[i] = static_cast<uint8_t>(i * 7 + 1);
+        clientNonce[i] = static_cast<uint8_t>(i * 13 + 3);
+        serverNonce[i] = static_cast<uint8_t>(i * 29 + 5);
+    }
+    client.init(key, clientNonce, serverNonce);
+    // The receiving side decrypts with the sender's nonce
+    server.init(key, serverNonce, clientNonce);
+}
+
+void BM_CryptEncrypt(benchmark::State& state) {
+    const size_t length = static_cast<size_t>(state.range(0));
+    CryptState client;
+    CryptState server;
+    initCrypt(client, server);
+
+    std::vector<uint8_t> plain(length, 0x5A);
+    std::vector<uint8_t> encrypted(length + 4);
+
+    for (auto _ : state) {
+        client.encrypt(plain.data(), encrypted.data(), length);
+        benchmark::DoNotOptimize(encrypted.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(length));
+}
+// Typical Opus voice packets (10-20ms, 16-64 kbps) plus a large one
+BENCHMARK(BM_CryptEncrypt)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+void BM_CryptDecrypt(benchmark::State& state) {
+    const size_t length = static_cast<size_t>(state.range(0));
+    CryptState client;
+    CryptState server;
+    initCrypt(client, server);
+
+    // A window of packets in send order, replayed cyclically
+    constexpr size_t kPackets = 64;
+    std::vector<uint8_t> plain(length, 0x5A);
+    std::vector<std::vector<uint8_t>> packets(kPackets, std::vector<uint8_t>(length + 4));
+    for (auto& packet : packets) {
+        client.encrypt(plain.data(), packet.data(), length);
+    }
+
+    std::vector<uint8_t> packet(length + 4);
+    std::vector<uint8_t> decrypted(length);
+    size_t index = 0;
+    for (auto _ : state) {
+        std::memcpy(packet.data(), packets[index].data(), packet.size());
+        benchmark::DoNotOptimize(server.decrypt(packet.data(), decrypted.data(), packet.size()));
+        index = (index + 1) % kPackets;
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(length));
+}
+BENCHMARK(BM_CryptDecrypt)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+// =============================================================================
+// Control messages
+// =============================================================================
+
+// Message type IDs on the TCP control channel
+constexpr uint16_t kTypeServerSync = 5;
+constexpr uint16_t kTypeChannelState = 7;
+constexpr uint16_t kTypeUserState = 9;
+
+MumbleProto::UserState makeUserState(uint32_t session) {
+    MumbleProto::UserState state;
+    state.set_session(session);
+    state.set_name("Dispatcher-" + std::to_string(session));
+    state.set_user_id(1000 + session);
+    state.set_channel_id(session % 12);
+    state.set_self_mute(session % 3 == 0);
+    state.set_priority_speaker(session == 1);
+    state.set_hash(std::string(40, 'a' + static_cast<char>(session % 26)));
+    state.set_comment_hash(std::string(20, '\x11'));
+    return state;
+}
+
+MumbleProto::ChannelState makeChannelState(uint32_t channelId) {
+    MumbleProto::ChannelState state;
+    state.set_channel_id(channelId);
+    state.set_parent(0);
+    state.set_name("Channel " + std::to_string(channelId));
+    state.set_description("Talk group for unit " + std::to_string(channelId));
+    state.add_links((channelId + 1) % 12);
+    state.set_position(static_cast<int32_t>(channelId));
+    state.set_max_users(64);
+    return state;
+}
+
+template <typename Message>
+void BM_ParseMessage(benchmark::State& state, const Message& message) {
+    std::string payload = message.SerializeAsString();
+    Message parsed;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parsed.ParseFromArray(payload.data(), static_cast<int>(payload.size())));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK_CAPTURE(BM_ParseMessage, UserState, makeUserState(7));
+BENCHMARK_CAPTURE(BM_ParseMessage, ChannelState, makeChannelState(3));
+
+void appendFramed(std::vector<uint8_t>& stream, uint16_t type, const std::string& payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    const uint8_t header[6] = {
+        static_cast<uint8_t>(type >> 8), static_cast<uint8_t>(type),
+        static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+        static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)
+    };
+    stream.insert(stream.end(), header, header + sizeof(header));
+    stream.insert(stream.end(), payload.begin(), payload.end());
+}
+
+// Connect-time burst: channel tree, user list, ServerSync, framed as on the wire
+void BM_ParseControlStream(benchmark::State& state) {
+    const uint32_t users = static_cast<uint32_t>(state.range(0));
+
+    std::vector<uint8_t> stream;
+    for (uint32_t c = 0; c < 12; c++) {
+        appendFramed(stream, kTypeChannelState, makeChannelState(c).SerializeAsString());
+    }
+    for (uint32_t u = 1; u <= users; u++) {
+        appendFramed(stream, kTypeUserState, makeUserState(u).SerializeAsString());
+    }
+    MumbleProto::ServerSync sync;
+    sync.set_session(1);
+    sync.set_max_bandwidth(72000);
+    sync.set_welcome_text("Welcome");
+    appendFramed(stream, kTypeServerSync, sync.SerializeAsString());
+
+    MumbleProto::ChannelState channelState;
+    MumbleProto::UserState userState;
+    MumbleProto::ServerSync serverSync;
+
+    for (auto _ : state) {
+        size_t offset = 0;
+        int parsed = 0;
+        while (offset + 6 <= stream.size()) {
+            const uint8_t* header = stream.data() + offset;
+            uint16_t type = static_cast<uint16_t>((header[0] << 8) | header[1]);
+            uint32_t length = (static_cast<uint32_t>(header[2]) << 24) | (header[3] << 16) |
+                              (header[4] << 8) | header[5];
+            const uint8_t* payload = header + 6;
+            int size = static_cast<int>(length);
+
+            switch (type) {
+                case kTypeChannelState:
+                    parsed += channelState.ParseFromArray(payload, size);
+                    break;
+                case kTypeUserState:
+                    parsed += userState.ParseFromArray(payload, size);
+                    break;
+                case kTypeServerSync:
+                    parsed += serverSync.ParseFromArray(payload, size);
+                    break;
+                default:
+                    break;
+            }
+            offset += 6 + length;
+        }
+        benchmark::DoNotOptimize(parsed);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(stream.size()));
+}
+BENCHMARK(BM_ParseControlStream)->ArgName("users")->Arg(10)->Arg(100)->Arg(500);
+
+}  // namespace
+}  // namespace sayses
@@ -0,0 +1,90 @@
+/**
+ * Network Impairment Implementation
+ */
+
+#include "network_impairment.h"
+
+#include <cmath>
+
+namespace sayses {
+namespace bench {
+
+NetworkImpairment::NetworkImpairment(const Config& config)
+    : config_(config)
+    , state_(config.seed ^ 0x9E3779B97F4A7C15ULL) {
+}
+
+double NetworkImpairment::uniform() {
+    // splitmix64: fast, and identical output on every platform
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double NetworkImpairment::standardNormal() {
+    // Box-Muller; the second value is thrown away to keep the stream simple
+    double u1 = uniform();
+    double u2 = uniform();
+    if (u1 < 1e-300) {
+        u1 = 1e-300;
+    }
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+double NetworkImpairment::jitterDelay() {
+    switch (config_.jitter) {
+        case Jitter::None:
+            return 0.0;
+        case Jitter::Uniform:
+            return uniform() * config_.jitterMs;
+        case Jitter::Normal:
+            return std::fabs(standardNormal()) * config_.jitterMs;
+        case Jitter::Pareto: {
+            // Shifted so the minimum extra delay is 0
+            constexpr double kAlpha = 2.5;
+            double u = 1.0 - uniform();
+            return config_.jitterMs * (std::pow(u, -1.0 / kAlpha) - 1.0);
+        }
+    }
+    return 0.0;
+}
+
+void NetworkImpairment::transmit(double sendTimeMs, std::vector<double>& arrivals) {
+    arrivals.clear();
+    stats_.sent++;
+
+    // Advance the Gilbert-Elliott channel, then draw the loss in the new state
+    if (badState_) {
+        if (uniform() < config_.burstR) {
+            badState_ = false;
+        }
+    } else if (uniform() < config_.burstP) {
+        badState_ = true;
+    }
+
+    double lossProbability = badState_ ? config_.lossBad : config_.lossGood;
+    if (uniform() < lossProbability) {
+        stats_.lost++;
+        if (badState_) {
+            stats_.burstLosses++;
+        }
+        return;
+    }
+
+    double arrival = sendTimeMs + config_.baseDelayMs + jitterDelay();
+    if (uniform() < config_.reorderProbability) {
+        arrival += config_.reorderDelayMs;
+        stats_.reordered++;
+    }
+    arrivals.push_back(arrival);
+
+    if (uniform() < config_.duplicateProbability) {
+        arrivals.push_back(arrival + config_.duplicateDelayMs);
+        stats_.duplicated++;
+    }
+}
+
+}  // namespace bench
+}  // namespace sayses
@@ -0,0 +1,86 @@
+/**
+ * Network Impairment
+ * Deterministic, seedable packet network model for receive-path testing
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace sayses {
+namespace bench {
+
+/**
+ * Decides the fate of each packet sent through a simulated network:
+ * - One-way delay: base delay plus a jitter distribution
+ * - Bursty loss: two-state Gilbert-Elliott channel
+ * - Reordering: a fraction of packets is held back for extra time
+ * - Duplication: a fraction of packets arrives twice
+ *
+ * All randomness comes from a private generator (not <random>'s
+ * distributions, whose output differs between standard libraries), so a
+ * given seed produces the same packet fates on every platform.
+ */
+class NetworkImpairment {
+public:
+    enum class Jitter {
+        None,
+        Uniform,   // base + U(0, jitterMs)
+        Normal,    // base + |N(0, jitterMs)|
+        Pareto     // base + heavy-tailed Pareto with scale jitterMs (alpha 2.5)
+    };
+
+    struct Config {
+        uint64_t seed = 1;
+
+        double baseDelayMs = 40.0;
+        Jitter jitter = Jitter::Normal;
+        double jitterMs = 10.0;
+
+        // Gilbert-Elliott: p = P(good -> bad), r = P(bad -> good) per packet
+        double burstP = 0.0;
+        double burstR = 0.3;
+        double lossGood = 0.0;   // Loss probability in the good state
+        double lossBad = 0.5;    // Loss probability in the bad state
+
+        double reorderProbability = 0.0;
+        double reorderDelayMs = 20.0;   // Extra delay of a reordered packet
+
+        double duplicateProbability = 0.0;
+        double duplicateDelayMs = 5.0;  // Copy arrives this much after the original
+    };
+
+    struct Stats {
+        uint64_t sent = 0;
+        uint64_t lost = 0;
+        uint64_t burstLosses = 0;   // Losses in the bad state
+        uint64_t reordered = 0;     // Packets held back on purpose
+        uint64_t duplicated = 0;
+    };
+
+    explicit NetworkImpairment(const Config& config);
+
+    /**
+     * Send one packet.
+     * @param sendTimeMs Time the packet leaves the sender
+     * @param arrivals Receives 0 (lost), 1 or 2 (duplicated) arrival times
+     */
+    void transmit(double sendTimeMs, std::vector<double>& arrivals);
+
+    const Stats& getStats() const { return stats_; }
+
+private:
+    double uniform();          // [0, 1)
+    double standardNormal();
+    double jitterDelay();
+
+    Config config_;
+    Stats stats_;
+    uint64_t state_;
+    bool badState_{false};
+};
+
+}  // namespace bench
+}  // namespace sayses
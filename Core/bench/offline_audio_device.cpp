@@ -0,0 +1,493 @@
+/**
+ * OfflineAudioDevice Implementation
+ * File-backed virtual device on a simulated clock, built on AudioPipeline
+ */
+
+#include "offline_audio_device.h"
+#include "audio_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace sayses {
+
+namespace {
+
+constexpr uint64_t kNanosPerSecond = 1000000000ULL;
+constexpr uint64_t kClockEpochNs = kNanosPerSecond;  // Keeps the first host time nonzero (0 = unknown)
+constexpr size_t kWavHeaderSize = 44;
+
+uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t readLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+double processCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+void writeLE32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+    p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+void writeLE16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+bool endsWith(const std::string& value, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    if (value.size() < length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = value[value.size() - length + i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (c != suffix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// PCM file reader: 16-bit WAV (any channel count, downmixed) or raw s16le mono
+// =============================================================================
+
+class PcmFileReader {
+public:
+    ~PcmFileReader() {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    bool open(const std::string& path, int& sampleRate) {
+        file_ = std::fopen(path.c_str(), "rb");
+        if (!file_) {
+            std::fprintf(stderr, "[OfflineAudioDevice] Cannot open input '%s'\n", path.c_str());
+            return false;
+        }
+
+        uint8_t riff[12];
+        if (std::fread(riff, 1, sizeof(riff), file_) == sizeof(riff) &&
+            std::memcmp(riff, "RIFF", 4) == 0 && std::memcmp(riff + 8, "WAVE", 4) == 0) {
+            return parseWav(path, sampleRate);
+        }
+
+        // Raw PCM: the whole file is mono samples at the configured rate
+        std::fseek(file_, 0, SEEK_END);
+        long size = std::ftell(file_);
+        dataOffset_ = 0;
+        dataFrames_ = size > 0 ? static_cast<uint64_t>(size) / sizeof(int16_t) : 0;
+        channels_ = 1;
+        return rewind();
+    }
+
+    /**
+     * Read up to frames mono samples.
+     * @return Frames read (less than requested at the end of the data)
+     */
+    size_t read(int16_t* output, size_t frames) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(frames, dataFrames_ - position_));
+        if (count == 0) {
+            return 0;
+        }
+
+        if (channels_ == 1) {
+            count = std::fread(output, sizeof(int16_t), count, file_);
+        } else {
+            staging_.resize(count * channels_);
+            count = std::fread(staging_.data(), sizeof(int16_t) * channels_, count, file_);
+            for (size_t i = 0; i < count; i++) {
+                int32_t sum = 0;
+                for (int c = 0; c < channels_; c++) {
+                    sum += staging_[i * channels_ + c];
+                }
+                output[i] = static_cast<int16_t>(sum / channels_);
+            }
+        }
+
+        position_ += count;
+        return count;
+    }
+
+    bool rewind() {
+        position_ = 0;
+        return std::fseek(file_, static_cast<long>(dataOffset_), SEEK_SET) == 0;
+    }
+
+    bool empty() const { return dataFrames_ == 0; }
+
+private:
+    bool parseWav(const std::string& path, int& sampleRate) {
+        bool haveFormat = false;
+        uint8_t header[8];
+
+        while (std::fread(header, 1, sizeof(header), file_) == sizeof(header)) {
+            uint32_t chunkSize = readLE32(header + 4);
+            long chunkStart = std::ftell(file_);
+
+            if (std::memcmp(header, "fmt ", 4) == 0 && chunkSize >= 16) {
+                uint8_t fmt[16];
+                if (std::fread(fmt, 1, sizeof(fmt), file_) != sizeof(fmt)) {
+                    break;
+                }
+                uint16_t format = readLE16(fmt);
+                channels_ = readLE16(fmt + 2);
+                sampleRate = static_cast<int>(readLE32(fmt + 4));
+                uint16_t bits = readLE16(fmt + 14);
+
+                // PCM or WAVE_FORMAT_EXTENSIBLE carrying PCM
+                if ((format != 1 && format != 0xFFFE) || bits != 16 || channels_ < 1) {
+                    std::fprintf(stderr, "[OfflineAudioDevice] '%s': only 16-bit PCM WAV is supported\n",
+                                 path.c_str());
+                    return false;
+                }
+                haveFormat = true;
+            } else if (std::memcmp(header, "data", 4) == 0) {
+                if (!haveFormat) {
+                    break;
+                }
+                dataOffset_ = static_cast<uint64_t>(chunkStart);
+                dataFrames_ = chunkSize / (sizeof(int16_t) * channels_);
+                return rewind();
+            }
+
+            // Chunks are word aligned
+            std::fseek(file_, chunkStart + static_cast<long>(chunkSize + (chunkSize & 1)), SEEK_SET);
+        }
+
+        std::fprintf(stderr, "[OfflineAudioDevice] '%s': no PCM data chunk\n", path.c_str());
+        return false;
+    }
+
+    std::FILE* file_{nullptr};
+    uint64_t dataOffset_{0};
+    uint64_t dataFrames_{0};
+    uint64_t position_{0};
+    int channels_{1};
+    std::vector<int16_t> staging_;
+};
+
+// =============================================================================
+// PCM file writer: mono 16-bit WAV or raw s16le
+// =============================================================================
+
+class PcmFileWriter {
+public:
+    ~PcmFileWriter() {
+        close();
+    }
+
+    bool open(const std::string& path, int sampleRate) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            std::fprintf(stderr, "[OfflineAudioDevice] Cannot create output '%s'\n", path.c_str());
+            return false;
+        }
+
+        wav_ = endsWith(path, ".wav");
+        sampleRate_ = sampleRate;
+        if (wav_) {
+            // Placeholder, sizes are patched in close()
+            writeHeader();
+        }
+        return true;
+    }
+
+    void write(const int16_t* samples, size_t frames) {
+        if (file_) {
+            frames_ += std::fwrite(samples, sizeof(int16_t), frames, file_);
+        }
+    }
+
+    void close() {
+        if (!file_) {
+            return;
+        }
+        if (wav_) {
+            std::fseek(file_, 0, SEEK_SET);
+            writeHeader();
+        }
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    void writeHeader() {
+        uint32_t dataBytes = static_cast<uint32_t>(
+            std::min<uint64_t>(frames_ * sizeof(int16_t), 0xFFFFFFFFULL - kWavHeaderSize));
+
+        uint8_t header[kWavHeaderSize];
+        std::memcpy(header, "RIFF", 4);
+        writeLE32(header + 4, static_cast<uint32_t>(kWavHeaderSize - 8) + dataBytes);
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        writeLE32(header + 16, 16);
+        writeLE16(header + 20, 1);   // PCM
+        writeLE16(header + 22, 1);   // Mono
+        writeLE32(header + 24, static_cast<uint32_t>(sampleRate_));
+        writeLE32(header + 28, static_cast<uint32_t>(sampleRate_) * sizeof(int16_t));
+        writeLE16(header + 32, sizeof(int16_t));
+        writeLE16(header + 34, 16);
+        std::memcpy(header + 36, "data", 4);
+        writeLE32(header + 40, dataBytes);
+        std::fwrite(header, 1, sizeof(header), file_);
+    }
+
+    std::FILE* file_{nullptr};
+    bool wav_{false};
+    int sampleRate_{0};
+    uint64_t frames_{0};
+};
+
+// =============================================================================
+// OfflineEngine - AudioPipeline whose device is driven by OfflineAudioDevice
+// =============================================================================
+
+class OfflineEngine : public AudioPipeline {
+public:
+    OfflineEngine(const Config& config, int inputRate, int outputRate, bool synchronousTransmit)
+        : AudioPipeline(config) {
+        // Host time is the simulated clock in nanoseconds
+        setHostClockRate(1e9);
+        setDeviceSampleRates(inputRate, outputRate);
+
+        // Faster than real time the transmit worker would fall behind and
+        // drop frames; deliver each frame before simulated time moves on
+        setSynchronousTransmit(synchronousTransmit);
+    }
+
+    ~OfflineEngine() override {
+        shutdown();
+    }
+
+    void capture(int16_t* data, size_t frames, uint64_t hostTime) {
+        onCaptureAudio(data, frames, hostTime);
+    }
+
+    void playback(int16_t* data, size_t frames) {
+        onPlaybackAudio(data, frames);
+    }
+
+protected:
+    bool startDevice() override {
+        return true;
+    }
+};
+
+}  // namespace
+
+// =============================================================================
+// OfflineAudioDeviceImpl
+// =============================================================================
+
+class OfflineAudioDeviceImpl : public OfflineAudioDevice {
+public:
+    explicit OfflineAudioDeviceImpl(const Config& config);
+    ~OfflineAudioDeviceImpl() override;
+
+    bool open(const AudioEngine::Config& engineConfig);
+
+    AudioEngine& engine() override { return *engine_; }
+    bool run(double seconds) override;
+    double getSimulatedSeconds() const override;
+    double getCpuSeconds() const override { return cpuSeconds_; }
+    uint64_t getRenderedFrames() const override { return playbackFrames_; }
+    void close() override;
+
+private:
+    uint64_t captureDueNs() const;
+    uint64_t playbackDueNs() const;
+    void runCapture();
+    void runPlayback();
+
+    Config config_;
+    std::unique_ptr<OfflineEngine> engine_;
+    std::unique_ptr<PcmFileReader> reader_;
+    std::unique_ptr<PcmFileWriter> writer_;
+
+    std::vector<int16_t> captureBuffer_;
+    std::vector<int16_t> playbackBuffer_;
+
+    // Simulated clock: device positions in frames at each side's rate
+    uint64_t captureFrames_{0};
+    uint64_t playbackFrames_{0};
+    uint64_t simulatedNs_{0};
+    bool paced_{false};                                  // wallOrigin_ is set
+    std::chrono::steady_clock::time_point wallOrigin_;   // Wall time of simulated time 0
+    bool inputExhausted_{false};
+
+    double cpuSeconds_{0.0};
+};
+
+std::unique_ptr<OfflineAudioDevice> OfflineAudioDevice::create(const Config& config,
+                                                               const AudioEngine::Config& engineConfig) {
+    auto device = std::make_unique<OfflineAudioDeviceImpl>(config);
+    if (!device->open(engineConfig)) {
+        return nullptr;
+    }
+    return device;
+}
+
+OfflineAudioDeviceImpl::OfflineAudioDeviceImpl(const Config& config)
+    : config_(config) {
+    config_.framesPerCallback = std::max<size_t>(config_.framesPerCallback, 1);
+    captureBuffer_.resize(config_.framesPerCallback);
+    playbackBuffer_.resize(config_.framesPerCallback);
+}
+
+OfflineAudioDeviceImpl::~OfflineAudioDeviceImpl() {
+    engine_.reset();
+    close();
+}
+
+bool OfflineAudioDeviceImpl::open(const AudioEngine::Config& engineConfig) {
+    if (!config_.inputPath.empty()) {
+        reader_ = std::make_unique<PcmFileReader>();
+        if (!reader_->open(config_.inputPath, config_.inputSampleRate)) {
+            return false;
+        }
+    }
+
+    if (config_.inputSampleRate <= 0 || config_.outputSampleRate <= 0) {
+        std::fprintf(stderr, "[OfflineAudioDevice] Invalid sample rate\n");
+        return false;
+    }
+
+    if (!config_.outputPath.empty()) {
+        writer_ = std::make_unique<PcmFileWriter>();
+        if (!writer_->open(config_.outputPath, config_.outputSampleRate)) {
+            return false;
+        }
+    }
+
+    AudioEngine::Config pipelineConfig = engineConfig;
+    pipelineConfig.framesPerBuffer = static_cast<int>(config_.framesPerCallback);
+    if (!config_.realtime) {
+        // The render-ahead worker runs on the wall clock, which would make
+        // the mix depend on scheduling
+        pipelineConfig.renderAheadMs = 0;
+    }
+
+    engine_ = std::make_unique<OfflineEngine>(pipelineConfig,
+                                              config_.inputSampleRate,
+                                              config_.outputSampleRate,
+                                              !config_.realtime);
+    return true;
+}
+
+uint64_t OfflineAudioDeviceImpl::captureDueNs() const {
+    // A callback is due once its last frame has been "recorded"
+    return (captureFrames_ + config_.framesPerCallback) * kNanosPerSecond /
+           static_cast<uint64_t>(config_.inputSampleRate);
+}
+
+uint64_t OfflineAudioDeviceImpl::playbackDueNs() const {
+    return playbackFrames_ * kNanosPerSecond / static_cast<uint64_t>(config_.outputSampleRate);
+}
+
+bool OfflineAudioDeviceImpl::run(double seconds) {
+    using Clock = std::chrono::steady_clock;
+
+    const uint64_t targetNs = simulatedNs_ + static_cast<uint64_t>(std::max(seconds, 0.0) * 1e9);
+    const Clock::time_point start = Clock::now();
+    const double cpuStart = processCpuSeconds();
+    if (!paced_) {
+        // Anchor once: run() steps with no callback due must not restart the clock
+        paced_ = true;
+        wallOrigin_ = start - std::chrono::nanoseconds(simulatedNs_);
+    }
+
+    while (true) {
+        uint64_t captureDue = captureDueNs();
+        uint64_t playbackDue = playbackDueNs();
+        uint64_t due = std::min(captureDue, playbackDue);
+        if (due > targetNs) {
+            break;
+        }
+
+        if (config_.realtime) {
+            Clock::time_point wake = wallOrigin_ + std::chrono::nanoseconds(due);
+            if (wake > Clock::now()) {
+                std::this_thread::sleep_until(wake);
+            }
+        }
+
+        // Input before output at equal times, like a duplex I/O unit
+        if (captureDue <= playbackDue) {
+            runCapture();
+        } else {
+            runPlayback();
+        }
+    }
+
+    simulatedNs_ = targetNs;
+    cpuSeconds_ += processCpuSeconds() - cpuStart;
+    return !inputExhausted_;
+}
+
+void OfflineAudioDeviceImpl::runCapture() {
+    const size_t frames = config_.framesPerCallback;
+    size_t filled = 0;
+
+    while (reader_ && filled < frames) {
+        size_t count = reader_->read(captureBuffer_.data() + filled, frames - filled);
+        filled += count;
+        if (count == 0) {
+            if (!config_.loopInput || reader_->empty()) {
+                inputExhausted_ = true;
+                break;
+            }
+            reader_->rewind();
+        }
+    }
+
+    // Silence past the end of the input keeps the clock running
+    std::fill(captureBuffer_.begin() + static_cast<std::ptrdiff_t>(filled), captureBuffer_.end(), 0);
+
+    uint64_t hostTime = kClockEpochNs + captureFrames_ * kNanosPerSecond /
+                        static_cast<uint64_t>(config_.inputSampleRate);
+    captureFrames_ += frames;
+
+    engine_->capture(captureBuffer_.data(), frames, hostTime);
+}
+
+void OfflineAudioDeviceImpl::runPlayback() {
+    const size_t frames = config_.framesPerCallback;
+
+    engine_->playback(playbackBuffer_.data(), frames);
+    playbackFrames_ += frames;
+
+    if (writer_) {
+        writer_->write(playbackBuffer_.data(), frames);
+    }
+}
+
+double OfflineAudioDeviceImpl::getSimulatedSeconds() const {
+    return static_cast<double>(simulatedNs_) / 1e9;
+}
+
+void OfflineAudioDeviceImpl::close() {
+    if (writer_) {
+        writer_->close();
+    }
+}
+
+}  // namespace sayses
@@ -0,0 +1,94 @@
+/**
+ * Offline Audio Device
+ * File-backed virtual audio device that drives an AudioEngine on a simulated clock
+ * Used for throughput benchmarks and bit-exact regression runs without audio hardware
+ */
+
+#pragma once
+
+#include "audio_engine.h"
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace sayses {
+
+/**
+ * Virtual duplex device around a full AudioEngine pipeline.
+ * Capture input is read from a WAV or raw PCM file (or silence), the
+ * rendered playback is written to a WAV or raw PCM file (or discarded).
+ *
+ * Nothing runs on its own: run() issues the device callbacks on the calling
+ * thread in simulated-time order, either as fast as possible or paced to
+ * real time. With pacing off, captured frames reach the capture callback on
+ * the calling thread too, so the output depends only on the inputs and the
+ * calls made between run() steps and runs are bit-exact and repeatable.
+ *
+ * Threading: run() and the engine's app-side methods (addUserAudio etc.)
+ * must be called from the same thread.
+ */
+class OfflineAudioDevice {
+public:
+    struct Config {
+        std::string inputPath;           // WAV or raw s16le mono; empty = silence
+        std::string outputPath;          // .wav gets a WAV header, anything else raw s16le; empty = discard
+        int inputSampleRate = 48000;     // Capture rate (taken from the header for WAV input)
+        int outputSampleRate = 48000;    // Playback rate
+        size_t framesPerCallback = 480;  // Device callback size, e.g. 256, 512, 1024
+        bool realtime = false;           // Pace callbacks to the wall clock
+        bool loopInput = false;          // Restart the input file at its end
+    };
+
+    /**
+     * Create an offline device and its engine.
+     * AudioEngine::Config::framesPerBuffer is replaced by framesPerCallback.
+     * Render-ahead is only honored in real-time mode.
+     * @return nullptr if the input or output file cannot be opened
+     */
+    static std::unique_ptr<OfflineAudioDevice> create(const Config& config,
+                                                      const AudioEngine::Config& engineConfig);
+
+    virtual ~OfflineAudioDevice() = default;
+
+    /**
+     * The engine driven by this device. Start capture/playback on it as usual.
+     */
+    virtual AudioEngine& engine() = 0;
+
+    /**
+     * Advance the simulated clock, issuing every capture and playback
+     * callback that falls due. Capture frames are handed to the capture
+     * callback before run() returns.
+     * @param seconds Simulated time to advance
+     * @return false once the input file is exhausted (never with loopInput)
+     */
+    virtual bool run(double seconds) = 0;
+
+    /**
+     * Simulated time since creation, in seconds.
+     */
+    virtual double getSimulatedSeconds() const = 0;
+
+    /**
+     * Process CPU time spent inside run() (CLOCK_PROCESS_CPUTIME_ID), so
+     * work on the engine's worker threads counts and pacing sleeps don't.
+     */
+    virtual double getCpuSeconds() const = 0;
+
+    /**
+     * Total frames written to the output (at outputSampleRate).
+     */
+    virtual uint64_t getRenderedFrames() const = 0;
+
+    /**
+     * Flush and close the output file (also done on destruction).
+     */
+    virtual void close() = 0;
+
+protected:
+    OfflineAudioDevice() = default;
+};
+
+}  // namespace sayses
@@ -0,0 +1,402 @@
+/**
+ * Offline Engine Benchmark
+ * Runs the full AudioEngine pipeline on OfflineAudioDevice's simulated clock.
+ *
+ * Throughput mode (default) mixes N talkers plus the capture path and reports
+ * how many talkers one CPU could mix in real time, from process CPU time.
+ *
+ * Golden mode (--golden=PATH) runs a fixed scene (three talkers, one of them
+ * a priority speaker, speech on the microphone, echo cancellation on) and
+ * compares a per-second FNV-1a hash of the capture frames and of the
+ * playback output with PATH. Any change to the processed audio, down to one
+ * bit, fails the run; --update-golden=1 rewrites PATH after an intended
+ * change. Float kernels differ between SIMD paths (and speexdsp builds), so
+ * each architecture keeps its own golden file.
+ *
+ * Usage: SaysesOfflineBench [--key=value ...], see printUsage().
+ */
+
+#include "bench_signal.h"
+#include "offline_audio_device.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace sayses {
+namespace bench {
+namespace {
+
+constexpr double kStepSeconds = 0.01;       // Talkers deliver one 10ms frame per step
+constexpr size_t kTalkerLoopSamples = kSampleRate * 2;
+constexpr int kGoldenSeconds = 5;
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+struct Options {
+    std::vector<int> talkers{1, 4, 16, 64};
+    int seconds = 20;
+    std::string goldenPath;
+    bool updateGolden = false;
+    std::string outputPath = "SaysesOfflineBench.raw";
+};
+
+// =============================================================================
+// Talkers
+// =============================================================================
+
+/**
+ * Looping speech for one remote user, handed to the engine 10ms at a time
+ * like the app's decoder does.
+ */
+class Talker {
+public:
+    Talker(uint32_t userId)
+        : userId_(userId)
+        , speech_(makeSpeech(kTalkerLoopSamples, kSampleRate, userId)) {
+    }
+
+    void deliver(AudioEngine& engine) {
+        engine.addUserAudio(userId_, speech_.data() + position_, kFrameSize, sequence_++);
+        position_ = (position_ + kFrameSize) % speech_.size();
+    }
+
+private:
+    uint32_t userId_;
+    std::vector<int16_t> speech_;
+    size_t position_{0};
+    int64_t sequence_{0};
+};
+
+// =============================================================================
+// Throughput
+// =============================================================================
+
+double processCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Total CPU covers the talkers' addUserAudio() calls as well as the device
+ * callbacks in run(); talkers per CPU-second is derived from the total.
+ */
+bool runThroughput(const Options& options) {
+    std::printf("%8s %8s %12s %12s %12s %15s\n",
+                "talkers", "sim s", "run() CPU s", "total CPU s", "x realtime", "talkers/CPU-s");
+
+    for (int count : options.talkers) {
+        OfflineAudioDevice::Config deviceConfig;  // Silent microphone, output discarded
+        AudioEngine::Config engineConfig;
+        auto device = OfflineAudioDevice::create(deviceConfig, engineConfig);
+        if (!device) {
+            return false;
+        }
+
+        AudioEngine& engine = device->engine();
+        engine.startCapture([](const int16_t*, size_t) {});
+        engine.startMixedPlayback();
+
+        std::vector<Talker> talkers;
+        for (int i = 0; i < count; i++) {
+            talkers.emplace_back(static_cast<uint32_t>(i + 1));
+        }
+
+        const int steps = static_cast<int>(options.seconds / kStepSeconds);
+        double cpuStart = processCpuSeconds();
+        for (int step = 0; step < steps; step++) {
+            for (Talker& talker : talkers) {
+                talker.deliver(engine);
+            }
+            device->run(kStepSeconds);
+        }
+        double total = std::max(processCpuSeconds() - cpuStart, 1e-9);
+
+        engine.stopCapture();
+        engine.stopPlayback();
+
+        double simulated = device->getSimulatedSeconds();
+        std::printf("%8d %8.1f %12.3f %12.3f %12.1f %15.1f\n",
+                    count, simulated, device->getCpuSeconds(), total,
+                    simulated / total, count * simulated / total);
+    }
+    return true;
+}
+
+// =============================================================================
+// Golden output
+// =============================================================================
+
+/**
+ * FNV-1a 64 over int16 samples in little-endian byte order, one hash per
+ * second of audio.
+ */
+class SecondHasher {
+public:
+    explicit SecondHasher(size_t samplesPerSecond)
+        : samplesPerSecond_(samplesPerSecond) {
+    }
+
+    void add(const int16_t* samples, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            uint16_t value = static_cast<uint16_t>(samples[i]);
+            hash_ = (hash_ ^ (value & 0xff)) * kFnvPrime;
+            hash_ = (hash_ ^ (value >> 8)) * kFnvPrime;
+            if (++filled_ == samplesPerSecond_) {
+                hashes_.push_back(hash_);
+                hash_ = kFnvOffset;
+                filled_ = 0;
+            }
+        }
+    }
+
+    const std::vector<uint64_t>& hashes() const { return hashes_; }
+
+private:
+    size_t samplesPerSecond_;
+    size_t filled_{0};
+    uint64_t hash_{kFnvOffset};
+    std::vector<uint64_t> hashes_;
+};
+
+struct GoldenRun {
+    std::vector<uint64_t> capture;
+    std::vector<uint64_t> playback;
+};
+
+bool renderGoldenScene(const Options& options, GoldenRun& run) {
+    // Microphone: the local user talking over the remote mix
+    const std::string inputPath = options.outputPath + ".in.raw";
+    {
+        std::vector<int16_t> mic = makeSpeech(kSampleRate * kGoldenSeconds, kSampleRate, 42);
+        std::FILE* file = std::fopen(inputPath.c_str(), "wb");
+        if (!file) {
+            std::fprintf(stderr, "Cannot write %s\n", inputPath.c_str());
+            return false;
+        }
+        std::fwrite(mic.data(), sizeof(int16_t), mic.size(), file);
+        std::fclose(file);
+    }
+
+    OfflineAudioDevice::Config deviceConfig;
+    deviceConfig.inputPath = inputPath;
+    deviceConfig.outputPath = options.outputPath;
+    deviceConfig.framesPerCallback = 256;  // Not a multiple of the frame: exercises the FIFOs
+    AudioEngine::Config engineConfig;
+    engineConfig.echoCancellation = true;
+
+    auto device = OfflineAudioDevice::create(deviceConfig, engineConfig);
+    if (!device) {
+        return false;
+    }
+
+    AudioEngine& engine = device->engine();
+    SecondHasher captureHasher(kSampleRate);
+    engine.startCapture([&captureHasher](const int16_t* data, size_t frames,
+                                         const AudioEngine::CaptureTimestamp&) {
+        captureHasher.add(data, frames);
+    });
+    engine.startMixedPlayback();
+
+    std::vector<Talker> talkers;
+    for (uint32_t userId = 1; userId <= 3; userId++) {
+        talkers.emplace_back(userId);
+    }
+    engine.setUserVolume(2, 0.5f);
+    engine.setUserPrioritySpeaker(3, true);
+
+    const int steps = static_cast<int>(kGoldenSeconds / kStepSeconds);
+    for (int step = 0; step < steps; step++) {
+        // Priority speaker joins after 2s, so the ducking ramp is covered
+        for (size_t i = 0; i < talkers.size(); i++) {
+            if (i < 2 || step >= 200) {
+                talkers[i].deliver(engine);
+            }
+        }
+        device->run(kStepSeconds);
+    }
+
+    engine.stopCapture();
+    engine.stopPlayback();
+    device->close();
+    std::remove(inputPath.c_str());
+
+    // Hash what actually reached the output file
+    SecondHasher playbackHasher(static_cast<size_t>(deviceConfig.outputSampleRate));
+    std::FILE* file = std::fopen(options.outputPath.c_str(), "rb");
+    if (!file) {
+        std::fprintf(stderr, "Cannot read %s\n", options.outputPath.c_str());
+        return false;
+    }
+    std::vector<int16_t> block(4096);
+    size_t count;
+    while ((count = std::fread(block.data(), sizeof(int16_t), block.size(), file)) > 0) {
+        playbackHasher.add(block.data(), count);
+    }
+    std::fclose(file);
+
+    run.capture = captureHasher.hashes();
+    run.playback = playbackHasher.hashes();
+    return true;
+}
+
+bool writeGolden(const std::string& path, const GoldenRun& run) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+    std::fprintf(file, "# SaysesOfflineBench golden scene: FNV-1a 64 per second of int16 audio\n");
+    std::fprintf(file, "# Regenerate with: SaysesOfflineBench --golden=<this file> --update-golden=1\n");
+    for (size_t i = 0; i < run.capture.size(); i++) {
+        std::fprintf(file, "capture %zu %016" PRIx64 "\n", i, run.capture[i]);
+    }
+    for (size_t i = 0; i < run.playback.size(); i++) {
+        std::fprintf(file, "playback %zu %016" PRIx64 "\n", i, run.playback[i]);
+    }
+    std::fclose(file);
+    return true;
+}
+
+bool readGolden(const std::string& path, GoldenRun& golden) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+        return false;
+    }
+    char line[256];
+    while (std::fgets(line, sizeof(line), file)) {
+        char stream[16];
+        size_t second;
+        uint64_t hash;
+        if (line[0] == '#' || std::sscanf(line, "%15s %zu %" SCNx64, stream, &second, &hash) != 3) {
+            continue;
+        }
+        std::vector<uint64_t>& hashes = std::strcmp(stream, "capture") == 0 ? golden.capture : golden.playback;
+        if (hashes.size() <= second) {
+            hashes.resize(second + 1);
+        }
+        hashes[second] = hash;
+    }
+    std::fclose(file);
+    return true;
+}
+
+bool compareStream(const char* name, const std::vector<uint64_t>& expected,
+                   const std::vector<uint64_t>& actual) {
+    if (expected.size() != actual.size()) {
+        std::printf("%s: %zu seconds, golden has %zu\n", name, actual.size(), expected.size());
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (expected[i] != actual[i]) {
+            std::printf("%s: first difference in second %zu (%016" PRIx64 ", golden %016" PRIx64 ")\n",
+                        name, i, actual[i], expected[i]);
+            return false;
+        }
+    }
+    std::printf("%s: %zu seconds bit-exact\n", name, actual.size());
+    return true;
+}
+
+bool runGolden(const Options& options) {
+    GoldenRun run;
+    if (!renderGoldenScene(options, run)) {
+        return false;
+    }
+
+    if (options.updateGolden) {
+        if (!writeGolden(options.goldenPath, run)) {
+            return false;
+        }
+        std::printf("Wrote %s\n", options.goldenPath.c_str());
+        return true;
+    }
+
+    GoldenRun golden;
+    if (!readGolden(options.goldenPath, golden)) {
+        return false;
+    }
+    bool captureOk = compareStream("capture", golden.capture, run.capture);
+    bool playbackOk = compareStream("playback", golden.playback, run.playback);
+    return captureOk && playbackOk;
+}
+
+// =============================================================================
+// Options
+// =============================================================================
+
+void printUsage() {
+    std::printf(
+        "Usage: SaysesOfflineBench [options]\n"
+        "  --talkers=A,B,..        Talker counts to measure (default 1,4,16,64)\n"
+        "  --seconds=N             Simulated seconds per measurement (default 20)\n"
+        "  --golden=PATH           Compare the golden scene with PATH instead\n"
+        "  --update-golden=1       With --golden: rewrite PATH from this build\n"
+        "  --output=PATH           Scratch playback file (default SaysesOfflineBench.raw)\n");
+}
+
+std::vector<int> parseList(const char* value) {
+    std::vector<int> list;
+    const char* p = value;
+    while (*p) {
+        char* end = nullptr;
+        long v = std::strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        list.push_back(static_cast<int>(v));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return list;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || !eq) {
+            return false;
+        }
+        std::string key(arg + 2, eq);
+        const char* value = eq + 1;
+
+        if (key == "talkers") {
+            options.talkers = parseList(value);
+        } else if (key == "seconds") {
+            options.seconds = std::max(1, std::atoi(value));
+        } else if (key == "golden") {
+            options.goldenPath = value;
+        } else if (key == "update-golden") {
+            options.updateGolden = std::atoi(value) != 0;
+        } else if (key == "output") {
+            options.outputPath = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.talkers.empty();
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace sayses
+
+int main(int argc, char** argv) {
+    using namespace sayses::bench;
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    bool ok = options.goldenPath.empty() ? runThroughput(options) : runGolden(options);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,622 @@
+/**
+ * Playout Quality Benchmark
+ * Feeds an Opus stream through NetworkImpairment into the receive stack and
+ * measures what the listener gets: playout delay, late loss, concealment,
+ * underruns/overruns and segmental SNR against the clean reference.
+ *
+ * Everything runs on a simulated clock in one thread, so a given seed and
+ * parameter set always produces the same numbers. Opus is not waveform
+ * preserving, so segmental SNR is only meaningful relative to the
+ * codec-only figure printed in the header.
+ *
+ * Usage: SaysesPlayoutBench [--key=value ...], see printUsage().
+ * --min-buffer-ms and --max-buffer-ms accept comma-separated lists; every
+ * combination is run against the same packet fates.
+ */
+
+#include "bench_signal.h"
+#include "network_impairment.h"
+#include "codec.h"
+#include "jitter_buffer.h"
+#include "user_audio_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace sayses {
+namespace bench {
+namespace {
+
+constexpr double kFrameMs = 10.0;
+constexpr double kSamplesPerMs = kSampleRate / 1000.0;
+constexpr double kRenderPhaseMs = 3.0;      // Render ticks are not aligned with packet sends
+constexpr double kSegSnrFloorDb = -10.0;    // Usual segmental SNR clamping
+constexpr double kSegSnrCeilDb = 35.0;
+constexpr size_t kMaxPacketSize = 4000;
+
+enum class Receiver {
+    App,     // Decode on arrival into UserAudioBuffer (what AudioEngine does)
+    Jitter   // Sequence-ordered JitterBuffer with Opus PLC on gaps
+};
+
+struct Options {
+    Receiver receiver = Receiver::App;
+    int seconds = 60;
+    int complexity = 5;
+    std::vector<int> minBufferMs{60};
+    std::vector<int> maxBufferMs{200};
+    NetworkImpairment::Config network;
+    std::string jsonPath;
+};
+
+struct Result {
+    int minBufferMs = 0;
+    int maxBufferMs = 0;
+
+    NetworkImpairment::Stats network;
+    uint64_t arrivals = 0;
+    uint64_t lateArrivals = 0;   // Arrived after a later packet was already played/decoded
+
+    uint64_t outputSamples = 0;     // Since playback first started
+    uint64_t concealedSamples = 0;  // Silence or PLC while playback was running
+    uint32_t underruns = 0;
+    uint32_t overruns = 0;
+
+    double delayMeanMs = 0.0;
+    double delayP50Ms = 0.0;
+    double delayP95Ms = 0.0;
+    double delayMaxMs = 0.0;
+    double segSnrDb = 0.0;
+};
+
+// =============================================================================
+// Reference stream
+// =============================================================================
+
+struct Stream {
+    std::vector<int16_t> reference;               // Clean input
+    std::vector<std::vector<uint8_t>> packets;    // One Opus packet per 10ms frame
+    int codecDelay = 0;                           // Decoder output lag in samples
+    double codecSegSnrDb = 0.0;                   // Ceiling: codec alone, no network
+};
+
+double segmentSnr(const int16_t* reference, const float* output, size_t samples) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        double r = reference[i];
+        double e = r - output[i];
+        signal += r * r;
+        noise += e * e;
+    }
+    double snr = 10.0 * std::log10((signal + 1e-9) / (noise + 1e-9));
+    return std::min(std::max(snr, kSegSnrFloorDb), kSegSnrCeilDb);
+}
+
+Stream buildStream(const Options& options) {
+    Stream stream;
+    size_t frames = static_cast<size_t>(options.seconds) * 100;
+    stream.reference = makeSpeech(frames * kFrameSize);
+
+    Codec::Config config;
+    config.complexity = options.complexity;
+    auto encoder = Codec::createOpus(config);
+    auto decoder = Codec::createOpus(config);
+
+    std::vector<int16_t> decoded;
+    decoded.reserve(stream.reference.size());
+    uint8_t packet[kMaxPacketSize];
+    int16_t pcm[kFrameSize];
+
+    for (size_t f = 0; f < frames; f++) {
+        int bytes = encoder->encode(stream.reference.data() + f * kFrameSize, kFrameSize,
+                                    packet, kMaxPacketSize);
+        stream.packets.emplace_back(packet, packet + std::max(bytes, 0));
+
+        int samples = decoder->decode(packet, static_cast<size_t>(std::max(bytes, 0)), pcm, kFrameSize);
+        decoded.insert(decoded.end(), pcm, pcm + std::max(samples, 0));
+    }
+
+    // Find the codec delay by cross-correlation over the first second
+    const size_t window = std::min<size_t>(kSampleRate, decoded.size() / 2);
+    double best = -1e300;
+    for (int lag = 0; lag < static_cast<int>(kFrameSize) * 2; lag++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < window; i++) {
+            sum += static_cast<double>(stream.reference[i]) * decoded[i + lag];
+        }
+        if (sum > best) {
+            best = sum;
+            stream.codecDelay = lag;
+        }
+    }
+
+    // Codec-only quality, the best any receiver can do
+    double total = 0.0;
+    size_t segments = 0;
+    std::vector<float> output(kFrameSize);
+    for (size_t pos = stream.codecDelay; pos + kFrameSize <= decoded.size(); pos += kFrameSize) {
+        for (size_t i = 0; i < kFrameSize; i++) {
+            output[i] = decoded[pos + i];
+        }
+        total += segmentSnr(stream.reference.data() + pos - stream.codecDelay, output.data(), kFrameSize);
+        segments++;
+    }
+    stream.codecSegSnrDb = segments > 0 ? total / segments : 0.0;
+    return stream;
+}
+
+// =============================================================================
+// Simulation
+// =============================================================================
+
+struct Arrival {
+    double timeMs;
+    uint32_t sequence;
+};
+
+std::vector<Arrival> scheduleArrivals(const Options& options, size_t packets,
+                                      NetworkImpairment::Stats& stats) {
+    NetworkImpairment network(options.network);
+    std::vector<Arrival> arrivals;
+    std::vector<double> times;
+
+    for (size_t seq = 0; seq < packets; seq++) {
+        // A packet leaves once its whole frame has been captured
+        network.transmit((seq + 1) * kFrameMs, times);
+        for (double t : times) {
+            arrivals.push_back({t, static_cast<uint32_t>(seq)});
+        }
+    }
+
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const Arrival& a, const Arrival& b) { return a.timeMs < b.timeMs; });
+    stats = network.getStats();
+    return arrivals;
+}
+
+/**
+ * Tracks where each played sample came from, to derive delay and SNR.
+ */
+class PlayoutMeter {
+public:
+    PlayoutMeter(const Stream& stream, Result& result)
+        : stream_(stream), result_(result) {}
+
+    /**
+     * Account one render tick.
+     * @param sources Decoded-stream position of each sample, or -1 if concealed
+     */
+    void frame(double tickMs, const float* output, const int64_t* sources, size_t samples) {
+        bool anyReal = false;
+        for (size_t i = 0; i < samples; i++) {
+            anyReal |= sources[i] >= 0;
+        }
+        if (!anyReal && (!started_ || lastPosition_ + 1 >= end())) {
+            return;  // Prebuffering or the stream is over: not a quality problem
+        }
+        started_ = true;
+
+        float reference[kFrameSize];
+        int16_t ref16[kFrameSize];
+        bool haveDelay = false;
+
+        for (size_t i = 0; i < samples; i++) {
+            int64_t position = sources[i];
+            if (position >= 0) {
+                lastPosition_ = position;
+                if (!haveDelay) {
+                    // Capture time of the sample vs. when it is heard
+                    double capturedMs = (position - stream_.codecDelay) / kSamplesPerMs;
+                    delays_.push_back(tickMs + i / kSamplesPerMs - capturedMs);
+                    haveDelay = true;
+                }
+            } else {
+                // Concealment stands in for the samples that should follow
+                lastPosition_++;
+                result_.concealedSamples++;
+            }
+
+            int64_t index = lastPosition_ - stream_.codecDelay;
+            bool valid = index >= 0 && index < static_cast<int64_t>(stream_.reference.size());
+            ref16[i] = valid ? stream_.reference[static_cast<size_t>(index)] : 0;
+            reference[i] = output[i];
+        }
+
+        result_.outputSamples += samples;
+        snrTotal_ += segmentSnr(ref16, reference, samples);
+        snrSegments_++;
+    }
+
+    void finish() {
+        if (!delays_.empty()) {
+            std::vector<double> sorted = delays_;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (double d : sorted) {
+                sum += d;
+            }
+            result_.delayMeanMs = sum / sorted.size();
+            result_.delayP50Ms = sorted[sorted.size() / 2];
+            result_.delayP95Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+            result_.delayMaxMs = sorted.back();
+        }
+        result_.segSnrDb = snrSegments_ > 0 ? snrTotal_ / snrSegments_ : kSegSnrFloorDb;
+    }
+
+private:
+    int64_t end() const {
+        return static_cast<int64_t>(stream_.packets.size() * kFrameSize);
+    }
+
+    const Stream& stream_;
+    Result& result_;
+    bool started_{false};
+    int64_t lastPosition_{-1};
+    std::vector<double> delays_;
+    double snrTotal_{0.0};
+    size_t snrSegments_{0};
+};
+
+// Production path: decode in arrival order, append to the per-user buffer
+void runApp(const Options& options, const Stream& stream, const std::vector<Arrival>& arrivals,
+            double endMs, Result& result) {
+    UserAudioBuffer::Config config;
+    config.minBufferMs = result.minBufferMs;
+    config.maxBufferMs = result.maxBufferMs;
+    auto buffer = UserAudioBuffer::create(1, config);
+
+    Codec::Config codecConfig;
+    codecConfig.complexity = options.complexity;
+    auto decoder = Codec::createOpus(codecConfig);
+
+    // Decoded samples in buffer order: which packet each run came from
+    struct Chunk {
+        uint64_t start;   // Position in the buffer's write stream
+        uint32_t sequence;
+        size_t frames;
+    };
+    std::deque<Chunk> chunks;
+    uint64_t written = 0;
+    int64_t highestDecoded = -1;
+
+    PlayoutMeter meter(stream, result);
+    std::vector<float> output(kFrameSize);
+    std::vector<int64_t> sources(kFrameSize);
+    int16_t pcm[kFrameSize];
+    size_t next = 0;
+
+    for (double tick = kRenderPhaseMs; tick < endMs; tick += kFrameMs) {
+        for (; next < arrivals.size() && arrivals[next].timeMs <= tick; next++) {
+            uint32_t seq = arrivals[next].sequence;
+            result.arrivals++;
+            if (static_cast<int64_t>(seq) <= highestDecoded) {
+                result.lateArrivals++;
+            }
+            highestDecoded = std::max<int64_t>(highestDecoded, seq);
+
+            const auto& packet = stream.packets[seq];
+            int samples = decoder->decode(packet.data(), packet.size(), pcm, kFrameSize);
+            if (samples <= 0) {
+                continue;
+            }
+            buffer->addSamples(pcm, static_cast<size_t>(samples), seq);
+            chunks.push_back({written, seq, static_cast<size_t>(samples)});
+            written += static_cast<uint64_t>(samples);
+        }
+
+        size_t read = buffer->readFloat(output.data(), kFrameSize);
+
+        // Samples leave the buffer only from the front (reads and overflow
+        // drops), so the read ones end where the remaining ones begin
+        uint64_t remaining = buffer->getStats().currentBufferSize;
+        uint64_t first = written - remaining - read;
+        for (size_t i = 0; i < kFrameSize; i++) {
+            sources[i] = -1;
+            if (i >= read) {
+                continue;
+            }
+            uint64_t position = first + i;
+            while (!chunks.empty() && chunks.front().start + chunks.front().frames <= position) {
+                chunks.pop_front();
+            }
+            if (!chunks.empty() && chunks.front().start <= position) {
+                const Chunk& chunk = chunks.front();
+                sources[i] = static_cast<int64_t>(chunk.sequence) * kFrameSize +
+                             static_cast<int64_t>(position - chunk.start);
+            }
+        }
+
+        for (size_t i = 0; i < kFrameSize; i++) {
+            output[i] *= 32768.0f;
+        }
+        meter.frame(tick, output.data(), sources.data(), kFrameSize);
+    }
+
+    UserAudioBuffer::Stats stats = buffer->getStats();
+    result.underruns = stats.bufferUnderruns;
+    result.overruns = stats.bufferOverruns;
+    meter.finish();
+}
+
+// Reference path: sequence-ordered JitterBuffer, Opus PLC for missing frames
+void runJitter(const Options& options, const Stream& stream, const std::vector<Arrival>& arrivals,
+               double endMs, Result& result) {
+    JitterBuffer::Config config;
+    config.minDelayMs = result.minBufferMs;
+    config.maxDelayMs = result.maxBufferMs;
+    auto jitter = JitterBuffer::create(config);
+
+    Codec::Config codecConfig;
+    codecConfig.complexity = options.complexity;
+    auto decoder = Codec::createOpus(codecConfig);
+
+    PlayoutMeter meter(stream, result);
+    std::vector<float> output(kFrameSize);
+    std::vector<int64_t> sources(kFrameSize);
+    int16_t pcm[kFrameSize];
+    bool playing = false;
+    size_t next = 0;
+
+    for (double tick = kRenderPhaseMs; tick < endMs; tick += kFrameMs) {
+        for (; next < arrivals.size() && arrivals[next].timeMs <= tick; next++) {
+            uint32_t seq = arrivals[next].sequence;
+            result.arrivals++;
+
+            const auto& packet = stream.packets[seq];
+            int samples = decoder->decode(packet.data(), packet.size(), pcm, kFrameSize);
+            if (samples > 0) {
+                jitter->put(pcm, static_cast<size_t>(samples), seq, seq * kFrameSize);
+            }
+        }
+
+        size_t got = jitter->get(pcm, kFrameSize);
+        int64_t sequence = jitter->getStats().lastPlayedSequence;
+
+        if (got > 0) {
+            playing = true;
+            for (size_t i = 0; i < kFrameSize; i++) {
+                sources[i] = i < got ? sequence * static_cast<int64_t>(kFrameSize) + static_cast<int64_t>(i) : -1;
+            }
+        } else {
+            if (playing) {
+                result.underruns++;
+                decoder->decodePLC(pcm, kFrameSize);
+            }
+            std::fill(sources.begin(), sources.end(), -1);
+        }
+
+        for (size_t i = 0; i < kFrameSize; i++) {
+            output[i] = pcm[i];
+        }
+        meter.frame(tick, output.data(), sources.data(), kFrameSize);
+    }
+
+    result.lateArrivals = static_cast<uint64_t>(jitter->getStats().packetsLate);
+    meter.finish();
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+double percent(uint64_t part, uint64_t whole) {
+    return whole > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+}
+
+void printResult(const Result& r) {
+    std::printf("%6d %6d | %6.2f %6.2f %6.2f | %7.2f %7.2f %7.2f %7.2f | %7.2f %6u %6u | %6.2f\n",
+                r.minBufferMs, r.maxBufferMs,
+                percent(r.network.lost, r.network.sent),
+                percent(r.lateArrivals, r.network.sent),
+                percent(r.concealedSamples, r.outputSamples),
+                r.delayMeanMs, r.delayP50Ms, r.delayP95Ms, r.delayMaxMs,
+                r.segSnrDb, r.underruns, r.overruns,
+                percent(r.network.duplicated, r.network.sent));
+}
+
+bool writeJson(const std::string& path, const Options& options, const Stream& stream,
+               const std::vector<Result>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    const auto& n = options.network;
+    std::fprintf(file, "{\n  \"receiver\": \"%s\",\n  \"seconds\": %d,\n  \"seed\": %llu,\n",
+                 options.receiver == Receiver::App ? "app" : "jitter", options.seconds,
+                 static_cast<unsigned long long>(n.seed));
+    std::fprintf(file, "  \"network\": {\"base_delay_ms\": %g, \"jitter_ms\": %g, \"burst_p\": %g, "
+                       "\"burst_r\": %g, \"loss_good\": %g, \"loss_bad\": %g, \"reorder\": %g, "
+                       "\"reorder_ms\": %g, \"duplicate\": %g},\n",
+                 n.baseDelayMs, n.jitterMs, n.burstP, n.burstR, n.lossGood, n.lossBad,
+                 n.reorderProbability, n.reorderDelayMs, n.duplicateProbability);
+    std::fprintf(file, "  \"codec_seg_snr_db\": %.3f,\n  \"results\": [\n", stream.codecSegSnrDb);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::fprintf(file,
+                     "    {\"min_buffer_ms\": %d, \"max_buffer_ms\": %d, \"sent\": %llu, \"lost\": %llu, "
+                     "\"duplicated\": %llu, \"late_loss_rate\": %.6f, \"concealment_ratio\": %.6f, "
+                     "\"underruns\": %u, \"overruns\": %u, \"delay_mean_ms\": %.3f, \"delay_p50_ms\": %.3f, "
+                     "\"delay_p95_ms\": %.3f, \"delay_max_ms\": %.3f, \"seg_snr_db\": %.3f}%s\n",
+                     r.minBufferMs, r.maxBufferMs,
+                     static_cast<unsigned long long>(r.network.sent),
+                     static_cast<unsigned long long>(r.network.lost),
+                     static_cast<unsigned long long>(r.network.duplicated),
+                     percent(r.lateArrivals, r.network.sent) / 100.0,
+                     percent(r.concealedSamples, r.outputSamples) / 100.0,
+                     r.underruns, r.overruns,
+                     r.delayMeanMs, r.delayP50Ms, r.delayP95Ms, r.delayMaxMs, r.segSnrDb,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+// =============================================================================
+// Command line
+// =============================================================================
+
+void printUsage() {
+    std::printf(
+        "Usage: SaysesPlayoutBench [options]\n"
+        "  --receiver=app|jitter   Receive path (default app = UserAudioBuffer)\n"
+        "  --seconds=N             Stream length (default 60)\n"
+        "  --complexity=N          Opus complexity (default 5)\n"
+        "  --min-buffer-ms=A,B,..  Buffer start threshold(s) to evaluate (default 60)\n"
+        "  --max-buffer-ms=A,B,..  Buffer cap(s) to evaluate (default 200)\n"
+        "  --seed=N                Network RNG seed (default 1)\n"
+        "  --delay-ms=X            Base one-way delay (default 40)\n"
+        "  --jitter=none|uniform|normal|pareto  (default normal)\n"
+        "  --jitter-ms=X           Jitter scale (default 10)\n"
+        "  --burst-p=X --burst-r=X Gilbert-Elliott transitions (default 0, 0.3)\n"
+        "  --loss-good=X --loss-bad=X  Loss per state (default 0, 0.5)\n"
+        "  --reorder=X --reorder-ms=X  Hold-back probability / extra delay\n"
+        "  --duplicate=X           Duplication probability\n"
+        "  --json=PATH             Also write results as JSON\n");
+}
+
+std::vector<int> parseList(const char* value) {
+    std::vector<int> list;
+    const char* p = value;
+    while (*p) {
+        char* end = nullptr;
+        long v = std::strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        list.push_back(static_cast<int>(v));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return list;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    auto& n = options.network;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || !eq) {
+            return false;
+        }
+        std::string key(arg + 2, eq);
+        const char* value = eq + 1;
+
+        if (key == "receiver") {
+            if (std::strcmp(value, "app") == 0) {
+                options.receiver = Receiver::App;
+            } else if (std::strcmp(value, "jitter") == 0) {
+                options.receiver = Receiver::Jitter;
+            } else {
+                return false;
+            }
+        } else if (key == "seconds") {
+            options.seconds = std::max(1, std::atoi(value));
+        } else if (key == "complexity") {
+            options.complexity = std::atoi(value);
+        } else if (key == "min-buffer-ms") {
+            options.minBufferMs = parseList(value);
+        } else if (key == "max-buffer-ms") {
+            options.maxBufferMs = parseList(value);
+        } else if (key == "seed") {
+            n.seed = std::strtoull(value, nullptr, 10);
+        } else if (key == "delay-ms") {
+            n.baseDelayMs = std::atof(value);
+        } else if (key == "jitter") {
+            if (std::strcmp(value, "none") == 0) {
+                n.jitter = NetworkImpairment::Jitter::None;
+            } else if (std::strcmp(value, "uniform") == 0) {
+                n.jitter = NetworkImpairment::Jitter::Uniform;
+            } else if (std::strcmp(value, "normal") == 0) {
+                n.jitter = NetworkImpairment::Jitter::Normal;
+            } else if (std::strcmp(value, "pareto") == 0) {
+                n.jitter = NetworkImpairment::Jitter::Pareto;
+            } else {
+                return false;
+            }
+        } else if (key == "jitter-ms") {
+            n.jitterMs = std::atof(value);
+        } else if (key == "burst-p") {
+            n.burstP = std::atof(value);
+        } else if (key == "burst-r") {
+            n.burstR = std::atof(value);
+        } else if (key == "loss-good") {
+            n.lossGood = std::atof(value);
+        } else if (key == "loss-bad") {
+            n.lossBad = std::atof(value);
+        } else if (key == "reorder") {
+            n.reorderProbability = std::atof(value);
+        } else if (key == "reorder-ms") {
+            n.reorderDelayMs = std::atof(value);
+        } else if (key == "duplicate") {
+            n.duplicateProbability = std::atof(value);
+        } else if (key == "json") {
+            options.jsonPath = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.minBufferMs.empty() && !options.maxBufferMs.empty();
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace sayses
+
+int main(int argc, char** argv) {
+    using namespace sayses::bench;
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    Stream stream = buildStream(options);
+
+    NetworkImpairment::Stats networkStats;
+    std::vector<Arrival> arrivals = scheduleArrivals(options, stream.packets.size(), networkStats);
+
+    // Run long enough for the last packets to play out
+    double lastArrival = arrivals.empty() ? 0.0 : arrivals.back().timeMs;
+    int largestBuffer = *std::max_element(options.maxBufferMs.begin(), options.maxBufferMs.end());
+    double endMs = std::max(lastArrival, options.seconds * 1000.0) + largestBuffer + 100.0;
+
+    std::printf("receiver=%s seconds=%d seed=%llu codec delay=%d samples, codec-only segSNR=%.2f dB\n",
+                options.receiver == Receiver::App ? "app" : "jitter", options.seconds,
+                static_cast<unsigned long long>(options.network.seed),
+                stream.codecDelay, stream.codecSegSnrDb);
+    std::printf("   min    max |  loss%%  late%% conc%% |  dMean    dP50    dP95    dMax | segSNR  under   over |  dup%%\n");
+
+    std::vector<Result> results;
+    for (int minBuffer : options.minBufferMs) {
+        for (int maxBuffer : options.maxBufferMs) {
+            Result result;
+            result.minBufferMs = minBuffer;
+            result.maxBufferMs = maxBuffer;
+            result.network = networkStats;
+
+            if (options.receiver == Receiver::App) {
+                runApp(options, stream, arrivals, endMs, result);
+            } else {
+                runJitter(options, stream, arrivals, endMs, result);
+            }
+            printResult(result);
+            results.push_back(result);
+        }
+    }
+
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, stream, results)) {
+        return 1;
+    }
+    return 0;
+}
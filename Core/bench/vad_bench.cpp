@@ -0,0 +1,632 @@
+/**
+ * VAD Noise Corpus Benchmark
+ * Runs the energy and spectral VoiceActivityDetectors over a corpus of
+ * background noises, alone and with talk spurts mixed in, and reports:
+ * - false transmit: share of noise-only time the VAD keeps the channel open
+ * - speech detected: share of speech frames the VAD passes (frames of a
+ *   talk spurt within 20 dB of the talker's active level)
+ * - gap transmit: share of pauses (after the hold time) still transmitted
+ * - CPU time per 10ms frame
+ *
+ * The built-in noises are synthetic and seeded, so runs are reproducible.
+ * Recorded noise can be added with --noise-file (48kHz mono 16-bit WAV or
+ * raw s16le).
+ *
+ * Usage: SaysesVadBench [--key=value ...], see printUsage().
+ */
+
+#include "bench_signal.h"
+#include "vad.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sayses {
+namespace bench {
+namespace {
+
+constexpr double kTalkSeconds = 1.2;
+constexpr double kPauseSeconds = 1.8;
+constexpr double kSpeechFrameDb = -20.0;   // Talk-spurt frames quieter than this are not labelled speech
+
+struct Options {
+    int seconds = 30;
+    double noiseDbfs = -30.0;     // Noise RMS; above the default VAD threshold (-40 dBFS)
+    double snrDb = 10.0;          // Speech over noise in the mixed runs
+    uint32_t seed = 1;
+    VoiceActivityDetector::Config vad;
+    std::vector<std::string> noiseFiles;
+    std::string jsonPath;
+};
+
+struct Noise {
+    std::string name;
+    std::vector<float> samples;   // Normalized to unit RMS
+};
+
+struct Score {
+    double falseTransmit = 0.0;   // Noise only
+    double speechDetected = 0.0;  // Mixed: speech frames
+    double gapTransmit = 0.0;     // Mixed: pause frames past the hold time
+    double nsPerFrame = 0.0;
+};
+
+struct Result {
+    std::string noise;
+    Score energy;
+    Score spectral;
+};
+
+// =============================================================================
+// Synthetic noise corpus
+// =============================================================================
+
+/**
+ * Deterministic uniform noise in [-1, 1).
+ */
+class Rng {
+public:
+    explicit Rng(uint32_t seed) : state_(0x9E3779B97F4A7C15ull * (seed + 1)) {}
+
+    float next() {
+        // splitmix64
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        return static_cast<float>((z >> 40) * (2.0 / 16777216.0) - 1.0);
+    }
+
+private:
+    uint64_t state_;
+};
+
+void normalize(std::vector<float>& samples) {
+    double sum = 0.0;
+    for (float s : samples) {
+        sum += static_cast<double>(s) * s;
+    }
+    double rms = std::sqrt(sum / std::max<size_t>(samples.size(), 1));
+    if (rms > 0.0) {
+        for (float& s : samples) {
+            s = static_cast<float>(s / rms);
+        }
+    }
+}
+
+std::vector<float> makeWhite(size_t n, Rng& rng) {
+    std::vector<float> out(n);
+    for (float& s : out) {
+        s = rng.next();
+    }
+    return out;
+}
+
+// Paul Kellet's pink filter
+std::vector<float> makePink(size_t n, Rng& rng) {
+    std::vector<float> out(n);
+    float b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+    for (float& s : out) {
+        float w = rng.next();
+        b0 = 0.99886f * b0 + w * 0.0555179f;
+        b1 = 0.99332f * b1 + w * 0.0750759f;
+        b2 = 0.96900f * b2 + w * 0.1538520f;
+        b3 = 0.86650f * b3 + w * 0.3104856f;
+        b4 = 0.55000f * b4 + w * 0.5329522f;
+        b5 = -0.7616f * b5 - w * 0.0168980f;
+        s = b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362f;
+        b6 = w * 0.115926f;
+    }
+    return out;
+}
+
+// Leaky-integrated white noise: road and cabin rumble
+std::vector<float> makeBrown(size_t n, Rng& rng) {
+    std::vector<float> out(n);
+    float y = 0.0f;
+    for (float& s : out) {
+        y = 0.995f * y + 0.05f * rng.next();
+        s = y;
+    }
+    return out;
+}
+
+// Idling diesel: firing harmonics with cycle-to-cycle wobble over rumble
+std::vector<float> makeEngine(size_t n, Rng& rng) {
+    std::vector<float> rumble = makeBrown(n, rng);
+    normalize(rumble);
+    std::vector<float> out(n);
+    const double firingHz = 27.0;
+    double phase = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double t = static_cast<double>(i) / kSampleRate;
+        double wobble = 1.0 + 0.02 * std::sin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * firingHz * wobble / kSampleRate;
+        double tone = 0.0;
+        for (int h = 1; h <= 40; h++) {
+            tone += std::sin(h * phase + h * 0.37) / std::pow(h, 0.8);
+        }
+        out[i] = static_cast<float>(0.15 * tone + 0.5 * rumble[i]);
+    }
+    return out;
+}
+
+// HVAC / generator: pink noise plus 50Hz mains hum and harmonics
+std::vector<float> makeHum(size_t n, Rng& rng) {
+    std::vector<float> out = makePink(n, rng);
+    normalize(out);
+    for (size_t i = 0; i < n; i++) {
+        double t = static_cast<double>(i) / kSampleRate;
+        double hum = 0.0;
+        for (int h = 1; h <= 8; h++) {
+            hum += std::sin(2.0 * M_PI * 50.0 * h * t) / h;
+        }
+        out[i] = static_cast<float>(0.6 * out[i] + 0.5 * hum);
+    }
+    return out;
+}
+
+// Wind: low-passed noise with slow gusts
+std::vector<float> makeWind(size_t n, Rng& rng) {
+    std::vector<float> out(n);
+    float lp1 = 0.0f;
+    float lp2 = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        double t = static_cast<double>(i) / kSampleRate;
+        double gust = 0.6 + 0.4 * std::sin(2.0 * M_PI * 0.23 * t) * std::sin(2.0 * M_PI * 0.071 * t + 1.0);
+        lp1 += 0.02f * (rng.next() - lp1);
+        lp2 += 0.02f * (lp1 - lp2);
+        out[i] = static_cast<float>(lp2 * gust);
+    }
+    return out;
+}
+
+// Job site: generator hum with irregular hammer impacts
+std::vector<float> makeJobsite(size_t n, Rng& rng) {
+    std::vector<float> out = makeHum(n, rng);
+    normalize(out);
+    for (float& s : out) {
+        s *= 0.5f;
+    }
+    size_t next = 0;
+    while (next < n) {
+        size_t length = kSampleRate / 25;   // 40ms decaying burst
+        float ring = 0.0f;
+        for (size_t i = 0; i < length && next + i < n; i++) {
+            float decay = std::exp(-static_cast<float>(i) / (kSampleRate * 0.008f));
+            ring = 0.7f * ring + rng.next();
+            out[next + i] += 2.5f * decay * ring;
+        }
+        next += static_cast<size_t>(kSampleRate * (0.35 + 0.5 * (rng.next() + 1.0f) * 0.5));
+    }
+    return out;
+}
+
+std::vector<Noise> makeCorpus(size_t n, uint32_t seed) {
+    struct Generator {
+        const char* name;
+        std::function<std::vector<float>(size_t, Rng&)> make;
+    };
+    const Generator generators[] = {
+        {"white", makeWhite},
+        {"pink", makePink},
+        {"road", makeBrown},
+        {"engine", makeEngine},
+        {"hvac", makeHum},
+        {"wind", makeWind},
+        {"jobsite", makeJobsite},
+    };
+
+    std::vector<Noise> corpus;
+    uint32_t index = 0;
+    for (const auto& generator : generators) {
+        Rng rng(seed * 101 + index++);
+        Noise noise{generator.name, generator.make(n, rng)};
+        normalize(noise.samples);
+        corpus.push_back(std::move(noise));
+    }
+    return corpus;
+}
+
+bool loadNoiseFile(const std::string& path, size_t n, Noise& noise) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t dataOffset = 0;
+    size_t dataSize = bytes.size();
+    if (bytes.size() >= 12 && std::memcmp(bytes.data(), "RIFF", 4) == 0 &&
+        std::memcmp(bytes.data() + 8, "WAVE", 4) == 0) {
+        dataSize = 0;
+        size_t offset = 12;
+        while (offset + 8 <= bytes.size()) {
+            uint32_t chunkSize;
+            std::memcpy(&chunkSize, bytes.data() + offset + 4, 4);
+            if (std::memcmp(bytes.data() + offset, "fmt ", 4) == 0 && chunkSize >= 16) {
+                uint16_t format, channels, bits;
+                uint32_t rate;
+                std::memcpy(&format, bytes.data() + offset + 8, 2);
+                std::memcpy(&channels, bytes.data() + offset + 10, 2);
+                std::memcpy(&rate, bytes.data() + offset + 12, 4);
+                std::memcpy(&bits, bytes.data() + offset + 22, 2);
+                if (format != 1 || channels != 1 || bits != 16 || rate != kSampleRate) {
+                    std::fprintf(stderr, "%s: need 48kHz mono 16-bit PCM\n", path.c_str());
+                    return false;
+                }
+            } else if (std::memcmp(bytes.data() + offset, "data", 4) == 0) {
+                dataOffset = offset + 8;
+                dataSize = std::min<size_t>(chunkSize, bytes.size() - dataOffset);
+                break;
+            }
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+    }
+
+    size_t available = dataSize / sizeof(int16_t);
+    if (available == 0) {
+        return false;
+    }
+    noise.name = path.substr(path.find_last_of('/') + 1);
+    noise.samples.resize(n);
+    const int16_t* pcm = reinterpret_cast<const int16_t*>(bytes.data() + dataOffset);
+    for (size_t i = 0; i < n; i++) {
+        noise.samples[i] = pcm[i % available] / 32768.0f;   // Loop short recordings
+    }
+    normalize(noise.samples);
+    return true;
+}
+
+// =============================================================================
+// Talker
+// =============================================================================
+
+/**
+ * Source-filter speech stand-in: a glottal pulse train with slow intonation
+ * through three formant resonators that glide between vowels, a 4Hz
+ * syllable envelope and occasional fricatives. Unlike makeSpeech() its
+ * energy sits in the formant region, as real speech does.
+ */
+std::vector<float> makeTalker(size_t n, uint32_t seed) {
+    struct Vowel {
+        float f1, f2, f3;
+    };
+    const Vowel vowels[] = {
+        {730, 1090, 2440}, {270, 2290, 3010}, {300, 870, 2240}, {530, 1840, 2480}, {570, 840, 2410},
+    };
+    const float bandwidths[3] = {80.0f, 100.0f, 120.0f};
+    const size_t vowelSamples = kSampleRate * 18 / 100;    // 180ms per vowel
+    const size_t syllableSamples = kSampleRate / 4;
+
+    Rng rng(seed * 7919 + 3);
+    std::vector<float> out(n);
+    std::vector<float> fricative(n);
+    double phase = 0.0;
+    float glottal1 = 0.0f, glottal2 = 0.0f, lastGlottal = 0.0f;
+    float y1[3] = {}, y2[3] = {};
+    float hissLast = 0.0f, hissLowpass = 0.0f;
+    const double f0 = 105.0 + 10.0 * (seed % 5);
+
+    for (size_t i = 0; i < n; i++) {
+        double t = static_cast<double>(i) / kSampleRate;
+
+        // Glottal source: impulse per pitch period, two-pole lowpass, radiation differencing
+        double pitch = f0 * (1.0 + 0.12 * std::sin(2.0 * M_PI * 0.6 * t));
+        phase += pitch / kSampleRate;
+        float impulse = 0.0f;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+            impulse = 1.0f;
+        }
+        glottal1 = 0.94f * glottal1 + impulse;
+        glottal2 = 0.94f * glottal2 + glottal1;
+        float source = glottal2 - lastGlottal;
+        lastGlottal = glottal2;
+
+        // Formants glide linearly between successive vowels
+        size_t v = (i / vowelSamples) + seed;
+        float blend = static_cast<float>(i % vowelSamples) / vowelSamples;
+        const Vowel& from = vowels[v % 5];
+        const Vowel& to = vowels[(v + 1) % 5];
+        const float formants[3] = {
+            from.f1 + (to.f1 - from.f1) * blend,
+            from.f2 + (to.f2 - from.f2) * blend,
+            from.f3 + (to.f3 - from.f3) * blend,
+        };
+        float voiced = source;
+        for (int f = 0; f < 3; f++) {
+            float r = std::exp(-static_cast<float>(M_PI) * bandwidths[f] / kSampleRate);
+            float c = 2.0f * r * std::cos(2.0f * static_cast<float>(M_PI) * formants[f] / kSampleRate);
+            float y = (1.0f - r) * voiced + c * y1[f] - r * r * y2[f];
+            y2[f] = y1[f];
+            y1[f] = y;
+            voiced = y;
+        }
+
+        // Every fourth syllable starts with 60ms of hiss instead of voicing
+        float noise = rng.next();
+        hissLowpass += 0.6f * ((noise - hissLast) - hissLowpass);   // Roughly 3-9kHz
+        hissLast = noise;
+        size_t inSyllable = i % syllableSamples;
+        if ((i / syllableSamples) % 4 == 0 && inSyllable < kSampleRate * 6 / 100) {
+            fricative[i] = hissLowpass;
+            continue;
+        }
+
+        double envelope = 0.55 + 0.45 * std::sin(2.0 * M_PI * 4.0 * t);
+        out[i] = static_cast<float>(voiced * envelope);
+    }
+
+    // Fricatives about 15dB below the voiced level
+    normalize(out);
+    for (size_t i = 0; i < n; i++) {
+        out[i] += 0.25f * fricative[i];
+    }
+    return out;
+}
+
+// =============================================================================
+// Scoring
+// =============================================================================
+
+bool isTalking(size_t sample) {
+    double t = static_cast<double>(sample) / kSampleRate;
+    double cycle = kTalkSeconds + kPauseSeconds;
+    return std::fmod(t, cycle) < kTalkSeconds;
+}
+
+bool isPastHold(size_t sample, int holdMs) {
+    double t = static_cast<double>(sample) / kSampleRate;
+    double cycle = kTalkSeconds + kPauseSeconds;
+    return std::fmod(t, cycle) >= kTalkSeconds + holdMs / 1000.0;
+}
+
+std::vector<int16_t> toPcm(const std::vector<float>& signal) {
+    std::vector<int16_t> pcm(signal.size());
+    for (size_t i = 0; i < signal.size(); i++) {
+        float s = std::max(-1.0f, std::min(1.0f, signal[i]));
+        pcm[i] = static_cast<int16_t>(s * 32767.0f);
+    }
+    return pcm;
+}
+
+using VadFactory = std::unique_ptr<VoiceActivityDetector> (*)(const VoiceActivityDetector::Config&);
+
+Score score(VadFactory factory, const VoiceActivityDetector::Config& config,
+            const std::vector<int16_t>& noiseOnly, const std::vector<int16_t>& mixed,
+            const std::vector<bool>& speechFrames) {
+    Score result;
+    const size_t frames = noiseOnly.size() / kFrameSize;
+
+    auto vad = factory(config);
+    uint64_t transmitting = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; f++) {
+        transmitting += vad->process(noiseOnly.data() + f * kFrameSize, kFrameSize) ? 1 : 0;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    result.falseTransmit = static_cast<double>(transmitting) / frames;
+    result.nsPerFrame = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / frames;
+
+    vad = factory(config);
+    uint64_t talkFrames = 0, talkDetected = 0, gapFrames = 0, gapTransmit = 0;
+    for (size_t f = 0; f < frames; f++) {
+        bool on = vad->process(mixed.data() + f * kFrameSize, kFrameSize);
+        size_t sample = f * kFrameSize;
+        if (speechFrames[f]) {
+            talkFrames++;
+            talkDetected += on ? 1 : 0;
+        } else if (!isTalking(sample) && isPastHold(sample, config.holdTimeMs)) {
+            gapFrames++;
+            gapTransmit += on ? 1 : 0;
+        }
+    }
+    result.speechDetected = talkFrames ? static_cast<double>(talkDetected) / talkFrames : 0.0;
+    result.gapTransmit = gapFrames ? static_cast<double>(gapTransmit) / gapFrames : 0.0;
+    return result;
+}
+
+Result run(const Noise& noise, const Options& options) {
+    const size_t n = noise.samples.size();
+    const float noiseGain = static_cast<float>(std::pow(10.0, options.noiseDbfs / 20.0));
+
+    // Talk spurts at the requested SNR over the noise
+    std::vector<float> talker = makeTalker(n, options.seed);
+    std::vector<float> speech(n);
+    double speechSum = 0.0;
+    size_t talkSamples = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (isTalking(i)) {
+            speech[i] = talker[i];
+            speechSum += static_cast<double>(speech[i]) * speech[i];
+            talkSamples++;
+        }
+    }
+    double speechRms = std::sqrt(speechSum / std::max<size_t>(talkSamples, 1));
+    float speechGain = static_cast<float>(noiseGain * std::pow(10.0, options.snrDb / 20.0) / speechRms);
+
+    std::vector<float> noiseOnly(n);
+    std::vector<float> mixed(n);
+    for (size_t i = 0; i < n; i++) {
+        noiseOnly[i] = noise.samples[i] * noiseGain;
+        mixed[i] = noiseOnly[i] + speech[i] * speechGain;
+    }
+    std::vector<int16_t> noisePcm = toPcm(noiseOnly);
+    std::vector<int16_t> mixedPcm = toPcm(mixed);
+
+    // Label speech frames from the clean talker, skipping syllable troughs
+    const double minFrameRms = speechRms * std::pow(10.0, kSpeechFrameDb / 20.0);
+    std::vector<bool> speechFrames(n / kFrameSize);
+    for (size_t f = 0; f < speechFrames.size(); f++) {
+        double sum = 0.0;
+        for (size_t i = f * kFrameSize; i < (f + 1) * kFrameSize; i++) {
+            sum += static_cast<double>(speech[i]) * speech[i];
+        }
+        speechFrames[f] = std::sqrt(sum / kFrameSize) >= minFrameRms;
+    }
+
+    Result result;
+    result.noise = noise.name;
+    result.energy = score(&VoiceActivityDetector::create, options.vad, noisePcm, mixedPcm, speechFrames);
+    result.spectral = score(&VoiceActivityDetector::createSpectral, options.vad, noisePcm, mixedPcm, speechFrames);
+    return result;
+}
+
+// =============================================================================
+// Command line
+// =============================================================================
+
+void printUsage() {
+    std::printf(
+        "Usage: SaysesVadBench [options]\n"
+        "  --seconds=N        Length of each noise run (default 30)\n"
+        "  --noise-dbfs=X     Noise level, RMS dBFS (default -30)\n"
+        "  --snr-db=X         Speech over noise in the mixed runs (default 10)\n"
+        "  --seed=N           Seed for the synthetic corpus and talker (default 1)\n"
+        "  --threshold=X --attack-ms=N --hold-ms=N\n"
+        "  --snr-threshold-db=X --speech-ratio=X --noise-window-ms=N\n"
+        "                     VoiceActivityDetector::Config overrides\n"
+        "  --noise-file=PATH  Add a recorded noise (48kHz mono s16 WAV or raw); repeatable\n"
+        "  --json=PATH        Also write the results as JSON\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || !eq) {
+            return false;
+        }
+        std::string key(arg + 2, eq);
+        const char* value = eq + 1;
+
+        if (key == "seconds") {
+            options.seconds = std::max(1, std::atoi(value));
+        } else if (key == "noise-dbfs") {
+            options.noiseDbfs = std::atof(value);
+        } else if (key == "snr-db") {
+            options.snrDb = std::atof(value);
+        } else if (key == "seed") {
+            options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (key == "threshold") {
+            options.vad.threshold = static_cast<float>(std::atof(value));
+        } else if (key == "attack-ms") {
+            options.vad.attackTimeMs = std::atoi(value);
+        } else if (key == "hold-ms") {
+            options.vad.holdTimeMs = std::atoi(value);
+        } else if (key == "snr-threshold-db") {
+            options.vad.snrThresholdDb = static_cast<float>(std::atof(value));
+        } else if (key == "speech-ratio") {
+            options.vad.speechBandRatio = static_cast<float>(std::atof(value));
+        } else if (key == "noise-window-ms") {
+            options.vad.noiseWindowMs = std::atoi(value);
+        } else if (key == "noise-file") {
+            options.noiseFiles.push_back(value);
+        } else if (key == "json") {
+            options.jsonPath = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printScore(const char* name, const Score& s) {
+    std::printf("  %-9s %7.1f%% %8.1f%% %7.1f%% %9.0f\n", name,
+                s.falseTransmit * 100.0, s.speechDetected * 100.0, s.gapTransmit * 100.0, s.nsPerFrame);
+}
+
+void writeJsonScore(FILE* out, const char* name, const Score& s, bool last) {
+    std::fprintf(out,
+                 "      \"%s\": {\"false_transmit\": %.4f, \"speech_detected\": %.4f, "
+                 "\"gap_transmit\": %.4f, \"ns_per_frame\": %.0f}%s\n",
+                 name, s.falseTransmit, s.speechDetected, s.gapTransmit, s.nsPerFrame, last ? "" : ",");
+}
+
+bool writeJson(const std::string& path, const Options& options, const std::vector<Result>& results) {
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    std::fprintf(out, "{\n  \"seconds\": %d,\n  \"noise_dbfs\": %.1f,\n  \"snr_db\": %.1f,\n  \"results\": [\n",
+                 options.seconds, options.noiseDbfs, options.snrDb);
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(out, "    {\n      \"noise\": \"%s\",\n", results[i].noise.c_str());
+        writeJsonScore(out, "energy", results[i].energy, false);
+        writeJsonScore(out, "spectral", results[i].spectral, true);
+        std::fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    std::fclose(out);
+    return true;
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace sayses
+
+int main(int argc, char** argv) {
+    using namespace sayses::bench;
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    const size_t n = static_cast<size_t>(options.seconds) * kSampleRate;
+    std::vector<Noise> corpus = makeCorpus(n, options.seed);
+    for (const auto& path : options.noiseFiles) {
+        Noise noise;
+        if (!loadNoiseFile(path, n, noise)) {
+            std::fprintf(stderr, "Cannot read noise file %s\n", path.c_str());
+            return 1;
+        }
+        corpus.push_back(std::move(noise));
+    }
+
+    std::printf("VAD noise corpus: %ds per noise at %.0f dBFS, talk spurts %.1fs/%.1fs at %.0f dB SNR\n\n",
+                options.seconds, options.noiseDbfs, kTalkSeconds, kPauseSeconds, options.snrDb);
+    std::printf("  %-9s %8s %9s %8s %9s\n", "vad", "false tx", "speech ok", "gap tx", "ns/frame");
+
+    std::vector<Result> results;
+    Score energyTotal;
+    Score spectralTotal;
+    for (const auto& noise : corpus) {
+        Result result = run(noise, options);
+        std::printf("%s\n", result.noise.c_str());
+        printScore("energy", result.energy);
+        printScore("spectral", result.spectral);
+
+        energyTotal.falseTransmit += result.energy.falseTransmit / corpus.size();
+        energyTotal.speechDetected += result.energy.speechDetected / corpus.size();
+        energyTotal.gapTransmit += result.energy.gapTransmit / corpus.size();
+        energyTotal.nsPerFrame += result.energy.nsPerFrame / corpus.size();
+        spectralTotal.falseTransmit += result.spectral.falseTransmit / corpus.size();
+        spectralTotal.speechDetected += result.spectral.speechDetected / corpus.size();
+        spectralTotal.gapTransmit += result.spectral.gapTransmit / corpus.size();
+        spectralTotal.nsPerFrame += result.spectral.nsPerFrame / corpus.size();
+        results.push_back(std::move(result));
+    }
+
+    std::printf("mean\n");
+    printScore("energy", energyTotal);
+    printScore("spectral", spectralTotal);
+
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, results)) {
+        std::fprintf(stderr, "Cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "audio_features.h"
+
 #include <functional>
 #include <memory>
 #include <cstdint>
 #include <cstddef>
+#include <string>
 
 namespace sayses {
 
@@ -16,10 +19,36 @@ public:
     using AudioCallback = std::function<void(const int16_t* data, size_t frames)>;
     using PlaybackCallback = std::function<size_t(int16_t* data, size_t frames)>;
 
+    /**
+     * Capture time of a frame delivered to a FrameCallback.
+     */
+    struct CaptureTimestamp {
+        uint64_t sampleIndex = 0;  // First sample's position in the 48kHz capture stream
+        uint64_t hostTime = 0;     // Host clock ticks when it was captured (0 = unknown)
+        int sampleRate = 48000;    // Rate of the frame's samples (the processing rate)
+    };
+    using FrameCallback = std::function<void(const int16_t* data, size_t frames,
+                                             const CaptureTimestamp& timestamp)>;
+    using FloatFrameCallback = std::function<void(const float* data, size_t frames,
+                                                  const CaptureTimestamp& timestamp)>;
+
     struct Config {
         int sampleRate = 48000;
         int channels = 1;
         int framesPerBuffer = 480;  // 10ms at 48kHz
+        int frameDurationUs = 10000;  // Capture/mix/codec frame: 10000, 5000 or 2500 (Opus CELT sizes)
+        int jitterMinMs = 60;       // Per-user playout buffer before a talker starts
+        int jitterTargetMs = 80;    // ... the buffer it settles at
+        int jitterMaxMs = 200;      // ... and where it starts dropping
+        int renderAheadMs = 0;      // 0 = mix in the render callback; 10-20 = mix ahead on a worker
+        bool spectralVad = true;    // Noise-floor-tracking VAD; false = plain energy threshold
+        bool echoCancellation = false;  // Software AEC against the playback mix
+        int echoTailMs = 100;       // Echo path the AEC covers (10-300); CPU cost grows linearly
+        int echoDelayMs = 0;        // Known extra playback-to-capture delay (e.g. Bluetooth)
+        bool processAtDeviceRate = false;  // Run at an 8/12/16/24kHz route's rate instead of resampling to 48kHz
+        bool floatDeviceFormat = false;    // Float32 device I/O instead of S16 (AudioUnit, ALSA)
+        std::string inputDevice = "default";   // Device name on backends that have them (ALSA PCM)
+        std::string outputDevice = "default";
     };
 
     /**
@@ -27,15 +56,44 @@ public:
      */
     static std::unique_ptr<AudioEngine> create(const Config& config);
 
+    /**
+     * Low-delay profile for wired LAN consoles: 2.5ms frames, one frame per
+     * device buffer, a 10-40ms playout buffer and no render-ahead. Pair it
+     * with Codec::Config::lowDelay and a 2.5ms codec frame.
+     */
+    static Config lowDelayConfig();
+
     virtual ~AudioEngine() = default;
 
     /**
-     * Start audio capture with callback for each buffer.
-     * @param callback Called with audio data for each captured buffer
+     * Start audio capture with callback for each frame.
+     * Device buffers of any size are re-framed, so the callback always gets
+     * exactly one Config::frameDurationUs frame at the processing rate (480
+     * samples for the default 10ms at 48kHz), ready for the encoder.
+     * The callback runs on a dedicated transmit thread, not the audio thread,
+     * so it may encode and send; if it falls behind, frames are dropped.
+     * @param callback Called with audio data for each captured frame
      * @return true if capture started successfully
      */
     virtual bool startCapture(AudioCallback callback) = 0;
 
+    /**
+     * Start audio capture with callback for each timestamped frame.
+     * @param callback Called with each frame and its capture time
+     * @return true if capture started successfully
+     */
+    virtual bool startCapture(FrameCallback callback) = 0;
+
+    /**
+     * Start audio capture with float frames (full scale +/-1.0).
+     * Capture is processed in float from the device to this callback, so a
+     * float encoder gets the frames without int16 quantization. Only echo
+     * cancellation, while enabled, runs on an int16 copy.
+     * @param callback Called with each frame and its capture time
+     * @return true if capture started successfully
+     */
+    virtual bool startCapture(FloatFrameCallback callback) = 0;
+
     /**
      * Stop audio capture.
      */
@@ -46,6 +104,12 @@ public:
      */
     virtual bool isCapturing() const = 0;
 
+    /**
+     * Get the number of captured frames dropped because the transmit worker
+     * (which runs the capture callback) fell behind.
+     */
+    virtual uint64_t getCaptureDroppedFrames() const = 0;
+
     /**
      * Start audio playback with callback to request data.
      * @param callback Called to request audio data for playback
@@ -73,6 +137,13 @@ public:
      */
     virtual void setVadThreshold(float threshold) = 0;
 
+    /**
+     * Enable/disable software echo cancellation. The mix handed to the
+     * output device is the far-end reference, so it also works where the
+     * platform has no voice-processing I/O.
+     */
+    virtual void setEchoCancellationEnabled(bool enabled) = 0;
+
     /**
      * Check if voice is currently detected.
      */
@@ -83,6 +154,17 @@ public:
      */
     virtual float getInputLevel() const = 0;
 
+    /**
+     * Get the analysis of the most recent captured frame
+     * (RMS, peak, zero-crossing rate, clipped samples).
+     */
+    virtual AudioFrameFeatures getInputFeatures() const = 0;
+
+    /**
+     * Get the total number of captured samples that reached full scale.
+     */
+    virtual uint64_t getInputClippedSamples() const = 0;
+
     // =========================================================================
     // User Audio Management (for multi-user playback with mixing)
     // =========================================================================
@@ -91,13 +173,24 @@ public:
      * Add decoded audio samples for a specific user.
      * Uses per-user buffers with float mixing, jitter buffering, and crossfade.
      * @param userId User/session ID
-     * @param samples Decoded PCM samples (int16)
+     * @param samples Decoded PCM samples (int16) at getProcessingSampleRate()
      * @param frames Number of samples
      * @param sequence Packet sequence number for jitter buffer
      */
     virtual void addUserAudio(uint32_t userId, const int16_t* samples,
                               size_t frames, int64_t sequence) = 0;
 
+    /**
+     * Add decoded float audio for a specific user (e.g. from a float decoder).
+     * Goes into the user's float buffer as is; the mix is float end to end.
+     * @param userId User/session ID
+     * @param samples Decoded PCM samples (float, full scale +/-1.0) at getProcessingSampleRate()
+     * @param frames Number of samples
+     * @param sequence Packet sequence number for jitter buffer
+     */
+    virtual void addUserAudio(uint32_t userId, const float* samples,
+                              size_t frames, int64_t sequence) = 0;
+
     /**
      * Remove user's audio buffer (when user leaves).
      * @param userId User/session ID to remove
@@ -110,6 +203,40 @@ public:
      */
     virtual void notifyUserTalkingEnded(uint32_t userId) = 0;
 
+    // =========================================================================
+    // Per-User Mix Controls (applied inside the mixer, any thread)
+    // =========================================================================
+
+    /**
+     * Set a user's local playback gain.
+     * Settings may be made before the user's first packet and persist until
+     * removeUser().
+     * @param userId User/session ID
+     * @param gain Linear gain (1.0 = unchanged, clamped to 0.0 - 4.0)
+     */
+    virtual void setUserVolume(uint32_t userId, float gain) = 0;
+
+    /**
+     * Locally mute a user. Muted audio is discarded without being mixed.
+     * @param userId User/session ID
+     * @param muted true to mute
+     */
+    virtual void setUserMuted(uint32_t userId, bool muted) = 0;
+
+    /**
+     * Mark a user as priority speaker (e.g. the dispatcher).
+     * While a priority speaker is talking, all other users are ducked.
+     * @param userId User/session ID
+     * @param priority true if the user has priority_speaker set
+     */
+    virtual void setUserPrioritySpeaker(uint32_t userId, bool priority) = 0;
+
+    /**
+     * Set the gain applied to non-priority users while a priority speaker talks.
+     * @param gain Linear gain (0.0 - 1.0, default 0.3)
+     */
+    virtual void setPriorityDuckingLevel(float gain) = 0;
+
     /**
      * Start playback using internal user mixing (no callback needed).
      * Audio from addUserAudio is automatically mixed and played.
@@ -117,6 +244,23 @@ public:
      */
     virtual bool startMixedPlayback() = 0;
 
+    /**
+     * Get the current render-ahead lead (0 when mixing in the render callback).
+     * This is the extra playback latency the render-ahead mode adds: the
+     * largest device callback seen plus Config::renderAheadMs, plus a margin
+     * that grows after underruns and slowly shrinks back.
+     */
+    virtual int getRenderAheadMs() const = 0;
+
+    /**
+     * Get the rate the pipeline runs at: 48kHz, or with
+     * Config::processAtDeviceRate the rate of an 8/12/16/24kHz route.
+     * Captured frames arrive and decoded audio is expected at this rate, so
+     * encoders and decoders should be created with it (Opus supports all of
+     * them natively). Changes with the route; user buffers are flushed then.
+     */
+    virtual int getProcessingSampleRate() const = 0;
+
     /**
      * Get the playback callback invocation count.
      * Used to detect when the AudioUnit has silently stopped calling back.
@@ -0,0 +1,23 @@
+/**
+ * Audio Frame Features
+ * Per-frame capture analysis shared by the level meter, VAD and stats
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace sayses {
+
+/**
+ * Signal features of one captured frame, computed in a single pass.
+ * Levels are relative to int16 full scale.
+ */
+struct AudioFrameFeatures {
+    float rms = 0.0f;               // 0.0 - 1.0
+    float peak = 0.0f;              // Largest absolute sample, 0.0 - 1.0
+    float zeroCrossingRate = 0.0f;  // Sign changes per sample pair, 0.0 - 1.0
+    uint32_t clippedSamples = 0;    // Samples at +/- full scale
+};
+
+}  // namespace sayses
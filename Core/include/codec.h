@@ -19,13 +19,25 @@ public:
     };
 
     struct Config {
-        int sampleRate = 48000;
+        int sampleRate = 48000;    // Opus: 8000, 12000, 16000, 24000 or 48000
         int channels = 1;
         int bitrate = 64000;      // 64 kbps (good quality for voice, like Mumla)
-        int frameSize = 480;       // samples per frame (10ms at 48kHz)
+        int frameSize = 480;       // samples per frame (10ms at 48kHz; 2.5/5ms with lowDelay)
         int complexity = 5;        // 0-10, higher = better quality, more CPU
         bool vbr = true;           // variable bitrate
         bool dtx = true;           // discontinuous transmission
+        bool inbandFec = true;     // Opus in-band FEC (LBRR)
+        int packetLossPercent = 10;  // Expected loss the encoder protects against (0-100)
+        bool lowDelay = false;     // Opus RESTRICTED_LOWDELAY: CELT only, 2.5ms lookahead, no FEC
+    };
+
+    /**
+     * Encoder parameters that may change while encoding (see EncoderController).
+     */
+    struct EncoderSettings {
+        int bitrate = 64000;
+        bool inbandFec = true;
+        int packetLossPercent = 10;
     };
 
     virtual ~Codec() = default;
@@ -70,6 +82,44 @@ public:
      */
     virtual int decodePLC(int16_t* output, size_t maxOutputFrames) = 0;
 
+    /**
+     * Encode float PCM audio to compressed format.
+     * Skips the int16 round trip when the source is already float.
+     * @param input PCM input samples (float, full scale +/-1.0)
+     * @param inputFrames Number of input frames
+     * @param output Buffer for encoded data
+     * @param maxOutputBytes Maximum output buffer size
+     * @return Number of bytes written, or negative on error
+     */
+    virtual int encode(const float* input, size_t inputFrames,
+                       uint8_t* output, size_t maxOutputBytes) = 0;
+
+    /**
+     * Decode compressed audio to float PCM, without quantizing to 16 bits.
+     * @param input Encoded input data
+     * @param inputBytes Size of encoded data
+     * @param output Buffer for PCM output (float, full scale +/-1.0)
+     * @param maxOutputFrames Maximum output frames
+     * @return Number of frames decoded, or negative on error
+     */
+    virtual int decode(const uint8_t* input, size_t inputBytes,
+                       float* output, size_t maxOutputFrames) = 0;
+
+    /**
+     * Decode with packet loss concealment into float PCM.
+     * @param output Buffer for PCM output (float, full scale +/-1.0)
+     * @param maxOutputFrames Maximum output frames
+     * @return Number of frames generated
+     */
+    virtual int decodePLC(float* output, size_t maxOutputFrames) = 0;
+
+    /**
+     * Change bitrate, FEC and expected loss on the fly. Safe to call from any
+     * thread; the encoder picks the settings up before its next frame.
+     * @return false if the codec can't encode
+     */
+    virtual bool setEncoderSettings(const EncoderSettings& settings) = 0;
+
     /**
      * Reset codec state.
      */
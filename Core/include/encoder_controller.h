@@ -0,0 +1,124 @@
+/**
+ * Encoder Controller
+ * Adapts Opus bitrate, in-band FEC, expected loss and frames per packet to
+ * the measured link and keeps the on-wire rate within the server's
+ * bandwidth limit
+ */
+
+#pragma once
+
+#include "codec.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace sayses {
+
+/**
+ * Periodic encoder tuning from link measurements.
+ * Loss (the server's late/lost counters for our packets) switches FEC and
+ * the encoder's expected loss; queueing delay (RTT above its floor) or heavy
+ * loss backs the bitrate off, a clean link lets it recover. Frames per
+ * packet (for OpusPacketizer) grow when the headers wouldn't leave room for
+ * the bitrate within the server's max_bandwidth, on the TCP tunnel and on
+ * long round trips where the extra packetization delay matters least. The
+ * bitrate is then clamped so bitrate plus per-packet IP/UDP/crypto/Mumble
+ * overhead stays within max_bandwidth.
+ *
+ * Threading: not thread-safe; call from one (network) thread and hand the
+ * settings to Codec::setEncoderSettings(), which may be called from any thread.
+ */
+class EncoderController {
+public:
+    /**
+     * How voice packets reach the server. The TCP tunnel adds TCP and TLS
+     * record overhead in place of UDP and the OCB tag.
+     */
+    enum class Transport {
+        Udp,
+        TcpTunnel
+    };
+
+    struct Config {
+        int maxBitrate = 64000;       // Clean-link bitrate (bps), also the ceiling
+        int minBitrate = 16000;       // Floor for congestion backoff (server limit may go lower)
+        int updateIntervalMs = 4000;  // Re-evaluate this often
+        int maxFramesPerPacket = 6;   // Batching limit in codec frames (1 = one frame per packet)
+        int frameDurationUs = 10000;  // Codec frame length (AudioEngine::Config::frameDurationUs)
+    };
+
+    /**
+     * Cumulative link counters; the controller works on their deltas.
+     * good/late/lost come from the server's Ping replies for UDP voice; on
+     * the TCP tunnel they stay 0 and only rttMs drives the controller.
+     */
+    struct LinkStats {
+        uint32_t good = 0;    // Voice packets the server received
+        uint32_t late = 0;    // ... out of order
+        uint32_t lost = 0;    // ... never received
+        float rttMs = 0.0f;   // Latest round-trip time, 0 if unknown
+    };
+
+    /**
+     * Create a controller. It starts at Config::maxBitrate without FEC,
+     * one frame per packet.
+     */
+    static std::unique_ptr<EncoderController> create(const Config& config);
+
+    /**
+     * Bits per second spent on packet headers when each packet carries
+     * framesPerPacket frames of frameDurationUs: IPv4, UDP (or TCP + TLS
+     * record + Mumble prefix), OCB tag and the voice header (type, sequence
+     * and Opus length).
+     */
+    static int overheadBitrate(Transport transport, int framesPerPacket, int frameDurationUs);
+
+    virtual ~EncoderController() = default;
+
+    /**
+     * Set the server's bandwidth limit (ServerSync / ServerConfig
+     * max_bandwidth, bits per second including overhead, 0 = unlimited).
+     * Applied on the next update().
+     */
+    virtual void setMaxBandwidth(uint32_t bitsPerSecond) = 0;
+
+    /**
+     * Set the voice transport (changes the overhead the budget must cover).
+     */
+    virtual void setTransport(Transport transport) = 0;
+
+    /**
+     * Feed the latest link counters. Evaluates at most once per
+     * Config::updateIntervalMs, except that a changed bandwidth limit or
+     * transport is applied at once.
+     * @param now Current time
+     * @return true if getSettings() or getFramesPerPacket() changed
+     */
+    virtual bool update(const LinkStats& stats, std::chrono::steady_clock::time_point now) = 0;
+
+    /**
+     * Get the current encoder settings.
+     */
+    virtual Codec::EncoderSettings getSettings() const = 0;
+
+    /**
+     * Get the codec frames to send per voice packet.
+     */
+    virtual int getFramesPerPacket() const = 0;
+
+    /**
+     * Get the smoothed loss estimate (0.0 - 1.0).
+     */
+    virtual float getLossEstimate() const = 0;
+
+    /**
+     * Get the current on-wire rate (bitrate plus overhead, bits per second).
+     */
+    virtual int getTotalBitrate() const = 0;
+
+protected:
+    EncoderController() = default;
+};
+
+}  // namespace sayses
@@ -27,6 +27,7 @@ public:
         int packetsLate;
         int packetsReordered;
         float lossRate;
+        int64_t lastPlayedSequence;   // Sequence of the packet the last get() played, -1 if none
     };
 
     /**
@@ -0,0 +1,77 @@
+/**
+ * Opus Packetizer
+ * Merges consecutive 10ms Opus frames into one multi-frame packet
+ * (20/40/60ms per voice packet) to cut per-packet header overhead
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sayses {
+
+/**
+ * Collects encoded Opus frames and emits them as a single Opus packet
+ * (opus_repacketizer). The encoder keeps its 10ms cadence and the receiver
+ * decodes the merged packet with one opus_decode() call, so the frame
+ * count per packet can change at any frame boundary.
+ *
+ * Threading: not thread-safe; use from the encoding thread.
+ */
+class OpusPacketizer {
+public:
+    static constexpr int kMaxFramesPerPacket = 6;    // 60ms, the largest Mumble sends
+    static constexpr size_t kMaxFrameBytes = 1275;   // Largest single Opus frame
+    static constexpr size_t kMaxPacketBytes =        // Frames plus TOC, count and length bytes
+        kMaxFramesPerPacket * (kMaxFrameBytes + 2) + 2;
+
+    /**
+     * Create a packetizer that sends every frame on its own.
+     */
+    static std::unique_ptr<OpusPacketizer> create();
+
+    virtual ~OpusPacketizer() = default;
+
+    /**
+     * Set the frames per packet (1 - kMaxFramesPerPacket). A packet already
+     * being collected is completed at the new size.
+     */
+    virtual void setFramesPerPacket(int frames) = 0;
+
+    /**
+     * Get the frames per packet.
+     */
+    virtual int getFramesPerPacket() const = 0;
+
+    /**
+     * Add one encoded frame. A frame that can't be merged with the ones
+     * collected so far (the encoder switched mode or bandwidth) completes
+     * the pending packet and starts the next one.
+     * @param frame Encoded Opus frame (one encode() output)
+     * @param frameBytes Size of the frame
+     * @param output Buffer for a completed packet (kMaxPacketBytes is always enough)
+     * @param maxOutputBytes Size of the output buffer
+     * @param packetFrames Set to the number of frames in the completed packet
+     * @return Bytes written to output, 0 while still collecting, negative on error
+     */
+    virtual int addFrame(const uint8_t* frame, size_t frameBytes,
+                         uint8_t* output, size_t maxOutputBytes, int& packetFrames) = 0;
+
+    /**
+     * Emit the frames collected so far (end of transmission).
+     * @return Bytes written to output, 0 if nothing was pending, negative on error
+     */
+    virtual int flush(uint8_t* output, size_t maxOutputBytes, int& packetFrames) = 0;
+
+    /**
+     * Drop any collected frames.
+     */
+    virtual void reset() = 0;
+
+protected:
+    OpusPacketizer() = default;
+};
+
+}  // namespace sayses
@@ -1,6 +1,6 @@
 /**
  * Speex DSP Wrapper
- * Provides noise suppression, AGC, dereverb, and resampling
+ * Provides noise suppression, AGC, dereverb, resampling and echo cancellation
  */
 
 #pragma once
@@ -44,6 +44,16 @@ public:
      */
     static std::unique_ptr<SpeexPreprocessor> create(const Config& config);
 
+    /**
+     * Create the built-in float preprocessor: Wiener noise suppression and a
+     * digital AGC that do not depend on how libspeexdsp was built (Speex-iOS
+     * ships it FIXED_POINT with USE_SMALLFT, which breaks its FFT; the Podfile
+     * patches that). Fixed cost per frame, one frame of latency. agcTarget
+     * is the speech peak level; dereverb is not supported. The enable setters
+     * may be called from any thread and take effect at the next process().
+     */
+    static std::unique_ptr<SpeexPreprocessor> createFloat(const Config& config);
+
     virtual ~SpeexPreprocessor() = default;
 
     /**
@@ -55,16 +65,20 @@ public:
     virtual bool process(int16_t* samples, size_t frames) = 0;
 
     /**
-     * Get speech probability from last processed frame.
-     * @return Probability 0.0 - 1.0
+     * Process a float audio frame (full scale +/-1.0).
+     * The float preprocessor works on it directly; libspeexdsp's goes
+     * through int16.
+     * @param samples In/out audio samples (modified in place)
+     * @param frames Number of frames (must match frameSize)
+     * @return VAD result if enabled, otherwise true
      */
-    virtual float getSpeechProbability() const = 0;
+    virtual bool process(float* samples, size_t frames) = 0;
 
     /**
-     * Get current input level (after AGC).
-     * @return Level 0.0 - 1.0
+     * Get speech probability from last processed frame.
+     * @return Probability 0.0 - 1.0
      */
-    virtual float getInputLevel() const = 0;
+    virtual float getSpeechProbability() const = 0;
 
     /**
      * Update configuration.
@@ -100,7 +114,9 @@ public:
     };
 
     /**
-     * Create a resampler instance.
+     * Create a resampler instance. Mono conversions between 48 kHz and
+     * 8/16/24 kHz at up to VoIP quality use createPolyphase(), everything
+     * else createSpeex().
      * @param channels Number of channels (1 = mono)
      * @param inputRate Input sample rate (e.g., 16000)
      * @param outputRate Output sample rate (e.g., 48000)
@@ -113,6 +129,28 @@ public:
         Quality quality = Quality::VoIP
     );
 
+    /**
+     * Create the libspeexdsp resampler (any ratio, any channel count).
+     */
+    static std::unique_ptr<SpeexResampler> createSpeex(
+        int channels,
+        int inputRate,
+        int outputRate,
+        Quality quality = Quality::VoIP
+    );
+
+    /**
+     * Create a fixed-ratio polyphase FIR resampler for mono 48 kHz <->
+     * 8/16/24 kHz, at about the quality of Quality::VoIP but with a fixed
+     * 32-tap filter per output sample and vectorized inner loops.
+     * @return nullptr for any other rate pair or channel count
+     */
+    static std::unique_ptr<SpeexResampler> createPolyphase(
+        int channels,
+        int inputRate,
+        int outputRate
+    );
+
     virtual ~SpeexResampler() = default;
 
     /**
@@ -128,6 +166,15 @@ public:
         int16_t* output, size_t& outputFrames
     ) = 0;
 
+    /**
+     * Resample float audio data (full scale +/-1.0).
+     * Same contract as the int16 overload; a stream should stick to one.
+     */
+    virtual bool process(
+        const float* input, size_t& inputFrames,
+        float* output, size_t& outputFrames
+    ) = 0;
+
     /**
      * Get the input/output ratio.
      */
@@ -147,4 +194,46 @@ protected:
     SpeexResampler() = default;
 };
 
+/**
+ * Speex acoustic echo canceller (MDF adaptive filter).
+ * Removes the far-end signal (what the speaker played) from the capture.
+ * The reference must be aligned so that its echo arrives within the tail.
+ */
+class SpeexEchoCanceller {
+public:
+    /**
+     * Create an echo canceller instance.
+     * @param sampleRate Sample rate of capture and reference
+     * @param frameSize Samples per process() call
+     * @param tailMs Echo path length the filter covers; cost grows linearly with it
+     */
+    static std::unique_ptr<SpeexEchoCanceller> create(int sampleRate, int frameSize, int tailMs);
+
+    virtual ~SpeexEchoCanceller() = default;
+
+    /**
+     * Cancel the echo in one frame.
+     * @param captured Near-end frame from the microphone
+     * @param played Far-end reference frame, aligned with captured
+     * @param output Echo-cancelled frame (must not alias captured)
+     * @param frames Number of frames (must match frameSize)
+     * @return false if the frame size does not match
+     */
+    virtual bool process(const int16_t* captured, const int16_t* played,
+                         int16_t* output, size_t frames) = 0;
+
+    /**
+     * Get the echo path length the filter covers.
+     */
+    virtual int getTailMs() const = 0;
+
+    /**
+     * Reset the adaptive filter (e.g. after a route change).
+     */
+    virtual void reset() = 0;
+
+protected:
+    SpeexEchoCanceller() = default;
+};
+
 }  // namespace sayses
@@ -10,8 +10,6 @@
 #include <cstdint>
 #include <cstddef>
 #include <vector>
-#include <deque>
-#include <mutex>
 
 namespace sayses {
 
@@ -20,9 +18,14 @@ namespace sayses {
  * Handles:
  * - Sequence-based packet ordering
  * - Adaptive jitter buffering
- * - Float sample storage for clipping-safe mixing
+ * - Preallocated ring storage (float, or int16 to halve memory traffic)
  * - Sine-wave crossfade for smooth transitions
  * - Packet loss concealment integration
+ *
+ * Threading: lock-free single producer / single consumer.
+ * addSamples() and reset() belong to the producer (network/decode) thread,
+ * readFloat() and skip() to the consumer (render) thread. The remaining methods are
+ * safe to call from any thread.
  */
 class UserAudioBuffer {
 public:
@@ -32,6 +35,7 @@ public:
         int minBufferMs = 60;          // Minimum buffer before playback
         int maxBufferMs = 200;         // Maximum buffer size
         int targetBufferMs = 80;       // Target buffer size
+        bool storeInt16 = false;       // Keep samples as int16, convert on read
     };
 
     struct Stats {
@@ -70,6 +74,17 @@ public:
     virtual void addSamples(const int16_t* samples, size_t frames,
                             int64_t sequence, bool isPLC = false) = 0;
 
+    /**
+     * Add decoded float audio samples (e.g. from a float decoder).
+     * Float storage takes them as they are, without int16 quantization.
+     * @param samples PCM samples (float, full scale +/-1.0)
+     * @param frames Number of frames
+     * @param sequence Packet sequence number
+     * @param isPLC true if this is PLC-generated audio
+     */
+    virtual void addSamples(const float* samples, size_t frames,
+                            int64_t sequence, bool isPLC = false) = 0;
+
     /**
      * Read audio as float samples for mixing.
      * @param output Float output buffer
@@ -78,6 +93,14 @@ public:
      */
     virtual size_t readFloat(float* output, size_t frames) = 0;
 
+    /**
+     * Consume audio without converting it (e.g. for a locally muted user).
+     * Keeps the stream advancing at the playback rate; the next read fades in.
+     * @param frames Number of frames to drop
+     * @return Number of frames actually dropped
+     */
+    virtual size_t skip(size_t frames) = 0;
+
     /**
      * Check if buffer has enough data to start playback.
      */
@@ -95,6 +118,8 @@ public:
 
     /**
      * Reset buffer state.
+     * Call from the producer thread; audio buffered so far is dropped on the
+     * next read, samples added after reset() are kept.
      */
     virtual void reset() = 0;
 
@@ -144,7 +169,8 @@ protected:
 
 /**
  * Float mixer for combining multiple audio streams.
- * Implements clipping-safe mixing like Humla's BasicClippingShortMixer.
+ * Mixes in float and runs a 32-sample-lookahead peak limiter on output, so several
+ * loud talkers are turned down smoothly instead of being hard clipped.
  */
 class FloatMixer {
 public:
@@ -169,14 +195,32 @@ public:
     virtual void add(const float* samples, size_t frames) = 0;
 
     /**
-     * Get mixed result as int16 with clipping.
+     * Add samples to the mix with a gain that moves linearly from
+     * startGain to endGain over the frame, to avoid zipper noise.
+     * @param samples Float samples to add
+     * @param frames Number of frames
+     * @param startGain Gain applied before the first sample
+     * @param endGain Gain reached on the last sample
+     */
+    virtual void add(const float* samples, size_t frames, float startGain, float endGain) = 0;
+
+    /**
+     * Get mixed result as int16, peak limited to just below full scale.
+     * The limiter looks 32 samples ahead, so output trails the mix by that much.
      * @param output Int16 output buffer
      * @param frames Number of frames
      */
     virtual void getMixed(int16_t* output, size_t frames) = 0;
 
     /**
-     * Get the raw float mix buffer (before clipping).
+     * Get mixed result as float, peak limited and clipped to +/-1.0.
+     * @param output Float output buffer
+     * @param frames Number of frames
+     */
+    virtual void getMixed(float* output, size_t frames) = 0;
+
+    /**
+     * Get the raw float mix buffer (before limiting).
      */
     virtual const float* getFloatBuffer() const = 0;
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "audio_features.h"
+
 #include <memory>
 #include <cstdint>
 #include <cstddef>
@@ -7,7 +9,10 @@
 namespace sayses {
 
 /**
- * Voice Activity Detection using signal energy analysis.
+ * Voice Activity Detection.
+ * create() compares the broadband level to a threshold; createSpectral()
+ * additionally requires speech-band energy above a tracked noise floor, so
+ * steady background noise (engines, fans, wind) does not open the channel.
  */
 class VoiceActivityDetector {
 public:
@@ -17,13 +22,25 @@ public:
         int holdTimeMs = 300;             // Time to hold voice state after detection
         int attackTimeMs = 10;            // Time to confirm voice onset
         float minSignalLevel = 0.001f;    // Minimum signal level to consider
+
+        // Spectral detector only (createSpectral)
+        float snrThresholdDb = 6.0f;      // Mean SNR of the strongest speech bands over the noise floor
+        float speechBandRatio = 0.6f;     // Minimum share of the energy above the floor in 250-4000 Hz
+        int noiseWindowMs = 1000;         // Minimum-statistics window; longer follows rising noise slower
     };
 
     /**
-     * Create a voice activity detector.
+     * Create an energy-based voice activity detector.
      */
     static std::unique_ptr<VoiceActivityDetector> create(const Config& config);
 
+    /**
+     * Create a spectral voice activity detector: sub-band SNR against a
+     * minimum-statistics noise floor plus a speech-band energy ratio.
+     * Work per 10ms hop is fixed (one FFT, constant-time floor tracking).
+     */
+    static std::unique_ptr<VoiceActivityDetector> createSpectral(const Config& config);
+
     virtual ~VoiceActivityDetector() = default;
 
     /**
@@ -34,6 +51,15 @@ public:
      */
     virtual bool process(const int16_t* samples, size_t frames) = 0;
 
+    /**
+     * Same as process(samples, frames), reusing features the caller already
+     * computed so a pipeline that analyzes each frame once need not rescan it.
+     * @param features Analysis of these samples (see kernels::analyzeFrame)
+     * @return true if voice is detected
+     */
+    virtual bool process(const int16_t* samples, size_t frames,
+                         const AudioFrameFeatures& features) = 0;
+
     /**
      * Check if voice is currently detected (includes hold time).
      */
@@ -0,0 +1,250 @@
+/**
+ * AudioEngine Implementation for Linux
+ * ALSA I/O backend for the shared AudioPipeline
+ *
+ * Features:
+ * - Blocking ALSA PCM I/O on two real-time threads (capture / playback)
+ * - Works headless against snd-dummy, snd-aloop or a PulseAudio/PipeWire
+ *   null sink through the "default" / "pulse" ALSA PCMs
+ * - Capture timestamps on CLOCK_MONOTONIC, corrected for the device delay
+ * - S16 or FLOAT (Config::floatDeviceFormat) sample format
+ */
+
+#include "audio_pipeline.h"
+
+#include <alsa/asoundlib.h>
+
+#include <pthread.h>
+#include <time.h>
+
+#include <cstdio>
+
+namespace sayses {
+
+class AlsaAudioEngine : public AudioPipeline {
+public:
+    explicit AlsaAudioEngine(const Config& config);
+    ~AlsaAudioEngine() override;
+
+protected:
+    bool startDevice() override;
+
+private:
+    snd_pcm_t* openDevice(const std::string& name, snd_pcm_stream_t stream,
+                          snd_pcm_uframes_t& periodFrames);
+    void closeDevices();
+
+    // Sample is the device format: int16_t (S16) or float (FLOAT)
+    template <typename Sample>
+    void captureLoop();
+    template <typename Sample>
+    void playbackLoop();
+
+    static uint64_t monotonicNanos();
+
+    // Device configuration
+    int deviceSampleRate_;
+    unsigned int latencyUs_;
+
+    // PCM handles (owned by the I/O threads while running_)
+    snd_pcm_t* capturePcm_{nullptr};
+    snd_pcm_t* playbackPcm_{nullptr};
+    snd_pcm_uframes_t capturePeriod_{0};
+    snd_pcm_uframes_t playbackPeriod_{0};
+
+    // I/O threads
+    std::mutex deviceMutex_;  // Serializes startDevice() / teardown
+    std::atomic<bool> running_{false};
+    std::thread captureThread_;
+    std::thread playbackThread_;
+};
+
+// Factory
+std::unique_ptr<AudioEngine> AudioEngine::create(const Config& config) {
+    return std::make_unique<AlsaAudioEngine>(config);
+}
+
+AlsaAudioEngine::AlsaAudioEngine(const Config& config)
+    : AudioPipeline(config)
+    , deviceSampleRate_(config.sampleRate > 0 ? config.sampleRate : kOpusSampleRate) {
+
+    // Two callback periods of device latency, like a typical IO buffer
+    int periodFrames = config.framesPerBuffer > 0 ? config.framesPerBuffer : kOpusFrameSize;
+    latencyUs_ = static_cast<unsigned int>(2000000LL * periodFrames / deviceSampleRate_);
+
+    // Capture timestamps are CLOCK_MONOTONIC nanoseconds
+    setHostClockRate(1e9);
+    setDeviceSampleRates(deviceSampleRate_, deviceSampleRate_);
+}
+
+AlsaAudioEngine::~AlsaAudioEngine() {
+    shutdown();
+
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+    closeDevices();
+}
+
+bool AlsaAudioEngine::startDevice() {
+    std::lock_guard<std::mutex> lock(deviceMutex_);
+
+    if (running_) {
+        return true;
+    }
+
+    capturePcm_ = openDevice(config_.inputDevice, SND_PCM_STREAM_CAPTURE, capturePeriod_);
+    playbackPcm_ = openDevice(config_.outputDevice, SND_PCM_STREAM_PLAYBACK, playbackPeriod_);
+    if (!capturePcm_ || !playbackPcm_) {
+        closeDevices();
+        return false;
+    }
+
+    running_ = true;
+    if (config_.floatDeviceFormat) {
+        captureThread_ = std::thread(&AlsaAudioEngine::captureLoop<float>, this);
+        playbackThread_ = std::thread(&AlsaAudioEngine::playbackLoop<float>, this);
+    } else {
+        captureThread_ = std::thread(&AlsaAudioEngine::captureLoop<int16_t>, this);
+        playbackThread_ = std::thread(&AlsaAudioEngine::playbackLoop<int16_t>, this);
+    }
+    return true;
+}
+
+snd_pcm_t* AlsaAudioEngine::openDevice(const std::string& name, snd_pcm_stream_t stream,
+                                       snd_pcm_uframes_t& periodFrames) {
+    const char* direction = stream == SND_PCM_STREAM_CAPTURE ? "capture" : "playback";
+
+    snd_pcm_t* pcm = nullptr;
+    int err = snd_pcm_open(&pcm, name.c_str(), stream, 0);
+    if (err < 0) {
+        std::fprintf(stderr, "[AudioEngine] Cannot open %s device '%s': %s\n",
+                     direction, name.c_str(), snd_strerror(err));
+        return nullptr;
+    }
+
+    // Mono S16 or FLOAT at the configured rate; let alsa-lib convert if the hardware can't
+    err = snd_pcm_set_params(pcm,
+                             config_.floatDeviceFormat ? SND_PCM_FORMAT_FLOAT_LE : SND_PCM_FORMAT_S16_LE,
+                             SND_PCM_ACCESS_RW_INTERLEAVED,
+                             1,
+                             static_cast<unsigned int>(deviceSampleRate_),
+                             1,  // Allow software resampling
+                             latencyUs_);
+    if (err < 0) {
+        std::fprintf(stderr, "[AudioEngine] Cannot configure %s device '%s': %s\n",
+                     direction, name.c_str(), snd_strerror(err));
+        snd_pcm_close(pcm);
+        return nullptr;
+    }
+
+    snd_pcm_uframes_t bufferFrames = 0;
+    err = snd_pcm_get_params(pcm, &bufferFrames, &periodFrames);
+    if (err < 0 || periodFrames == 0) {
+        periodFrames = static_cast<snd_pcm_uframes_t>(kOpusFrameSize);
+    }
+
+    return pcm;
+}
+
+void AlsaAudioEngine::closeDevices() {
+    // Blocking reads/writes return every period, so the threads exit promptly
+    running_ = false;
+
+    if (captureThread_.joinable()) {
+        captureThread_.join();
+    }
+    if (playbackThread_.joinable()) {
+        playbackThread_.join();
+    }
+
+    if (capturePcm_) {
+        snd_pcm_drop(capturePcm_);
+        snd_pcm_close(capturePcm_);
+        capturePcm_ = nullptr;
+    }
+    if (playbackPcm_) {
+        snd_pcm_drop(playbackPcm_);
+        snd_pcm_close(playbackPcm_);
+        playbackPcm_ = nullptr;
+    }
+}
+
+uint64_t AlsaAudioEngine::monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+template <typename Sample>
+void AlsaAudioEngine::captureLoop() {
+    pthread_setname_np(pthread_self(), "sayses-capture");
+    setThreadPriority();
+
+    // Allocated once; the loop itself never allocates
+    std::vector<Sample> buffer(capturePeriod_);
+
+    while (running_) {
+        snd_pcm_sframes_t frames = snd_pcm_readi(capturePcm_, buffer.data(), capturePeriod_);
+        if (frames < 0) {
+            if (!running_) {
+                break;
+            }
+            // Overrun or suspend: recover and restart the stream
+            if (snd_pcm_recover(capturePcm_, static_cast<int>(frames), 1) < 0) {
+                std::fprintf(stderr, "[AudioEngine] Capture failed: %s\n",
+                             snd_strerror(static_cast<int>(frames)));
+                break;
+            }
+            continue;
+        }
+        if (frames == 0) {
+            continue;
+        }
+
+        // The first sample was captured (frames + still buffered) samples ago
+        uint64_t hostTime = monotonicNanos();
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(capturePcm_, &delay) < 0 || delay < 0) {
+            delay = 0;
+        }
+        uint64_t age = static_cast<uint64_t>(frames + delay) * 1000000000ULL /
+                       static_cast<uint64_t>(deviceSampleRate_);
+        hostTime = hostTime > age ? hostTime - age : 0;
+
+        onCaptureAudio(buffer.data(), static_cast<size_t>(frames), hostTime);
+    }
+}
+
+template <typename Sample>
+void AlsaAudioEngine::playbackLoop() {
+    pthread_setname_np(pthread_self(), "sayses-playback");
+    setThreadPriority();
+
+    // Allocated once; the loop itself never allocates
+    std::vector<Sample> buffer(playbackPeriod_);
+
+    while (running_) {
+        onPlaybackAudio(buffer.data(), buffer.size());
+
+        // Blocking write paces the loop at the device rate
+        size_t written = 0;
+        while (written < buffer.size() && running_) {
+            snd_pcm_sframes_t frames = snd_pcm_writei(playbackPcm_, buffer.data() + written,
+                                                      buffer.size() - written);
+            if (frames < 0) {
+                if (!running_) {
+                    break;
+                }
+                // Underrun or suspend: recover and keep going
+                if (snd_pcm_recover(playbackPcm_, static_cast<int>(frames), 1) < 0) {
+                    std::fprintf(stderr, "[AudioEngine] Playback failed: %s\n",
+                                 snd_strerror(static_cast<int>(frames)));
+                    return;
+                }
+                continue;
+            }
+            written += static_cast<size_t>(frames);
+        }
+    }
+}
+
+}  // namespace sayses
@@ -0,0 +1,465 @@
+/**
+ * Audio Kernels
+ * Vectorized sample conversion, mixing and analysis helpers shared by the audio pipeline
+ * NEON on ARM, SSE2 (plus AVX where enabled) on x86, scalar fallback elsewhere
+ */
+
+#pragma once
+
+#include "audio_features.h"
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SAYSES_KERNELS_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAYSES_KERNELS_SSE2 1
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SAYSES_KERNELS_AVX 1
+#if defined(__FMA__)
+#define SAYSES_KERNELS_FMA 1
+#endif
+#endif
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace sayses {
+namespace kernels {
+
+constexpr float kInt16ToFloat = 1.0f / 32768.0f;
+constexpr float kFloatToInt16 = 32767.0f;
+
+/**
+ * Convert int16 PCM to float in [-1.0, 1.0).
+ */
+inline void int16ToFloat(const int16_t* input, float* output, size_t frames) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t scale = vdupq_n_f32(kInt16ToFloat);
+    for (; i + 8 <= frames; i += 8) {
+        int16x8_t s = vld1q_s16(input + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(output + i, vmulq_f32(lo, scale));
+        vst1q_f32(output + i + 4, vmulq_f32(hi, scale));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 scale = _mm_set1_ps(kInt16ToFloat);
+    for (; i + 8 <= frames; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        // Sign-extend by interleaving into the high half and shifting back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    for (; i < frames; ++i) {
+        output[i] = input[i] * kInt16ToFloat;
+    }
+}
+
+/**
+ * Convert float PCM to int16 with saturation at +/-1.0.
+ */
+inline void floatToInt16(const float* input, int16_t* output, size_t frames) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t scale = vdupq_n_f32(kFloatToInt16);
+    for (; i + 8 <= frames; i += 8) {
+        int32x4_t lo = vcvtq_s32_f32(vmulq_f32(vld1q_f32(input + i), scale));
+        int32x4_t hi = vcvtq_s32_f32(vmulq_f32(vld1q_f32(input + i + 4), scale));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 scale = _mm_set1_ps(kFloatToInt16);
+    const __m128 maxVal = _mm_set1_ps(kFloatToInt16);
+    const __m128 minVal = _mm_set1_ps(-kFloatToInt16);
+    for (; i + 8 <= frames; i += 8) {
+        // Clamp before conversion: cvttps returns INT_MIN on overflow
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scale), minVal), maxVal);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(input + i + 4), scale), minVal), maxVal);
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+#endif
+    for (; i < frames; ++i) {
+        float sample = input[i];
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        output[i] = static_cast<int16_t>(sample * kFloatToInt16);
+    }
+}
+
+/**
+ * Clamp float PCM to [-1.0, 1.0] in place (what floatToInt16 saturates to).
+ */
+inline void clip(float* buffer, size_t frames) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t maxVal = vdupq_n_f32(1.0f);
+    const float32x4_t minVal = vdupq_n_f32(-1.0f);
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(buffer + i, vminq_f32(vmaxq_f32(vld1q_f32(buffer + i), minVal), maxVal));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 maxVal = _mm_set1_ps(1.0f);
+    const __m128 minVal = _mm_set1_ps(-1.0f);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buffer + i), minVal), maxVal));
+    }
+#endif
+    for (; i < frames; ++i) {
+        if (buffer[i] > 1.0f) buffer[i] = 1.0f;
+        if (buffer[i] < -1.0f) buffer[i] = -1.0f;
+    }
+}
+
+/**
+ * Mix: dst[i] += src[i].
+ */
+inline void accumulate(float* dst, const float* src, size_t frames) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+    }
+#elif defined(SAYSES_KERNELS_AVX)
+    for (; i + 8 <= frames; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+/**
+ * Mix with gain: dst[i] += src[i] * gain (fused multiply-add where available).
+ */
+inline void accumulateScaled(float* dst, const float* src, size_t frames, float gain) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= frames; i += 4) {
+#if defined(__ARM_FEATURE_FMA)
+        vst1q_f32(dst + i, vfmaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+#else
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+#endif
+    }
+#elif defined(SAYSES_KERNELS_AVX)
+    const __m256 g = _mm256_set1_ps(gain);
+    for (; i + 8 <= frames; i += 8) {
+#if defined(SAYSES_KERNELS_FMA)
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), g, _mm256_loadu_ps(dst + i)));
+#else
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i),
+                                                _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+#endif
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+/**
+ * Mix with a gain ramp: dst[i] += src[i] * g[i], where g moves linearly
+ * from startGain to endGain and reaches endGain on the last sample.
+ */
+inline void accumulateScaledRamp(float* dst, const float* src, size_t frames,
+                                 float startGain, float endGain) {
+    if (frames == 0) {
+        return;
+    }
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    float32x4_t gain = {startGain + step, startGain + 2 * step, startGain + 3 * step, startGain + 4 * step};
+    const float32x4_t inc = vdupq_n_f32(4 * step);
+    for (; i + 4 <= frames; i += 4) {
+#if defined(__ARM_FEATURE_FMA)
+        vst1q_f32(dst + i, vfmaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+#else
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+#endif
+        gain = vaddq_f32(gain, inc);
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    __m128 gain = _mm_setr_ps(startGain + step, startGain + 2 * step, startGain + 3 * step, startGain + 4 * step);
+    const __m128 inc = _mm_set1_ps(4 * step);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), gain)));
+        gain = _mm_add_ps(gain, inc);
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[i] += src[i] * (startGain + step * static_cast<float>(i + 1));
+    }
+}
+
+/**
+ * Largest absolute sample value.
+ */
+inline float maxAbs(const float* src, size_t frames) {
+    float peak = 0.0f;
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= frames; i += 4) {
+        acc = vmaxq_f32(acc, vabsq_f32(vld1q_f32(src + i)));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    peak = std::fmax(std::fmax(lanes[0], lanes[1]), std::fmax(lanes[2], lanes[3]));
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= frames; i += 4) {
+        acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(src + i), absMask));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    peak = std::fmax(std::fmax(lanes[0], lanes[1]), std::fmax(lanes[2], lanes[3]));
+#endif
+    for (; i < frames; ++i) {
+        peak = std::fmax(peak, std::fabs(src[i]));
+    }
+    return peak;
+}
+
+/**
+ * Multiply by a gain that moves linearly from startGain to endGain,
+ * reaching endGain on the last sample.
+ */
+inline void applyGainRamp(float* buffer, size_t frames, float startGain, float endGain) {
+    if (frames == 0) {
+        return;
+    }
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    float32x4_t gain = {startGain + step, startGain + 2 * step, startGain + 3 * step, startGain + 4 * step};
+    const float32x4_t inc = vdupq_n_f32(4 * step);
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), gain));
+        gain = vaddq_f32(gain, inc);
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    __m128 gain = _mm_setr_ps(startGain + step, startGain + 2 * step, startGain + 3 * step, startGain + 4 * step);
+    const __m128 inc = _mm_set1_ps(4 * step);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), gain));
+        gain = _mm_add_ps(gain, inc);
+    }
+#endif
+    for (; i < frames; ++i) {
+        buffer[i] *= startGain + step * static_cast<float>(i + 1);
+    }
+}
+
+/**
+ * Multiply by a constant gain.
+ */
+inline void applyGain(float* buffer, size_t frames, float gain) {
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), g));
+    }
+#elif defined(SAYSES_KERNELS_AVX)
+    const __m256 g = _mm256_set1_ps(gain);
+    for (; i + 8 <= frames; i += 8) {
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i), g));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), g));
+    }
+#endif
+    for (; i < frames; ++i) {
+        buffer[i] *= gain;
+    }
+}
+
+/**
+ * Sum of a[i] * b[i] (FIR filter taps against a sample window).
+ */
+inline float dotProduct(const float* a, const float* b, size_t frames) {
+    float sum = 0.0f;
+    size_t i = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= frames; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for (; i + 4 <= frames; i += 4) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(SAYSES_KERNELS_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= frames; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i + 4 <= frames; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < frames; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/**
+ * Single pass over an int16 frame: RMS, peak, zero-crossing rate and
+ * clipped-sample count. Replaces separate level/VAD/preprocessor loops.
+ * Sums of squares are exact (64-bit integer accumulation).
+ */
+inline AudioFrameFeatures analyzeFrame(const int16_t* input, size_t frames) {
+    AudioFrameFeatures features;
+    if (frames == 0) {
+        return features;
+    }
+
+    uint64_t sumSquares = 0;
+    int32_t maxSample = 0;
+    int32_t minSample = 0;
+    uint32_t crossings = 0;
+    uint32_t clipped = 0;
+    size_t i = 0;
+
+    // Each step covers samples [i, i + 8) and the sample pairs (i + k, i + k + 1),
+    // so the vector loop stops one sample early to keep the last load in range
+#if defined(SAYSES_KERNELS_NEON)
+    int64x2_t sumAcc = vdupq_n_s64(0);
+    int16x8_t maxAcc = vdupq_n_s16(0);
+    int16x8_t minAcc = vdupq_n_s16(0);
+    uint32x4_t crossAcc = vdupq_n_u32(0);
+    uint32x4_t clipAcc = vdupq_n_u32(0);
+    const int16x8_t clipHigh = vdupq_n_s16(32767);
+    const int16x8_t clipLow = vdupq_n_s16(-32767);
+    for (; i + 9 <= frames; i += 8) {
+        int16x8_t s = vld1q_s16(input + i);
+        int16x8_t next = vld1q_s16(input + i + 1);
+        sumAcc = vpadalq_s32(sumAcc, vmull_s16(vget_low_s16(s), vget_low_s16(s)));
+        sumAcc = vpadalq_s32(sumAcc, vmull_s16(vget_high_s16(s), vget_high_s16(s)));
+        maxAcc = vmaxq_s16(maxAcc, s);
+        minAcc = vminq_s16(minAcc, s);
+        uint16x8_t clip = vorrq_u16(vcgeq_s16(s, clipHigh), vcleq_s16(s, clipLow));
+        clipAcc = vpadalq_u16(clipAcc, vshrq_n_u16(clip, 15));
+        uint16x8_t signFlip = vreinterpretq_u16_s16(veorq_s16(s, next));
+        crossAcc = vpadalq_u16(crossAcc, vshrq_n_u16(signFlip, 15));
+    }
+    int64_t sums[2];
+    vst1q_s64(sums, sumAcc);
+    sumSquares = static_cast<uint64_t>(sums[0] + sums[1]);
+    int16_t maxLanes[8];
+    int16_t minLanes[8];
+    uint32_t crossLanes[4];
+    uint32_t clipLanes[4];
+    vst1q_s16(maxLanes, maxAcc);
+    vst1q_s16(minLanes, minAcc);
+    vst1q_u32(crossLanes, crossAcc);
+    vst1q_u32(clipLanes, clipAcc);
+    for (int lane = 0; lane < 8; ++lane) {
+        maxSample = std::max<int32_t>(maxSample, maxLanes[lane]);
+        minSample = std::min<int32_t>(minSample, minLanes[lane]);
+    }
+    for (int lane = 0; lane < 4; ++lane) {
+        crossings += crossLanes[lane];
+        clipped += clipLanes[lane];
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i clipHigh = _mm_set1_epi16(32766);
+    const __m128i clipLow = _mm_set1_epi16(-32766);
+    __m128i sumAcc = zero;
+    __m128i maxAcc = zero;
+    __m128i minAcc = zero;
+    __m128i crossAcc = zero;
+    __m128i clipAcc = zero;
+    for (; i + 9 <= frames; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 1));
+        // Pairwise squares fit in 32 bits when read as unsigned (max 2 * 32768^2 = 2^31)
+        __m128i squares = _mm_madd_epi16(s, s);
+        sumAcc = _mm_add_epi64(sumAcc, _mm_unpacklo_epi32(squares, zero));
+        sumAcc = _mm_add_epi64(sumAcc, _mm_unpackhi_epi32(squares, zero));
+        maxAcc = _mm_max_epi16(maxAcc, s);
+        minAcc = _mm_min_epi16(minAcc, s);
+        __m128i clip = _mm_or_si128(_mm_cmpgt_epi16(s, clipHigh), _mm_cmplt_epi16(s, clipLow));
+        __m128i signFlip = _mm_srai_epi16(_mm_xor_si128(s, next), 15);
+        // Masks are -1/0; madd folds lane pairs into 32-bit counts
+        crossAcc = _mm_sub_epi32(crossAcc, _mm_madd_epi16(signFlip, ones));
+        clipAcc = _mm_sub_epi32(clipAcc, _mm_madd_epi16(clip, ones));
+    }
+    uint64_t sums[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sumAcc);
+    sumSquares = sums[0] + sums[1];
+    int16_t maxLanes[8];
+    int16_t minLanes[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(maxLanes), maxAcc);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(minLanes), minAcc);
+    for (int lane = 0; lane < 8; ++lane) {
+        maxSample = std::max<int32_t>(maxSample, maxLanes[lane]);
+        minSample = std::min<int32_t>(minSample, minLanes[lane]);
+    }
+    uint32_t crossLanes[4];
+    uint32_t clipLanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(crossLanes), crossAcc);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(clipLanes), clipAcc);
+    for (int lane = 0; lane < 4; ++lane) {
+        crossings += crossLanes[lane];
+        clipped += clipLanes[lane];
+    }
+#endif
+    for (; i < frames; ++i) {
+        int32_t sample = input[i];
+        sumSquares += static_cast<uint64_t>(sample * sample);
+        maxSample = std::max(maxSample, sample);
+        minSample = std::min(minSample, sample);
+        clipped += (sample >= 32767 || sample <= -32767) ? 1 : 0;
+        if (i + 1 < frames) {
+            crossings += ((input[i] ^ input[i + 1]) < 0) ? 1 : 0;
+        }
+    }
+
+    features.rms = static_cast<float>(std::sqrt(static_cast<double>(sumSquares) / frames)) * kInt16ToFloat;
+    features.peak = static_cast<float>(std::max(maxSample, -minSample)) * kInt16ToFloat;
+    features.zeroCrossingRate = frames > 1 ? static_cast<float>(crossings) / (frames - 1) : 0.0f;
+    features.clippedSamples = clipped;
+    return features;
+}
+
+}  // namespace kernels
+}  // namespace sayses
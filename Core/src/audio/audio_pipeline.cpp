@@ -0,0 +1,1225 @@
+/**
+ * AudioPipeline Implementation
+ * Platform-independent audio pipeline shared by all AudioEngine backends
+ *
+ * Features:
+ * - Sample-exact 10/5/2.5ms capture framing with timestamps
+ * - Software echo cancellation (Speex MDF) against the played mix
+ * - Float preprocessor (Denoise, AGC)
+ * - Resampling for Bluetooth (16kHz <-> 48kHz), or processing at the route's rate
+ * - Float-sample mixing with a peak limiter for multi-user playback
+ * - Float render path end to end, int16 or Float32 device I/O
+ * - Per-user audio buffers with adaptive jitter buffering
+ * - Sine-wave crossfade for smooth transitions
+ * - Off-realtime transmit worker and optional render-ahead mixing
+ */
+
+#include "audio_pipeline.h"
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__APPLE__)
+#include <TargetConditionals.h>
+#endif
+#if defined(__APPLE__) || defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sayses {
+
+namespace {
+
+// Opus frames of 10, 5 or 2.5ms; anything else runs at the default 10ms
+int validFrameDuration(int frameDurationUs) {
+    switch (frameDurationUs) {
+        case 10000:
+        case 5000:
+        case kMinFrameDurationUs:
+            return frameDurationUs;
+        default:
+            return kDefaultFrameDurationUs;
+    }
+}
+
+}  // namespace
+
+AudioEngine::Config AudioEngine::lowDelayConfig() {
+    Config config;
+    config.frameDurationUs = kMinFrameDurationUs;
+    config.framesPerBuffer = kOpusSampleRate * kMinFrameDurationUs / 1000000;  // 120 samples
+    config.jitterMinMs = 10;    // A switched LAN jitters by well under a frame
+    config.jitterTargetMs = 20;
+    config.jitterMaxMs = 40;
+    config.renderAheadMs = 0;
+    return config;
+}
+
+AudioPipeline::AudioPipeline(const Config& config)
+    : config_(config)
+    , frameDurationUs_(validFrameDuration(config.frameDurationUs))
+    , resampleInputBuffer_(config.framesPerBuffer * 3)    // Extra space for resampling
+    , playbackOutputBuffer_(kOpusFrameSize)
+    , captureConvertBuffer_(kFormatConvertFrames)
+    , playbackFloatBuffer_(kFormatConvertFrames)
+    , playbackInt16Buffer_(kFormatConvertFrames)
+    , captureFrame_(kOpusFrameSize)
+    , captureInt16Frame_(kOpusFrameSize)
+    , transmitQueue_(static_cast<size_t>(kTransmitQueueMs * 1000 / frameDurationUs_))
+    , playbackFifo_(kPlaybackBlockCapacity)
+    , renderAheadQueue_(config.renderAheadMs > 0
+                        ? static_cast<size_t>(kMaxRenderAheadMs * 1000 / frameDurationUs_) : 1)
+    , echoCancellationEnabled_(config.echoCancellation)
+    , echoResampleBuffer_(kPlaybackBlockCapacity)
+    , echoFarFrame_(kOpusFrameSize)
+    , echoOutFrame_(kOpusFrameSize)
+    , perUserBuffer_(kOpusFrameSize) {
+
+    // Nanosecond host clock until the backend says otherwise
+    setHostClockRate(1e9);
+
+    frameSize_ = frameSizeAt(kOpusSampleRate);
+    duckHoldFrames_ = kDuckHoldMs * 1000 / frameDurationUs_;
+
+    // 48kHz until the backend reports its device rates
+    initProcessing();
+}
+
+AudioPipeline::~AudioPipeline() {
+    shutdown();
+
+    // The backend has closed its device, so no render callback can still hold a snapshot
+    activeTalkers_.store(nullptr);
+}
+
+void AudioPipeline::shutdown() {
+    stopCapture();
+    stopPlayback();
+}
+
+void AudioPipeline::initProcessing() {
+    const int rate = processingRate_.load(std::memory_order_relaxed);
+
+    // Initialize mixer and crossfade
+    mixer_ = FloatMixer::create(static_cast<int>(frameSize_));
+    crossfade_ = Crossfade::create(static_cast<int>(frameSize_));
+
+    // Initialize VAD
+    VoiceActivityDetector::Config vadConfig;
+    vadConfig.sampleRate = rate;
+    vadConfig.threshold = vadThreshold_;
+    vadConfig.holdTimeMs = 300;
+    vad_ = config_.spectralVad ? VoiceActivityDetector::createSpectral(vadConfig)
+                               : VoiceActivityDetector::create(vadConfig);
+
+    // Initialize the preprocessor and echo canceller (created even when
+    // disabled so they can be switched on live)
+    initPreprocessor();
+    initEchoCanceller();
+}
+
+void AudioPipeline::initPreprocessor() {
+    SpeexPreprocessor::Config config;
+    config.sampleRate = processingRate_.load(std::memory_order_relaxed);
+    config.frameSize = static_cast<int>(frameSize_);
+    config.denoiseEnabled = true;
+    config.denoiseLevel = -30;
+    config.agcEnabled = true;
+    config.agcTarget = 30000;      // Like Mumla
+    config.agcMaxGain = 30;
+    config.dereverbEnabled = false;  // Not supported by the float preprocessor
+    config.vadEnabled = false;     // We use our own VAD
+
+    // Float denoise/AGC: cheaper than libspeexdsp's, and unaffected by the
+    // Speex-iOS config.h (shipped FIXED_POINT with USE_SMALLFT, see Podfile)
+    preprocessor_ = SpeexPreprocessor::createFloat(config);
+}
+
+void AudioPipeline::initEchoCanceller() {
+    int tailMs = std::clamp(config_.echoTailMs, 10, kMaxEchoTailMs);
+    echoTailFrames_ = tailMs * 1000 / frameDurationUs_;
+    echoCanceller_ = SpeexEchoCanceller::create(processingRate_.load(std::memory_order_relaxed),
+                                                static_cast<int>(frameSize_), tailMs);
+}
+
+void AudioPipeline::setDeviceSampleRates(int inputRate, int outputRate) {
+    // The render-ahead worker mixes too: park it while the chain is replaced,
+    // then prime a new lead at the new device rate
+    const bool renderAhead = renderAheadRunning_.load();
+    stopRenderAhead();
+
+    inputDeviceSampleRate_ = inputRate;
+    outputDeviceSampleRate_ = outputRate;
+
+    int rate = chooseProcessingRate();
+    if (rate != processingRate_.load(std::memory_order_relaxed)) {
+        processingRate_.store(rate, std::memory_order_relaxed);
+        frameSize_ = frameSizeAt(rate);
+        initProcessing();
+        flushUserBuffers();
+
+        // A partial frame at the old rate can't be completed at the new one
+        captureFrameFill_ = 0;
+    }
+    initResamplers();
+
+    if (renderAhead) {
+        startRenderAhead();
+    }
+}
+
+int AudioPipeline::chooseProcessingRate() const {
+    // Opus codes these rates natively, so a route running at one of them
+    // needs no resampling at all; anything else is processed at 48kHz
+    if (config_.processAtDeviceRate && inputDeviceSampleRate_ == outputDeviceSampleRate_) {
+        switch (inputDeviceSampleRate_) {
+            case 8000:
+            case 12000:
+            case 16000:
+            case 24000:
+                return inputDeviceSampleRate_;
+            default:
+                break;
+        }
+    }
+    return kOpusSampleRate;
+}
+
+size_t AudioPipeline::frameSizeAt(int sampleRate) const {
+    // Whole samples at every supported rate: 20 at 8kHz for 2.5ms
+    return static_cast<size_t>(static_cast<int64_t>(sampleRate) * frameDurationUs_ / 1000000);
+}
+
+void AudioPipeline::flushUserBuffers() {
+    // Buffered audio is at the old rate; senders' next packets recreate the
+    // buffers. Mix states (volume, mute, priority) are kept.
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    std::vector<std::shared_ptr<UserAudioBuffer>> buffers;
+    for (auto& entry : userBuffers_) {
+        buffers.push_back(std::move(entry.second));
+    }
+    userBuffers_.clear();
+
+    for (std::shared_ptr<UserAudioBuffer>& buffer : buffers) {
+        publishTalkersLocked(nullptr, buffer.get());
+        retireLocked(nullptr, std::move(buffer));
+    }
+}
+
+int AudioPipeline::getProcessingSampleRate() const {
+    return processingRate_.load(std::memory_order_relaxed);
+}
+
+void AudioPipeline::setHostClockRate(double ticksPerSecond) {
+    hostTicksPerSample_ = ticksPerSecond / kOpusSampleRate;
+}
+
+void AudioPipeline::initResamplers() {
+    const int rate = processingRate_.load(std::memory_order_relaxed);
+
+    // Only create resamplers if needed (e.g. Bluetooth 16kHz at 48kHz processing)
+    if (inputDeviceSampleRate_ != rate) {
+        inputResampler_ = SpeexResampler::create(
+            1,  // Mono
+            inputDeviceSampleRate_,
+            rate,
+            SpeexResampler::Quality::VoIP
+        );
+    } else {
+        inputResampler_.reset();
+    }
+
+    if (outputDeviceSampleRate_ != rate) {
+        outputResampler_ = SpeexResampler::create(
+            1,  // Mono
+            rate,
+            outputDeviceSampleRate_,
+            SpeexResampler::Quality::VoIP
+        );
+    } else {
+        outputResampler_.reset();
+    }
+
+    // The echo reference is kept at the processing rate like the capture it is cancelled from
+    if (outputDeviceSampleRate_ != rate) {
+        echoReferenceResampler_ = SpeexResampler::create(
+            1,  // Mono
+            outputDeviceSampleRate_,
+            rate,
+            SpeexResampler::Quality::VoIP
+        );
+    } else {
+        echoReferenceResampler_.reset();
+    }
+
+    // The reference delay follows the callback sizes the devices actually
+    // use on the new route (see updateEchoDelay)
+    echoInputCallback_.store(0, std::memory_order_relaxed);
+    echoOutputCallback_.store(0, std::memory_order_relaxed);
+    echoResetPending_.store(true, std::memory_order_release);
+
+    // Anything left in the playback FIFO was rendered for the old rate
+    playbackFifoFlush_.store(true, std::memory_order_release);
+}
+
+void AudioPipeline::setThreadPriority() {
+#if TARGET_OS_IPHONE || defined(__linux__)
+    // Set thread priority to real-time audio priority
+    // Similar to Android's THREAD_PRIORITY_URGENT_AUDIO
+    // (on Linux this needs RLIMIT_RTPRIO and is silently skipped otherwise)
+    pthread_t thread = pthread_self();
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    pthread_setschedparam(thread, SCHED_FIFO, &param);
+#endif
+}
+
+bool AudioPipeline::startCapture(AudioCallback callback) {
+    return startCapture(FrameCallback(
+        [callback = std::move(callback)](const int16_t* data, size_t frames, const CaptureTimestamp&) {
+            callback(data, frames);
+        }));
+}
+
+bool AudioPipeline::startCapture(FrameCallback callback) {
+    // Converted on the transmit worker, never on the audio thread
+    return startCapture(FloatFrameCallback(
+        [callback = std::move(callback), samples = std::vector<int16_t>(kOpusFrameSize)](
+            const float* data, size_t frames, const CaptureTimestamp& timestamp) mutable {
+            kernels::floatToInt16(data, samples.data(), frames);
+            callback(samples.data(), frames, timestamp);
+        }));
+}
+
+bool AudioPipeline::startCapture(FloatFrameCallback callback) {
+
+    if (capturing_) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(callbackSetupMutex_);
+        captureCallbackStorage_ = std::make_unique<FloatFrameCallback>(std::move(callback));
+        captureCallbackPtr_.store(captureCallbackStorage_.get(), std::memory_order_release);
+    }
+
+    if (!startDevice()) {
+        return false;
+    }
+
+    // Start a fresh frame stream (the capture callback is idle until capturing_)
+    captureFrameFill_ = 0;
+    captureFrameIndex_ = 0;
+    startTransmitWorker();
+
+    capturing_ = true;
+    return true;
+}
+
+void AudioPipeline::stopCapture() {
+    if (!capturing_) {
+        return;
+    }
+
+    capturing_ = false;
+
+    // Only the transmit worker invokes the callback, so once it has joined
+    // the callback can be released without waiting on the audio thread
+    stopTransmitWorker();
+
+    {
+        std::lock_guard<std::mutex> lock(callbackSetupMutex_);
+        captureCallbackPtr_.store(nullptr, std::memory_order_release);
+        captureCallbackStorage_.reset();
+    }
+}
+
+bool AudioPipeline::isCapturing() const {
+    return capturing_;
+}
+
+uint64_t AudioPipeline::getCaptureDroppedFrames() const {
+    return transmitDroppedFrames_.load(std::memory_order_relaxed);
+}
+
+void AudioPipeline::startTransmitWorker() {
+    if (transmitRunning_.exchange(true)) {
+        return;
+    }
+
+    // Frames left over from a previous capture session are stale. Drop them
+    // here, before capturing_ is set, so no frame of the new session is lost
+    while (transmitQueue_.readSlot()) {
+        transmitQueue_.release();
+    }
+
+    if (!synchronousTransmit_) {
+        transmitThread_ = std::thread(&AudioPipeline::transmitLoop, this);
+    }
+}
+
+void AudioPipeline::setSynchronousTransmit(bool synchronous) {
+    synchronousTransmit_ = synchronous;
+}
+
+void AudioPipeline::stopTransmitWorker() {
+    if (!transmitRunning_.exchange(false)) {
+        return;
+    }
+    if (transmitThread_.joinable()) {
+        transmitThread_.join();
+    }
+}
+
+void AudioPipeline::transmitLoop() {
+#if defined(__APPLE__)
+    // Above UI work, but not realtime: encoder or network stalls must never
+    // compete with the audio I/O thread
+    pthread_setname_np("SAYses Transmit");
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+#elif defined(__linux__)
+    pthread_setname_np(pthread_self(), "sayses-transmit");
+#endif
+
+    // Poll rather than be woken: a notify from the capture thread could make
+    // a futex/Mach syscall on the audio thread every frame. Polling a few
+    // times per frame bounds the added delay to a fraction of a frame.
+    const auto pollInterval = std::chrono::microseconds(frameDurationUs_ / kTransmitPollsPerFrame);
+
+    while (transmitRunning_.load(std::memory_order_acquire)) {
+        if (!deliverTransmitFrame()) {
+            std::this_thread::sleep_for(pollInterval);
+        }
+    }
+}
+
+bool AudioPipeline::deliverTransmitFrame() {
+    const CaptureFrame* frame = transmitQueue_.readSlot();
+    if (!frame) {
+        return false;
+    }
+
+    FloatFrameCallback* callback = captureCallbackPtr_.load(std::memory_order_acquire);
+    if (callback) {
+        (*callback)(frame->samples, frame->frames, frame->timestamp);
+    }
+    transmitQueue_.release();
+    return true;
+}
+
+bool AudioPipeline::startPlayback(PlaybackCallback callback) {
+    if (playing_) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(callbackSetupMutex_);
+        playbackCallbackStorage_ = std::make_unique<PlaybackCallback>(std::move(callback));
+        playbackCallbackPtr_.store(playbackCallbackStorage_.get(), std::memory_order_release);
+    }
+
+    if (!startDevice()) {
+        return false;
+    }
+
+    startRenderAhead();
+    playing_ = true;
+    return true;
+}
+
+void AudioPipeline::stopPlayback() {
+    if (!playing_) {
+        return;
+    }
+
+    playing_ = false;
+
+    {
+        std::lock_guard<std::mutex> lock(callbackSetupMutex_);
+        playbackCallbackPtr_.store(nullptr, std::memory_order_release);
+        // Small delay to ensure audio thread sees the null pointer
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        playbackCallbackStorage_.reset();
+    }
+
+    // The render callback is idle now, so the worker's queue can be torn down
+    stopRenderAhead();
+}
+
+bool AudioPipeline::isPlaying() const {
+    return playing_;
+}
+
+void AudioPipeline::setVadEnabled(bool enabled) {
+    // VAD is always running, this controls whether we report it
+}
+
+void AudioPipeline::setEchoCancellationEnabled(bool enabled) {
+    echoCancellationEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void AudioPipeline::setVadThreshold(float threshold) {
+    vadThreshold_ = threshold;
+    if (vad_) {
+        vad_->setThreshold(threshold);
+    }
+}
+
+bool AudioPipeline::isVoiceDetected() const {
+    return voiceDetected_;
+}
+
+float AudioPipeline::getInputLevel() const {
+    return inputFeatures_.load().rms;
+}
+
+AudioFrameFeatures AudioPipeline::getInputFeatures() const {
+    return inputFeatures_.load();
+}
+
+uint64_t AudioPipeline::getInputClippedSamples() const {
+    return inputClippedSamples_.load(std::memory_order_relaxed);
+}
+
+void AudioPipeline::setPreprocessingEnabled(bool enabled) {
+    preprocessingEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+// User audio management
+void AudioPipeline::addUserAudio(uint32_t userId, const int16_t* samples, size_t frames, int64_t sequence) {
+    // Lock-free handoff to the render thread (outside the map lock)
+    userBufferFor(userId)->addSamples(samples, frames, sequence, false);
+}
+
+void AudioPipeline::addUserAudio(uint32_t userId, const float* samples, size_t frames, int64_t sequence) {
+    userBufferFor(userId)->addSamples(samples, frames, sequence, false);
+}
+
+std::shared_ptr<UserAudioBuffer> AudioPipeline::userBufferFor(uint32_t userId) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+
+    auto it = userBuffers_.find(userId);
+    if (it == userBuffers_.end()) {
+        // Create new buffer for user
+        UserAudioBuffer::Config config;
+        config.sampleRate = processingRate_.load(std::memory_order_relaxed);
+        config.frameSize = static_cast<int>(frameSizeAt(config.sampleRate));
+        config.minBufferMs = config_.jitterMinMs;
+        config.maxBufferMs = config_.jitterMaxMs;
+        config.targetBufferMs = config_.jitterTargetMs;
+
+        it = userBuffers_.emplace(userId, UserAudioBuffer::create(userId, config)).first;
+        mixStateLocked(userId);
+    }
+
+    // Make sure the render thread mixes this user, and drop idle talkers
+    publishTalkersLocked(it->second.get());
+    return it->second;
+}
+
+void AudioPipeline::removeUser(uint32_t userId) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    auto it = userBuffers_.find(userId);
+    if (it == userBuffers_.end()) {
+        return;
+    }
+
+    // Unpublish first, then free the buffer once the render thread can't see it
+    std::shared_ptr<UserAudioBuffer> buffer = std::move(it->second);
+    userBuffers_.erase(it);
+    publishTalkersLocked(nullptr, buffer.get());
+    retireLocked(nullptr, std::move(buffer));
+
+    auto mixIt = userMixStates_.find(userId);
+    if (mixIt != userMixStates_.end()) {
+        std::shared_ptr<UserMixState> mix = std::move(mixIt->second);
+        userMixStates_.erase(mixIt);
+        retireLocked(nullptr, std::move(mix));
+    }
+}
+
+void AudioPipeline::publishTalkersLocked(UserAudioBuffer* joining, UserAudioBuffer* leaving) {
+    const TalkerList* current = activeTalkersStorage_.get();
+
+    // Rebuild only when membership changes: a user joins, a listed user
+    // leaves, or a listed talker has drained and gone idle
+    bool rebuild = !current;
+    bool joiningListed = false;
+    if (current) {
+        for (const TalkerList::Talker& talker : current->talkers) {
+            if (talker.buffer == joining) {
+                joiningListed = true;
+            } else if (talker.buffer == leaving || !talker.buffer->isActive()) {
+                rebuild = true;
+            }
+        }
+    }
+    if (joining && !joiningListed) {
+        rebuild = true;
+    }
+
+    if (!rebuild) {
+        reclaimRetiredLocked();
+        return;
+    }
+
+    auto next = std::make_unique<TalkerList>();
+    next->talkers.reserve(userBuffers_.size());
+    for (auto& [userId, buffer] : userBuffers_) {
+        if (buffer.get() == joining || buffer->isActive()) {
+            next->talkers.push_back({buffer.get(), mixStateLocked(userId)});
+        }
+    }
+
+    std::unique_ptr<const TalkerList> previous = std::move(activeTalkersStorage_);
+    activeTalkersStorage_ = std::move(next);
+    activeTalkers_.store(activeTalkersStorage_.get());
+
+    retireLocked(std::move(previous), nullptr);
+}
+
+void AudioPipeline::retireLocked(std::unique_ptr<const TalkerList> list,
+                                   std::shared_ptr<void> object) {
+    if (list || object) {
+        // Anything the render thread enters from now on sees the new snapshot
+        uint64_t epoch = globalEpoch_.fetch_add(1) + 1;
+        retired_.push_back(Retired{epoch, std::move(list), std::move(object)});
+    }
+    reclaimRetiredLocked();
+}
+
+void AudioPipeline::reclaimRetiredLocked() {
+    if (retired_.empty()) {
+        return;
+    }
+
+    uint64_t renderEpoch = renderEpoch_.load();
+    auto reclaimable = [renderEpoch](const Retired& item) {
+        return renderEpoch == 0 || renderEpoch >= item.epoch;
+    };
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), reclaimable),
+                   retired_.end());
+}
+
+UserMixState* AudioPipeline::mixStateLocked(uint32_t userId) {
+    std::shared_ptr<UserMixState>& mix = userMixStates_[userId];
+    if (!mix) {
+        mix = std::make_shared<UserMixState>();
+    }
+    return mix.get();
+}
+
+const TalkerList* AudioPipeline::enterRenderEpoch() {
+    // Sequentially consistent so that a writer either sees us inside the
+    // epoch, or we see the snapshot it published before retiring the old one
+    renderEpoch_.store(globalEpoch_.load());
+    return activeTalkers_.load();
+}
+
+void AudioPipeline::leaveRenderEpoch() {
+    renderEpoch_.store(0);
+}
+
+void AudioPipeline::notifyUserTalkingEnded(uint32_t userId) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    auto it = userBuffers_.find(userId);
+    if (it != userBuffers_.end()) {
+        it->second->notifyTalkingEnded();
+    }
+    publishTalkersLocked(nullptr);
+}
+
+// Per-user mix controls
+void AudioPipeline::setUserVolume(uint32_t userId, float gain) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    mixStateLocked(userId)->volume.store(std::clamp(gain, 0.0f, kMaxUserVolume),
+                                         std::memory_order_relaxed);
+}
+
+void AudioPipeline::setUserMuted(uint32_t userId, bool muted) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    mixStateLocked(userId)->muted.store(muted, std::memory_order_relaxed);
+}
+
+void AudioPipeline::setUserPrioritySpeaker(uint32_t userId, bool priority) {
+    std::lock_guard<std::mutex> lock(userBuffersMutex_);
+    mixStateLocked(userId)->priority.store(priority, std::memory_order_relaxed);
+}
+
+void AudioPipeline::setPriorityDuckingLevel(float gain) {
+    duckingLevel_.store(std::clamp(gain, 0.0f, 1.0f), std::memory_order_relaxed);
+}
+
+bool AudioPipeline::startMixedPlayback() {
+    if (playing_) {
+        return true;  // Already playing
+    }
+
+    if (!startDevice()) {
+        return false;
+    }
+
+    startRenderAhead();
+    playing_ = true;
+    return true;
+}
+
+int AudioPipeline::getRenderAheadMs() const {
+    return renderAheadBlocks_.load(std::memory_order_relaxed) * frameDurationUs_ / 1000;
+}
+
+void AudioPipeline::startRenderAhead() {
+    if (config_.renderAheadMs <= 0 || renderAheadRunning_.exchange(true)) {
+        return;
+    }
+
+    // Until the device reports otherwise, expect callbacks of framesPerBuffer
+    renderAheadMaxCallback_.store(static_cast<size_t>(std::max(config_.framesPerBuffer, 1)));
+    renderAheadBlockFrames_ = frameSizeAt(outputDeviceSampleRate_);
+    int blocks = renderAheadCallbackBlocks(renderAheadBlockFrames_) +
+                 (config_.renderAheadMs * 1000 + frameDurationUs_ - 1) / frameDurationUs_;
+    blocks = std::min(blocks, static_cast<int>(renderAheadQueue_.capacity()));
+    renderAheadBlocks_.store(blocks);
+
+    // Prime the lead before the render callback can see playing_; the worker
+    // takes over as the only producer once it starts
+    fillRenderAhead(blocks);
+    renderAheadThread_ = std::thread(&AudioPipeline::renderAheadLoop, this);
+}
+
+void AudioPipeline::stopRenderAhead() {
+    if (!renderAheadRunning_.exchange(false)) {
+        return;
+    }
+    if (renderAheadThread_.joinable()) {
+        renderAheadThread_.join();
+    }
+
+    // Neither side is running: drop whatever was mixed ahead
+    renderAheadBlock_ = nullptr;
+    renderAheadPos_ = 0;
+    while (renderAheadQueue_.readSlot()) {
+        renderAheadQueue_.release();
+    }
+    renderAheadBlocks_.store(0);
+}
+
+int AudioPipeline::renderAheadCallbackBlocks(size_t blockFrames) const {
+    // Blocks a whole callback of the largest size seen takes out of the queue
+    size_t callbackFrames = renderAheadMaxCallback_.load(std::memory_order_relaxed);
+    blockFrames = std::max<size_t>(blockFrames, 1);
+    return static_cast<int>((callbackFrames + blockFrames - 1) / blockFrames);
+}
+
+void AudioPipeline::renderAheadLoop() {
+    setThreadPriority();
+
+    // The render callback never wakes the worker (no syscall on the audio
+    // thread); polling a few times per frame keeps the queue topped up
+    const auto pollInterval = std::chrono::microseconds(frameDurationUs_ / kRenderAheadPollsPerFrame);
+    const int maxBlocks = static_cast<int>(renderAheadQueue_.capacity());
+    const int minMargin = (config_.renderAheadMs * 1000 + frameDurationUs_ - 1) / frameDurationUs_;
+    int marginBlocks = minMargin;
+    uint32_t seenUnderruns = renderAheadUnderruns_.load();
+    int stableBlocks = 0;
+
+    while (renderAheadRunning_.load(std::memory_order_acquire)) {
+        // Adapt the margin on top of one callback: grow at once after an
+        // underrun, shrink slowly. The callback part never shrinks within a
+        // session; a device that once asked for that much may again.
+        uint32_t underruns = renderAheadUnderruns_.load(std::memory_order_relaxed);
+        if (underruns != seenUnderruns) {
+            seenUnderruns = underruns;
+            stableBlocks = 0;
+            marginBlocks = std::min(marginBlocks + 1, maxBlocks);
+        } else if (stableBlocks >= kRenderAheadRelaxBlocks) {
+            stableBlocks = 0;
+            marginBlocks = std::max(marginBlocks - 1, minMargin);
+        }
+        int leadBlocks = std::min(renderAheadCallbackBlocks(renderAheadBlockFrames_) + marginBlocks, maxBlocks);
+        renderAheadBlocks_.store(leadBlocks, std::memory_order_relaxed);
+
+        int rendered = fillRenderAhead(leadBlocks);
+        stableBlocks += rendered;
+        if (rendered == 0) {
+            std::this_thread::sleep_for(pollInterval);
+        }
+    }
+}
+
+int AudioPipeline::fillRenderAhead(int leadBlocks) {
+    int rendered = 0;
+    while (renderAheadQueue_.size() < static_cast<size_t>(leadBlocks)) {
+        PlaybackBlock* block = renderAheadQueue_.writeSlot();
+        if (!block) {
+            break;
+        }
+        block->frames = renderPlaybackBlock(block->samples, kPlaybackBlockCapacity);
+        if (block->frames > 0) {
+            renderAheadBlockFrames_ = block->frames;
+        }
+        renderAheadQueue_.publish();
+        rendered++;
+    }
+    return rendered;
+}
+
+uint64_t AudioPipeline::getPlaybackCallbackCount() const {
+    return playbackCallbackCount_.load(std::memory_order_relaxed);
+}
+
+void AudioPipeline::onCaptureAudio(int16_t* data, size_t frames, uint64_t hostTime) {
+    if (!capturing_) {
+        return;
+    }
+    noteLargestCallback(echoInputCallback_, frames);
+
+    // Capture is processed in float: widen in chunks (lossless)
+    const double ticksPerDeviceSample = hostTicksPerSample_ * kOpusSampleRate / inputDeviceSampleRate_;
+    size_t consumed = 0;
+    while (consumed < frames) {
+        size_t chunk = std::min(frames - consumed, captureConvertBuffer_.size());
+        kernels::int16ToFloat(data + consumed, captureConvertBuffer_.data(), chunk);
+
+        uint64_t chunkTime = hostTime != 0
+            ? hostTime + static_cast<uint64_t>(consumed * ticksPerDeviceSample) : 0;
+        processCapturedAudio(captureConvertBuffer_.data(), chunk, chunkTime);
+        consumed += chunk;
+    }
+}
+
+void AudioPipeline::onCaptureAudio(const float* data, size_t frames, uint64_t hostTime) {
+    if (!capturing_) {
+        return;
+    }
+    noteLargestCallback(echoInputCallback_, frames);
+
+    // Each chunk's first sample is that many device samples after the buffer's.
+    // Copied because whole frames are processed in place.
+    const double ticksPerDeviceSample = hostTicksPerSample_ * kOpusSampleRate / inputDeviceSampleRate_;
+    size_t consumed = 0;
+    while (consumed < frames) {
+        size_t chunk = std::min(frames - consumed, captureConvertBuffer_.size());
+        memcpy(captureConvertBuffer_.data(), data + consumed, chunk * sizeof(float));
+
+        uint64_t chunkTime = hostTime != 0
+            ? hostTime + static_cast<uint64_t>(consumed * ticksPerDeviceSample) : 0;
+        processCapturedAudio(captureConvertBuffer_.data(), chunk, chunkTime);
+        consumed += chunk;
+    }
+}
+
+void AudioPipeline::onPlaybackAudio(int16_t* data, size_t frames) {
+    // Zero the buffer first
+    memset(data, 0, frames * sizeof(int16_t));
+
+    // Always increment heartbeat counter (even when not playing)
+    playbackCallbackCount_.fetch_add(1, std::memory_order_relaxed);
+
+    if (!playing_) {
+        return;
+    }
+    noteRenderAheadCallback(frames);
+    noteLargestCallback(echoOutputCallback_, frames);
+
+    // Mix in float; the only int16 conversion is this one at the device
+    size_t served = 0;
+    while (served < frames) {
+        size_t chunk = std::min(frames - served, playbackFloatBuffer_.size());
+        processPlaybackAudio(playbackFloatBuffer_.data(), chunk);
+        kernels::floatToInt16(playbackFloatBuffer_.data(), data + served, chunk);
+        served += chunk;
+    }
+
+    finishPlaybackAudio(data, frames);
+}
+
+void AudioPipeline::onPlaybackAudio(float* data, size_t frames) {
+    std::fill(data, data + frames, 0.0f);
+    playbackCallbackCount_.fetch_add(1, std::memory_order_relaxed);
+
+    if (!playing_) {
+        return;
+    }
+    noteRenderAheadCallback(frames);
+    noteLargestCallback(echoOutputCallback_, frames);
+
+    processPlaybackAudio(data, frames);
+
+    // The legacy playback callback and the echo reference are int16; skip
+    // the conversion when neither is in use
+    if (!playbackCallbackPtr_.load(std::memory_order_acquire) &&
+        !echoCancellationEnabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    size_t served = 0;
+    while (served < frames) {
+        size_t chunk = std::min(frames - served, playbackInt16Buffer_.size());
+        kernels::floatToInt16(data + served, playbackInt16Buffer_.data(), chunk);
+        if (finishPlaybackAudio(playbackInt16Buffer_.data(), chunk)) {
+            // The callback may have changed the samples
+            kernels::int16ToFloat(playbackInt16Buffer_.data(), data + served, chunk);
+        }
+        served += chunk;
+    }
+}
+
+void AudioPipeline::processCapturedAudio(float* data, size_t frames, uint64_t hostTime) {
+    // Stream positions count 48kHz samples whatever the processing rate
+    const uint64_t stride = kOpusSampleRate / processingRate_.load(std::memory_order_relaxed);
+    captureCallbackIndex_ = captureFrameIndex_ + captureFrameFill_ * stride;
+    captureCallbackHostTime_ = hostTime;
+
+    // Step 1: Resample if needed (e.g. Bluetooth 16kHz -> 48kHz), in chunks
+    // so large device buffers are fully consumed
+    if (inputResampler_) {
+        size_t consumed = 0;
+        while (consumed < frames) {
+            size_t inputFrames = frames - consumed;
+            size_t outputFrames = resampleInputBuffer_.size();
+
+            inputResampler_->process(data + consumed, inputFrames,
+                                      resampleInputBuffer_.data(), outputFrames);
+            if (inputFrames == 0 && outputFrames == 0) {
+                break;
+            }
+
+            feedCaptureFramer(resampleInputBuffer_.data(), outputFrames);
+            consumed += inputFrames;
+        }
+    } else {
+        feedCaptureFramer(data, frames);
+    }
+}
+
+void AudioPipeline::feedCaptureFramer(float* samples, size_t frames) {
+    const size_t frameSize = frameSize_;
+    size_t offset = 0;
+
+    // Complete the frame left over from the previous callback
+    if (captureFrameFill_ > 0) {
+        size_t copyFrames = std::min(frames, frameSize - captureFrameFill_);
+        memcpy(captureFrame_.data() + captureFrameFill_, samples, copyFrames * sizeof(float));
+        captureFrameFill_ += copyFrames;
+        offset = copyFrames;
+
+        if (captureFrameFill_ < frameSize) {
+            return;
+        }
+        processCaptureFrame(captureFrame_.data());
+        captureFrameFill_ = 0;
+    }
+
+    // Whole frames are processed straight from the callback buffer
+    while (offset + frameSize <= frames) {
+        processCaptureFrame(samples + offset);
+        offset += frameSize;
+    }
+
+    // Stage the tail for the next callback
+    captureFrameFill_ = frames - offset;
+    memcpy(captureFrame_.data(), samples + offset, captureFrameFill_ * sizeof(float));
+}
+
+void AudioPipeline::processCaptureFrame(float* frame) {
+    CaptureTimestamp timestamp;
+    timestamp.sampleIndex = captureFrameIndex_;
+    timestamp.sampleRate = processingRate_.load(std::memory_order_relaxed);
+    if (captureCallbackHostTime_ != 0) {
+        // Frames staged across callbacks started before the current one
+        double offset = static_cast<double>(static_cast<int64_t>(captureFrameIndex_ - captureCallbackIndex_));
+        timestamp.hostTime = captureCallbackHostTime_ + static_cast<int64_t>(offset * hostTicksPerSample_);
+    }
+    captureFrameIndex_ += frameSizeAt(kOpusSampleRate);  // Stream position is in 48kHz samples
+
+    // Step 2: Cancel the echo of what we played (before denoise/AGC alter the
+    // capture). Speex takes int16, so only this step quantizes, and only
+    // while it actually changes the frame.
+    int16_t* frame16 = captureInt16Frame_.data();
+    if (echoCancellationEnabled_.load(std::memory_order_relaxed) && echoCanceller_) {
+        kernels::floatToInt16(frame, frame16, frameSize_);
+        if (cancelEcho(frame16)) {
+            kernels::int16ToFloat(frame16, frame, frameSize_);
+        }
+    }
+
+    // Step 3: Apply preprocessing (Denoise, AGC)
+    if (preprocessingEnabled_.load(std::memory_order_relaxed) && preprocessor_) {
+        preprocessor_->process(frame, frameSize_);
+    }
+
+    // Step 4: One analysis pass feeds the level meter, VAD and clip stats.
+    // They run on an int16 copy; the frame itself goes on in float.
+    kernels::floatToInt16(frame, frame16, frameSize_);
+    AudioFrameFeatures features = kernels::analyzeFrame(frame16, frameSize_);
+    inputFeatures_.store(features);
+    if (features.clippedSamples > 0) {
+        inputClippedSamples_.fetch_add(features.clippedSamples, std::memory_order_relaxed);
+    }
+
+    // Step 5: Voice Activity Detection
+    if (vad_) {
+        voiceDetected_ = vad_->process(frame16, frameSize_, features);
+    }
+
+    // Step 6: Queue the frame for the transmit worker (bounded, never blocks)
+    CaptureFrame* slot = transmitQueue_.writeSlot();
+    if (!slot) {
+        // Worker has fallen 320ms behind: drop this frame rather than stall
+        transmitDroppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot->timestamp = timestamp;
+    slot->frames = frameSize_;
+    memcpy(slot->samples, frame, frameSize_ * sizeof(float));
+    transmitQueue_.publish();
+
+    // Offline backends: deliver now, in capture order
+    if (synchronousTransmit_) {
+        deliverTransmitFrame();
+    }
+}
+
+bool AudioPipeline::cancelEcho(int16_t* frame) {
+    bool reset = echoResetPending_.exchange(false, std::memory_order_acq_rel);
+    reset |= updateEchoDelay();
+    if (reset) {
+        // New route or callback size: the echo path and the reference timing have changed
+        echoCanceller_->reset();
+        echoReference_.resync();
+    }
+
+    bool farActive = echoReference_.read(echoFarFrame_.data(), frameSize_,
+                                         echoDelaySamples_, echoMaxDrift_);
+
+    // Nothing played for longer than the tail: no echo left to cancel
+    echoSilentFrames_ = farActive ? 0 : std::min(echoSilentFrames_ + 1, echoTailFrames_ + 1);
+    if (echoSilentFrames_ > echoTailFrames_) {
+        return false;
+    }
+
+    if (!echoCanceller_->process(frame, echoFarFrame_.data(), echoOutFrame_.data(), frameSize_)) {
+        return false;
+    }
+    memcpy(frame, echoOutFrame_.data(), frameSize_ * sizeof(int16_t));
+    return true;
+}
+
+bool AudioPipeline::mixTalker(const TalkerList::Talker& talker, float duckGain) {
+    UserMixState* mix = talker.mix;
+
+    // Muted: keep the stream advancing, but skip conversion and mixing
+    if (mix->muted.load(std::memory_order_relaxed)) {
+        talker.buffer->skip(frameSize_);
+        mix->appliedGain = 0.0f;
+        return false;
+    }
+
+    // Use pre-allocated buffer instead of creating new vector
+    size_t readFrames = talker.buffer->readFloat(perUserBuffer_.data(), frameSize_);
+    float gain = mix->volume.load(std::memory_order_relaxed) * duckGain;
+    if (readFrames > 0) {
+        // Ramp from last frame's gain so volume and ducking changes don't click
+        mixer_->add(perUserBuffer_.data(), readFrames, mix->appliedGain, gain);
+    }
+    mix->appliedGain = gain;
+    return readFrames > 0;
+}
+
+size_t AudioPipeline::renderPlaybackBlock(float* output, size_t capacity) {
+    // Step 1: Mix all user audio buffers (float mixing)
+    mixer_->clear();
+
+    // Lock-free: iterate the published snapshot of current talkers only,
+    // so mixing cost scales with who is talking, not who ever joined.
+    // Priority speakers go first so we know whether to duck everyone else.
+    const TalkerList* talkers = enterRenderEpoch();
+    if (talkers) {
+        bool priorityTalking = false;
+        for (const TalkerList::Talker& talker : talkers->talkers) {
+            if (talker.mix->priority.load(std::memory_order_relaxed)) {
+                priorityTalking |= mixTalker(talker, 1.0f);
+            }
+        }
+
+        // Hold the duck across short pauses so other talkers don't pump
+        if (priorityTalking) {
+            duckHoldRemaining_ = duckHoldFrames_;
+        } else if (duckHoldRemaining_ > 0) {
+            duckHoldRemaining_--;
+        }
+        float duckGain = duckHoldRemaining_ > 0
+            ? duckingLevel_.load(std::memory_order_relaxed) : 1.0f;
+
+        for (const TalkerList::Talker& talker : talkers->talkers) {
+            if (!talker.mix->priority.load(std::memory_order_relaxed)) {
+                mixTalker(talker, duckGain);
+            }
+        }
+    }
+    leaveRenderEpoch();
+
+    // Step 2: Get the limited mix, still in float
+    mixer_->getMixed(playbackOutputBuffer_.data(), frameSize_);
+
+    // Step 3: Resample to device rate if needed (e.g. 48kHz -> Bluetooth 16kHz)
+    if (outputResampler_) {
+        size_t inputFrames = frameSize_;
+        size_t outputFrames = capacity;
+
+        outputResampler_->process(playbackOutputBuffer_.data(), inputFrames,
+                                   output, outputFrames);
+        return outputFrames;
+    }
+
+    size_t copyFrames = std::min(capacity, frameSize_);
+    memcpy(output, playbackOutputBuffer_.data(), copyFrames * sizeof(float));
+    return copyFrames;
+}
+
+void AudioPipeline::noteLargestCallback(std::atomic<size_t>& largest, size_t frames) {
+    // Single writer per counter (its audio thread); the seed is reset on a rate change
+    if (frames > largest.load(std::memory_order_relaxed)) {
+        largest.store(frames, std::memory_order_relaxed);
+    }
+}
+
+bool AudioPipeline::updateEchoDelay() {
+    const size_t inputCallback = echoInputCallback_.load(std::memory_order_relaxed);
+    const size_t outputCallback = echoOutputCallback_.load(std::memory_order_relaxed);
+    if (inputCallback == echoInputCallbackSeen_ && outputCallback == echoOutputCallbackSeen_) {
+        return false;
+    }
+    echoInputCallbackSeen_ = inputCallback;
+    echoOutputCallbackSeen_ = outputCallback;
+
+    // Played audio needs at least one output and one input callback to come
+    // back as captured audio; reading the reference that far behind keeps
+    // the echo within the filter tail without ever leading it. Callbacks are
+    // measured, not configured: iOS may deliver 4096 frames at a time.
+    const size_t rate = static_cast<size_t>(processingRate_.load(std::memory_order_relaxed));
+    size_t inputBuffer = inputCallback * rate / inputDeviceSampleRate_;
+    size_t outputBuffer = outputCallback * rate / outputDeviceSampleRate_;
+    size_t delay = inputBuffer + outputBuffer +
+                   static_cast<size_t>(std::max(config_.echoDelayMs, 0)) * rate / 1000;
+    echoDelaySamples_ = std::min(delay, kEchoReferenceCapacity / 2);
+    echoMaxDrift_ = 2 * std::max(inputBuffer, outputBuffer) + frameSize_;
+    return true;
+}
+
+void AudioPipeline::noteRenderAheadCallback(size_t frames) {
+    // Let the worker size its lead for the largest callback the device makes.
+    // Taken per device callback: int16 devices are served in shorter chunks.
+    if (config_.renderAheadMs > 0 && frames > renderAheadMaxCallback_.load(std::memory_order_relaxed)) {
+        renderAheadMaxCallback_.store(frames, std::memory_order_relaxed);
+    }
+}
+
+size_t AudioPipeline::serveRenderAhead(float* data, size_t frames) {
+    size_t served = 0;
+
+    while (served < frames) {
+        if (!renderAheadBlock_) {
+            renderAheadBlock_ = renderAheadQueue_.readSlot();
+            renderAheadPos_ = 0;
+            if (!renderAheadBlock_) {
+                // Worker fell behind: play silence and let it raise the lead
+                renderAheadUnderruns_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        size_t copyFrames = std::min(renderAheadBlock_->frames - renderAheadPos_, frames - served);
+        memcpy(data + served, renderAheadBlock_->samples + renderAheadPos_, copyFrames * sizeof(float));
+        renderAheadPos_ += copyFrames;
+        served += copyFrames;
+
+        if (renderAheadPos_ == renderAheadBlock_->frames) {
+            renderAheadQueue_.release();
+            renderAheadBlock_ = nullptr;
+        }
+    }
+    return served;
+}
+
+void AudioPipeline::processPlaybackAudio(float* data, size_t frames) {
+    bool flush = playbackFifoFlush_.exchange(false, std::memory_order_acq_rel);
+
+    if (config_.renderAheadMs > 0) {
+        // Steps 1-3 already ran on the render-ahead worker
+        if (flush) {
+            // Blocks mixed for the old rate: drop them and let the worker refill
+            renderAheadBlock_ = nullptr;
+            while (renderAheadQueue_.readSlot()) {
+                renderAheadQueue_.release();
+            }
+        }
+        serveRenderAhead(data, frames);
+    } else {
+        if (flush) {
+            playbackFifoPos_ = 0;
+            playbackFifoFrames_ = 0;
+        }
+
+        // Steps 1-3 run per frame; the FIFO serves whatever size the device
+        // asks for, so no samples are dropped or repeated between callbacks
+        size_t served = 0;
+        while (served < frames) {
+            if (playbackFifoPos_ == playbackFifoFrames_) {
+                playbackFifoPos_ = 0;
+                playbackFifoFrames_ = renderPlaybackBlock(playbackFifo_.data(), playbackFifo_.size());
+                if (playbackFifoFrames_ == 0) {
+                    break;  // Resampler produced nothing yet; leave silence
+                }
+            }
+
+            size_t copyFrames = std::min(playbackFifoFrames_ - playbackFifoPos_, frames - served);
+            memcpy(data + served, playbackFifo_.data() + playbackFifoPos_, copyFrames * sizeof(float));
+            playbackFifoPos_ += copyFrames;
+            served += copyFrames;
+        }
+    }
+}
+
+bool AudioPipeline::finishPlaybackAudio(int16_t* data, size_t frames) {
+    // Step 4: Request more audio data if callback is set (lock-free)
+    PlaybackCallback* callback = playbackCallbackPtr_.load(std::memory_order_acquire);
+    if (callback) {
+        // The playback callback can add more audio to user buffers
+        (*callback)(data, frames);
+    }
+
+    // Step 5: What goes to the device is the echo canceller's reference
+    if (echoCancellationEnabled_.load(std::memory_order_relaxed)) {
+        writeEchoReference(data, frames);
+    }
+    return callback != nullptr;
+}
+
+void AudioPipeline::writeEchoReference(const int16_t* data, size_t frames) {
+    if (!echoReferenceResampler_) {
+        echoReference_.write(data, frames);
+        return;
+    }
+
+    size_t consumed = 0;
+    while (consumed < frames) {
+        size_t inputFrames = frames - consumed;
+        size_t outputFrames = echoResampleBuffer_.size();
+
+        echoReferenceResampler_->process(data + consumed, inputFrames,
+                                         echoResampleBuffer_.data(), outputFrames);
+        if (inputFrames == 0 && outputFrames == 0) {
+            break;
+        }
+
+        echoReference_.write(echoResampleBuffer_.data(), outputFrames);
+        consumed += inputFrames;
+    }
+}
+
+}  // namespace sayses
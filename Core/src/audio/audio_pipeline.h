@@ -0,0 +1,403 @@
+/**
+ * Audio Pipeline
+ * Platform-independent part of AudioEngine: capture framing, resampling,
+ * echo cancellation, preprocessing, VAD, per-user buffers and mixing
+ *
+ * Platform backends (AudioUnit on iOS, ALSA on Linux, offline files) derive from
+ * AudioPipeline, implement the device hooks and feed device buffers into
+ * onCaptureAudio() / onPlaybackAudio() from their I/O threads, as int16 or
+ * float (Config::floatDeviceFormat). Playback is mixed and resampled in float
+ * and only converted at an int16 device.
+ */
+
+#pragma once
+
+#include "audio_engine.h"
+#include "echo_reference.h"
+#include "speex_dsp.h"
+#include "user_audio_buffer.h"
+#include "vad.h"
+#include "seqlock.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sayses {
+
+// Constants matching Android implementation
+constexpr int kOpusSampleRate = 48000;
+constexpr int kOpusFrameSize = 480;    // 10ms at 48kHz, also the largest processing frame
+constexpr int kDefaultFrameDurationUs = 10000;
+constexpr int kMinFrameDurationUs = 2500;   // Opus' shortest (CELT) frame
+constexpr int kBluetoothSampleRate = 16000;
+constexpr int kResamplerQuality = 3;   // VoIP quality (like Mumla)
+constexpr float kMaxUserVolume = 4.0f;
+constexpr float kDefaultDuckingLevel = 0.3f;  // ~-10 dB under a priority speaker
+constexpr int kDuckHoldMs = 500;              // Keep ducking across speech pauses
+constexpr int kTransmitQueueMs = 320;         // Captured audio in flight to the transmit worker
+constexpr int kTransmitPollsPerFrame = 4;     // Worker polls the queue 4x per frame (2.5ms at 10ms)
+constexpr size_t kPlaybackBlockCapacity = kOpusFrameSize * 4;  // One block at up to 192kHz
+constexpr int kMaxRenderAheadMs = 320;        // Lead cap: a 4096-frame callback at 16kHz plus margin
+constexpr int kRenderAheadPollsPerFrame = 4;  // Worker checks the queue 4x per frame
+constexpr int kRenderAheadRelaxBlocks = 1000; // Shrink the lead after 1000 frames without underruns
+constexpr int kMaxEchoTailMs = 300;           // Bounds the AEC's per-frame cost
+constexpr size_t kEchoReferenceCapacity = kOpusSampleRate;  // 1s of played audio
+constexpr size_t kFormatConvertFrames = 1024;  // Device buffer chunk converted between int16 and float
+
+/**
+ * Local mix settings for one user.
+ * Written from any thread; the render thread reads them once per frame.
+ */
+struct UserMixState {
+    std::atomic<float> volume{1.0f};
+    std::atomic<bool> muted{false};
+    std::atomic<bool> priority{false};
+    float appliedGain{1.0f};  // Render thread only: gain the last frame ended on
+};
+
+/**
+ * Immutable snapshot of the users currently talking.
+ * Built off the audio thread and published with an atomic pointer swap;
+ * the render thread only ever iterates the latest snapshot.
+ */
+struct TalkerList {
+    struct Talker {
+        UserAudioBuffer* buffer;
+        UserMixState* mix;
+    };
+    std::vector<Talker> talkers;
+};
+
+/**
+ * AudioEngine implementation minus the device I/O.
+ * Threading: onCaptureAudio() runs on the backend's capture thread and
+ * onPlaybackAudio() on its render thread; both are lock-free and never
+ * allocate. Everything else is called from the app side.
+ */
+class AudioPipeline : public AudioEngine {
+public:
+    ~AudioPipeline() override;
+
+    bool startCapture(AudioCallback callback) override;
+    bool startCapture(FrameCallback callback) override;
+    bool startCapture(FloatFrameCallback callback) override;
+    void stopCapture() override;
+    bool isCapturing() const override;
+    uint64_t getCaptureDroppedFrames() const override;
+
+    bool startPlayback(PlaybackCallback callback) override;
+    void stopPlayback() override;
+    bool isPlaying() const override;
+
+    void setVadEnabled(bool enabled) override;
+    void setVadThreshold(float threshold) override;
+    void setEchoCancellationEnabled(bool enabled) override;
+    bool isVoiceDetected() const override;
+    float getInputLevel() const override;
+    AudioFrameFeatures getInputFeatures() const override;
+    uint64_t getInputClippedSamples() const override;
+
+    // Extended interface for SAYses
+    void setPreprocessingEnabled(bool enabled);
+
+    // User audio management (public interface)
+    void addUserAudio(uint32_t userId, const int16_t* samples, size_t frames, int64_t sequence) override;
+    void addUserAudio(uint32_t userId, const float* samples, size_t frames, int64_t sequence) override;
+    void removeUser(uint32_t userId) override;
+    void notifyUserTalkingEnded(uint32_t userId) override;
+    bool startMixedPlayback() override;
+    uint64_t getPlaybackCallbackCount() const override;
+    int getRenderAheadMs() const override;
+    int getProcessingSampleRate() const override;
+
+    // Per-user mix controls
+    void setUserVolume(uint32_t userId, float gain) override;
+    void setUserMuted(uint32_t userId, bool muted) override;
+    void setUserPrioritySpeaker(uint32_t userId, bool priority) override;
+    void setPriorityDuckingLevel(float gain) override;
+
+protected:
+    explicit AudioPipeline(const Config& config);
+
+    // =========================================================================
+    // Device hooks (implemented by the platform backend)
+    // =========================================================================
+
+    /**
+     * Open the device if needed and make sure duplex I/O is running.
+     * Called on every start; must be idempotent.
+     * @return true if the device is running
+     */
+    virtual bool startDevice() = 0;
+
+    // =========================================================================
+    // Called by the platform backend
+    // =========================================================================
+
+    /**
+     * Set the device sample rates, pick the processing rate and (re)create
+     * the resamplers. If the processing rate changes, the mixer, VAD,
+     * preprocessor and echo canceller are rebuilt for it and user buffers
+     * are flushed. Call before starting I/O and again after a route change,
+     * with the device stopped: the capture and render callbacks use all of
+     * these without locks.
+     */
+    void setDeviceSampleRates(int inputRate, int outputRate);
+
+    /**
+     * Set the rate of the host clock used for CaptureTimestamp::hostTime.
+     */
+    void setHostClockRate(double ticksPerSecond);
+
+    /**
+     * Feed one captured device buffer (capture thread).
+     * @param hostTime Host clock time of the first sample, 0 if unknown
+     */
+    void onCaptureAudio(int16_t* data, size_t frames, uint64_t hostTime);
+
+    /**
+     * Feed one captured Float32 device buffer (capture thread). Capture is
+     * processed in float, so it is only copied in chunks for in-place
+     * processing; echo cancellation alone works on an int16 copy.
+     */
+    void onCaptureAudio(const float* data, size_t frames, uint64_t hostTime);
+
+    /**
+     * Fill one device buffer for playback (render thread). Always writes
+     * all frames, with silence when nothing is playing.
+     */
+    void onPlaybackAudio(int16_t* data, size_t frames);
+
+    /**
+     * Fill one Float32 device buffer for playback (render thread). The float
+     * mix goes straight to the device without an int16 stage.
+     */
+    void onPlaybackAudio(float* data, size_t frames);
+
+    /**
+     * Hand captured frames to the capture callback on the capture thread
+     * instead of the transmit worker. For backends that run faster than real
+     * time: no frame is dropped and the result doesn't depend on scheduling.
+     * Call before the first startCapture().
+     */
+    void setSynchronousTransmit(bool synchronous);
+
+    /**
+     * Stop capture, playback and all workers. Backends call this from their
+     * destructor before closing the device.
+     */
+    void shutdown();
+
+    /**
+     * Raise the calling thread to real-time audio priority (best effort).
+     */
+    static void setThreadPriority();
+
+    Config config_;
+
+private:
+    void initResamplers();
+    void initProcessing();
+    void initPreprocessor();
+    void initEchoCanceller();
+    int chooseProcessingRate() const;
+    size_t frameSizeAt(int sampleRate) const;
+    void flushUserBuffers();
+    std::shared_ptr<UserAudioBuffer> userBufferFor(uint32_t userId);
+
+    void processCapturedAudio(float* data, size_t frames, uint64_t hostTime);
+    void feedCaptureFramer(float* samples, size_t frames);
+    void processCaptureFrame(float* frame);
+    bool cancelEcho(int16_t* frame);
+
+    // Transmit worker: runs the capture callback off the realtime thread
+    void startTransmitWorker();
+    void stopTransmitWorker();
+    bool deliverTransmitFrame();
+    void transmitLoop();
+
+    void processPlaybackAudio(float* data, size_t frames);
+    bool finishPlaybackAudio(int16_t* data, size_t frames);
+    size_t renderPlaybackBlock(float* output, size_t capacity);
+    size_t serveRenderAhead(float* data, size_t frames);
+    void noteRenderAheadCallback(size_t frames);
+    static void noteLargestCallback(std::atomic<size_t>& largest, size_t frames);
+    bool updateEchoDelay();
+    void writeEchoReference(const int16_t* data, size_t frames);
+    bool mixTalker(const TalkerList::Talker& talker, float duckGain);
+
+    // Render-ahead worker: mixes ahead of the device callback
+    void startRenderAhead();
+    void stopRenderAhead();
+    void renderAheadLoop();
+    int fillRenderAhead(int leadBlocks);
+    int renderAheadCallbackBlocks(size_t blockFrames) const;
+
+    // Active talker publication (network side, call with userBuffersMutex_ held)
+    void publishTalkersLocked(UserAudioBuffer* joining, UserAudioBuffer* leaving = nullptr);
+    void retireLocked(std::unique_ptr<const TalkerList> list,
+                      std::shared_ptr<void> object);
+    void reclaimRetiredLocked();
+    UserMixState* mixStateLocked(uint32_t userId);
+
+    // Render-side epoch guard around reads of activeTalkers_
+    const TalkerList* enterRenderEpoch();
+    void leaveRenderEpoch();
+
+    // Configuration
+    std::atomic<bool> preprocessingEnabled_{true};  // Float denoise + AGC (capture thread reads)
+    int inputDeviceSampleRate_{kOpusSampleRate};
+    int outputDeviceSampleRate_{kOpusSampleRate};
+    float vadThreshold_{0.01f};  // Kept so a rebuilt VAD starts from it
+
+    // Processing rate: Opus' 48kHz, or an 8/12/16/24kHz route's own rate so
+    // neither direction resamples. Frames are Config::frameDurationUs long
+    // (10, 5 or 2.5ms) at either rate.
+    std::atomic<int> processingRate_{kOpusSampleRate};
+    int frameDurationUs_{kDefaultFrameDurationUs};
+    size_t frameSize_{kOpusFrameSize};
+
+    // State
+    std::atomic<bool> capturing_{false};
+    std::atomic<bool> playing_{false};
+    std::atomic<bool> voiceDetected_{false};
+    SeqLock<AudioFrameFeatures> inputFeatures_;  // Written by the capture thread
+    std::atomic<uint64_t> inputClippedSamples_{0};
+
+    // Callbacks (atomic for lock-free access in audio thread)
+    std::atomic<FloatFrameCallback*> captureCallbackPtr_{nullptr};
+    std::atomic<PlaybackCallback*> playbackCallbackPtr_{nullptr};
+    std::unique_ptr<FloatFrameCallback> captureCallbackStorage_;
+    std::unique_ptr<PlaybackCallback> playbackCallbackStorage_;
+    std::mutex callbackSetupMutex_;  // Only for setup/teardown, NOT in audio thread
+
+    // Buffers
+    std::vector<float> resampleInputBuffer_;
+    std::vector<float> playbackOutputBuffer_;
+    std::vector<float> captureConvertBuffer_;     // Device capture chunk as float
+    std::vector<float> playbackFloatBuffer_;      // Float mix chunk for an int16 device
+    std::vector<int16_t> playbackInt16Buffer_;    // Float device chunk for the int16 callback/reference
+
+    // Capture framer (capture thread only): device-sized callbacks are cut
+    // into exact frames. Whole frames are processed in place; only a
+    // partial tail is staged here until the next callback completes it.
+    std::vector<float> captureFrame_;
+    std::vector<int16_t> captureInt16Frame_;   // int16 copy for echo cancellation and analysis
+    size_t captureFrameFill_{0};             // In processing-rate samples
+    uint64_t captureFrameIndex_{0};          // 48kHz stream position of the staged frame
+    uint64_t captureCallbackIndex_{0};       // Stream position of the current callback
+    uint64_t captureCallbackHostTime_{0};    // Host time of the current callback
+    double hostTicksPerSample_{0.0};         // Host clock ticks per 48kHz sample
+
+    // Captured frames queued for the transmit worker. The capture thread only
+    // copies into a free slot and never wakes the worker (no syscall on the
+    // audio thread); the worker polls. Encode/send happen on the worker.
+    struct CaptureFrame {
+        CaptureTimestamp timestamp;
+        size_t frames;
+        float samples[kOpusFrameSize];
+    };
+    SpscQueue<CaptureFrame> transmitQueue_;  // kTransmitQueueMs worth of frames
+    std::thread transmitThread_;
+    std::atomic<bool> transmitRunning_{false};
+    bool synchronousTransmit_{false};         // No worker: the capture thread delivers
+    std::atomic<uint64_t> transmitDroppedFrames_{0};
+
+    // Playback FIFO (render thread only): holds the unplayed rest of the last
+    // mixed frame at device rate, so any callback size can be served
+    std::vector<float> playbackFifo_;
+    size_t playbackFifoPos_{0};
+    size_t playbackFifoFrames_{0};
+    std::atomic<bool> playbackFifoFlush_{false};  // Set on route/rate change
+
+    // Render-ahead mode (Config::renderAheadMs > 0): a worker mixes whole
+    // blocks into this queue and the render callback only copies them out.
+    // The lead covers the largest device callback seen plus renderAheadMs,
+    // so a callback longer than renderAheadMs is still served in full.
+    struct PlaybackBlock {
+        size_t frames;
+        float samples[kPlaybackBlockCapacity];
+    };
+    SpscQueue<PlaybackBlock> renderAheadQueue_;      // kMaxRenderAheadMs worth of blocks
+    std::thread renderAheadThread_;
+    std::atomic<bool> renderAheadRunning_{false};
+    std::atomic<int> renderAheadBlocks_{0};          // Current lead in frames
+    std::atomic<uint32_t> renderAheadUnderruns_{0};  // Written by the render thread
+    std::atomic<size_t> renderAheadMaxCallback_{0};  // Largest callback seen (device frames)
+    size_t renderAheadBlockFrames_{0};                // Worker only: device frames per block
+    const PlaybackBlock* renderAheadBlock_{nullptr};  // Render thread only
+    size_t renderAheadPos_{0};                        // Render thread only
+
+    // Speex DSP
+    std::unique_ptr<SpeexPreprocessor> preprocessor_;
+    std::unique_ptr<SpeexResampler> inputResampler_;   // device -> processing rate
+    std::unique_ptr<SpeexResampler> outputResampler_;  // processing rate -> device
+
+    // Echo cancellation: the render thread writes what it hands to the device
+    // (at the processing rate) into the reference ring, the capture thread reads
+    // it back delay-aligned and cancels it from each frame before preprocessing
+    std::unique_ptr<SpeexEchoCanceller> echoCanceller_;
+    std::unique_ptr<SpeexResampler> echoReferenceResampler_;  // device -> processing rate, render thread
+    EchoReference echoReference_{kEchoReferenceCapacity};
+    std::atomic<bool> echoCancellationEnabled_{false};
+    std::atomic<bool> echoResetPending_{false};  // Set on route/rate change
+    std::vector<int16_t> echoResampleBuffer_;     // Render thread only
+    std::vector<int16_t> echoFarFrame_;           // Capture thread only
+    std::vector<int16_t> echoOutFrame_;           // Capture thread only
+    std::atomic<size_t> echoInputCallback_{0};    // Largest capture callback (device frames)
+    std::atomic<size_t> echoOutputCallback_{0};   // Largest playback callback (device frames)
+    size_t echoInputCallbackSeen_{0};             // Capture thread only: sizes the delay
+    size_t echoOutputCallbackSeen_{0};            //   below was computed from
+    size_t echoDelaySamples_{0};                  // Capture thread only: bulk delay of the reference read
+    size_t echoMaxDrift_{0};                      // Capture thread only: read jitter tolerated before a resync
+    int echoTailFrames_{0};
+    int echoSilentFrames_{0};                     // Capture thread only
+
+    // VAD
+    std::unique_ptr<VoiceActivityDetector> vad_;
+
+    // User audio buffers, owned by the network side and never touched by the
+    // render thread. Shared so the producer can write outside the map lock.
+    std::mutex userBuffersMutex_;
+    std::map<uint32_t, std::shared_ptr<UserAudioBuffer>> userBuffers_;
+    std::map<uint32_t, std::shared_ptr<UserMixState>> userMixStates_;
+
+    // Active talkers seen by the render thread (RCU-style publication).
+    // Replaced snapshots and removed users are retired with the epoch at
+    // which they became unreachable and freed once the render thread has
+    // moved past it. Reclamation happens on the network side only.
+    struct Retired {
+        uint64_t epoch;
+        std::unique_ptr<const TalkerList> list;
+        std::shared_ptr<void> object;  // Removed buffer or mix state
+    };
+    std::atomic<const TalkerList*> activeTalkers_{nullptr};
+    std::unique_ptr<const TalkerList> activeTalkersStorage_;
+    std::vector<Retired> retired_;
+    std::atomic<uint64_t> globalEpoch_{1};
+    std::atomic<uint64_t> renderEpoch_{0};  // 0 = render thread not inside
+
+    // Pre-allocated buffer for playback mixing (avoid allocation in audio callback)
+    std::vector<float> perUserBuffer_;
+
+    // Playback heartbeat counter (incremented in each playback callback)
+    std::atomic<uint64_t> playbackCallbackCount_{0};
+
+    // Float mixer
+    std::unique_ptr<FloatMixer> mixer_;
+
+    // Priority speaker ducking
+    std::atomic<float> duckingLevel_{kDefaultDuckingLevel};
+    int duckHoldRemaining_{0};  // Render thread only
+    int duckHoldFrames_{0};     // kDuckHoldMs in frames
+
+    // Crossfade
+    std::unique_ptr<Crossfade> crossfade_;
+};
+
+}  // namespace sayses
@@ -0,0 +1,114 @@
+/**
+ * Echo Reference
+ * Lock-free ring that carries the played mix from the render thread to the
+ * capture thread as the echo canceller's far-end reference
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace sayses {
+
+/**
+ * Single-writer, single-reader sample ring with delay-aligned reads.
+ * The writer never blocks and overwrites the oldest samples; the reader
+ * asks for the frame that lags the newest written sample by a bulk delay.
+ * Samples are relaxed atomics, so reading a region the writer is about to
+ * overwrite is well-defined (the reader detects it and resyncs).
+ */
+class EchoReference {
+public:
+    /**
+     * @param capacity Samples kept; rounded up to a power of two and must
+     *                 exceed the largest delay plus a frame
+     */
+    explicit EchoReference(size_t capacity)
+        : capacity_(roundUp(capacity))
+        , mask_(capacity_ - 1)
+        , samples_(std::make_unique<std::atomic<int16_t>[]>(capacity_)) {
+        for (size_t i = 0; i < capacity_; i++) {
+            samples_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Writer: append samples as they are handed to the device.
+     */
+    void write(const int16_t* samples, size_t frames) {
+        uint64_t write = writePos_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < frames; i++) {
+            samples_[(write + i) & mask_].store(samples[i], std::memory_order_relaxed);
+        }
+        writePos_.store(write + frames, std::memory_order_release);
+    }
+
+    /**
+     * Reader: fetch the next reference frame. Reads continue where the last
+     * one ended while that stays within maxDrift of the target position
+     * (newest sample minus delay), so device callback sizes do not cause
+     * jumps; otherwise, e.g. after start or a playback stall, the read
+     * position snaps to the target. Samples not written yet read as silence.
+     * @param delay Samples the frame start lags the newest written sample
+     * @return true if the frame holds any non-zero sample
+     */
+    bool read(int16_t* output, size_t frames, size_t delay, size_t maxDrift) {
+        const int64_t write = static_cast<int64_t>(writePos_.load(std::memory_order_acquire));
+        const int64_t target = write - static_cast<int64_t>(delay);
+        const int64_t drift = readPos_ - target;
+        if (!synced_ || drift > static_cast<int64_t>(maxDrift) || -drift > static_cast<int64_t>(maxDrift)) {
+            readPos_ = target;
+            synced_ = true;
+        }
+
+        const int64_t oldest = write - static_cast<int64_t>(capacity_);
+        bool active = false;
+        for (size_t i = 0; i < frames; i++) {
+            const int64_t pos = readPos_ + static_cast<int64_t>(i);
+            int16_t sample = 0;
+            if (pos >= 0 && pos >= oldest && pos < write) {
+                sample = samples_[static_cast<uint64_t>(pos) & mask_].load(std::memory_order_relaxed);
+            }
+            output[i] = sample;
+            active |= sample != 0;
+        }
+
+        // The writer lapped us during the copy: resync on the next read
+        const int64_t after = static_cast<int64_t>(writePos_.load(std::memory_order_acquire));
+        if (readPos_ < after - static_cast<int64_t>(capacity_)) {
+            synced_ = false;
+        }
+        readPos_ += static_cast<int64_t>(frames);
+        return active;
+    }
+
+    /**
+     * Reader: snap to the target position on the next read.
+     */
+    void resync() {
+        synced_ = false;
+    }
+
+private:
+    static size_t roundUp(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<std::atomic<int16_t>[]> samples_;
+    std::atomic<uint64_t> writePos_{0};
+
+    // Reader state
+    int64_t readPos_{0};
+    bool synced_{false};
+};
+
+}  // namespace sayses
@@ -0,0 +1,402 @@
+/**
+ * Float Preprocessor Implementation
+ * Wiener noise suppression on a minimum-statistics noise estimate plus a
+ * peak-tracking digital AGC, independent of the speexdsp build
+ */
+
+#include "speex_dsp.h"
+#include "audio_kernels.h"
+#include "real_fft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace sayses {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr float kSpeechLowHz = 250.0f;
+constexpr float kSpeechHighHz = 4000.0f;
+
+// Noise estimate (minimum statistics, per bin)
+constexpr float kPowerSmoothing = 0.8f;    // Per-frame smoothing before the minimum search
+constexpr int kNoiseWindowMs = 1500;       // Longer follows rising noise slower
+constexpr int kMinSubWindows = 8;
+constexpr float kNoiseBias = 2.0f;         // Minimum of smoothed power underestimates the mean
+constexpr float kPowerFloor = 1e-12f;
+
+// Decision-directed a priori SNR (Ephraim-Malah); closer to 1 = less musical noise
+constexpr float kPrioriSmoothing = 0.98f;
+
+// Speech probability from the speech-band SNR
+constexpr float kProbabilityLowDb = 3.0f;
+constexpr float kProbabilityHighDb = 12.0f;
+
+// AGC
+constexpr float kAgcPeakRelease = 0.98f;   // Per frame, ~0.5s to forget a loud syllable
+constexpr float kAgcMinGainDb = -12.0f;
+constexpr float kAgcRiseDbPerSecond = 12.0f;
+constexpr float kAgcFallDbPerSecond = 40.0f;
+constexpr float kAgcLimit = 0.98f;         // Peaks after gain stay below this
+
+float dbToGain(float db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+
+/**
+ * Wiener gain per bin with decision-directed a priori SNR, applied to the
+ * spectrum in place. cleanPower carries |S|^2 of the previous frame.
+ */
+void applyWienerGain(float* re, float* im, const float* power, const float* noise,
+                     float* cleanPower, size_t bins, float gainFloor) {
+    size_t k = 0;
+#if defined(SAYSES_KERNELS_NEON)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t alpha = vdupq_n_f32(kPrioriSmoothing);
+    const float32x4_t beta = vdupq_n_f32(1.0f - kPrioriSmoothing);
+    const float32x4_t floor = vdupq_n_f32(gainFloor);
+    for (; k + 4 <= bins; k += 4) {
+        const float32x4_t p = vld1q_f32(power + k);
+        const float32x4_t n = vld1q_f32(noise + k);
+        // 1/n by estimate plus two Newton steps (armv7 has no vector divide)
+        float32x4_t invN = vrecpeq_f32(n);
+        invN = vmulq_f32(invN, vrecpsq_f32(n, invN));
+        invN = vmulq_f32(invN, vrecpsq_f32(n, invN));
+        const float32x4_t post = vmaxq_f32(vsubq_f32(vmulq_f32(p, invN), one), zero);
+        const float32x4_t prio = vaddq_f32(vmulq_f32(alpha, vmulq_f32(vld1q_f32(cleanPower + k), invN)),
+                                           vmulq_f32(beta, post));
+        const float32x4_t denom = vaddq_f32(one, prio);
+        float32x4_t invD = vrecpeq_f32(denom);
+        invD = vmulq_f32(invD, vrecpsq_f32(denom, invD));
+        invD = vmulq_f32(invD, vrecpsq_f32(denom, invD));
+        const float32x4_t g = vmaxq_f32(vmulq_f32(prio, invD), floor);
+        vst1q_f32(cleanPower + k, vmulq_f32(vmulq_f32(g, g), p));
+        vst1q_f32(re + k, vmulq_f32(vld1q_f32(re + k), g));
+        vst1q_f32(im + k, vmulq_f32(vld1q_f32(im + k), g));
+    }
+#elif defined(SAYSES_KERNELS_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 alpha = _mm_set1_ps(kPrioriSmoothing);
+    const __m128 beta = _mm_set1_ps(1.0f - kPrioriSmoothing);
+    const __m128 floor = _mm_set1_ps(gainFloor);
+    for (; k + 4 <= bins; k += 4) {
+        const __m128 p = _mm_loadu_ps(power + k);
+        const __m128 n = _mm_loadu_ps(noise + k);
+        const __m128 post = _mm_max_ps(_mm_sub_ps(_mm_div_ps(p, n), one), zero);
+        const __m128 prio = _mm_add_ps(_mm_mul_ps(alpha, _mm_div_ps(_mm_loadu_ps(cleanPower + k), n)),
+                                       _mm_mul_ps(beta, post));
+        const __m128 g = _mm_max_ps(_mm_div_ps(prio, _mm_add_ps(one, prio)), floor);
+        _mm_storeu_ps(cleanPower + k, _mm_mul_ps(_mm_mul_ps(g, g), p));
+        _mm_storeu_ps(re + k, _mm_mul_ps(_mm_loadu_ps(re + k), g));
+        _mm_storeu_ps(im + k, _mm_mul_ps(_mm_loadu_ps(im + k), g));
+    }
+#endif
+    for (; k < bins; k++) {
+        const float post = std::max(power[k] / noise[k] - 1.0f, 0.0f);
+        const float prio = kPrioriSmoothing * cleanPower[k] / noise[k] + (1.0f - kPrioriSmoothing) * post;
+        const float g = std::max(prio / (1.0f + prio), gainFloor);
+        cleanPower[k] = g * g * power[k];
+        re[k] *= g;
+        im[k] *= g;
+    }
+}
+
+}  // namespace
+
+class FloatPreprocessor : public SpeexPreprocessor {
+public:
+    explicit FloatPreprocessor(const Config& config);
+    ~FloatPreprocessor() override = default;
+
+    bool process(int16_t* samples, size_t frames) override;
+    bool process(float* samples, size_t frames) override;
+    float getSpeechProbability() const override;
+    void setDenoiseEnabled(bool enabled) override;
+    void setAgcEnabled(bool enabled) override;
+    void setDereverbEnabled(bool enabled) override;
+    void reset() override;
+
+private:
+    bool processFrame();
+    void analyze();
+    void updateNoise();
+    void applyAgc(float* samples);
+
+    Config config_;
+
+    // Enable switches: set from any thread, taken over by process() so a
+    // change never lands in the middle of a frame
+    std::atomic<bool> denoiseRequested_;
+    std::atomic<bool> agcRequested_;
+    bool denoiseEnabled_;                  // Capture thread only
+    bool agcEnabled_;
+
+    // Framing: hop = frameSize, sqrt-Hann analysis/synthesis over two frames
+    size_t frameSize_;
+    size_t windowSize_;
+    size_t fftSize_;
+    size_t bins_;
+    size_t speechFirstBin_;
+    size_t speechEndBin_;
+    bool primed_{false};                   // First frame seeds the noise estimate
+    std::vector<float> window_;
+    std::vector<float> input_;             // Previous and current frame
+    std::vector<float> block_;             // Windowed, zero-padded FFT input/output
+    std::vector<float> overlap_;           // Second half of the last synthesis block
+    std::vector<float> re_;
+    std::vector<float> im_;
+    RealFft fft_;
+
+    // Noise estimate and suppression state
+    std::vector<float> power_;
+    std::vector<float> smoothedPower_;
+    std::vector<float> subWindowMin_;      // Running minimum of the current sub-window
+    std::vector<float> windowMins_;        // kMinSubWindows minima per bin, ring buffer
+    std::vector<float> windowMin_;         // Minimum over the completed sub-windows
+    std::vector<float> noise_;
+    std::vector<float> cleanPower_;
+    int subWindowFrames_;
+    int subWindowCount_{0};
+    int subWindowIndex_{0};
+    float gainFloor_;
+    float speechProbability_{0.0f};
+
+    // AGC
+    float agcTarget_;
+    float agcMaxGain_;
+    float agcMinGain_;
+    float agcRiseStep_;                    // Per-frame gain ratio limits
+    float agcFallStep_;
+    float agcGain_{1.0f};
+    float speechPeak_{0.0f};
+};
+
+// Factory
+std::unique_ptr<SpeexPreprocessor> SpeexPreprocessor::createFloat(const Config& config) {
+    return std::make_unique<FloatPreprocessor>(config);
+}
+
+FloatPreprocessor::FloatPreprocessor(const Config& config)
+    : config_(config)
+    , denoiseRequested_(config.denoiseEnabled)
+    , agcRequested_(config.agcEnabled)
+    , denoiseEnabled_(config.denoiseEnabled)
+    , agcEnabled_(config.agcEnabled)
+    , frameSize_(static_cast<size_t>(std::max(config.frameSize, 16)))
+    , windowSize_(2 * frameSize_)
+    , fftSize_(RealFft::nextPowerOfTwo(windowSize_))
+    , bins_(fftSize_ / 2 + 1)
+    , window_(windowSize_)
+    , input_(windowSize_, 0.0f)
+    , block_(fftSize_, 0.0f)
+    , overlap_(frameSize_, 0.0f)
+    , re_(bins_)
+    , im_(bins_)
+    , fft_(fftSize_)
+    , power_(bins_)
+    , smoothedPower_(bins_)
+    , subWindowMin_(bins_)
+    , windowMins_(bins_ * kMinSubWindows)
+    , windowMin_(bins_)
+    , noise_(bins_)
+    , cleanPower_(bins_) {
+
+    // sqrt of a periodic Hann window on both sides sums to one at 50% overlap
+    for (size_t i = 0; i < windowSize_; i++) {
+        window_[i] = static_cast<float>(std::sqrt(0.5 - 0.5 * std::cos(2.0 * kPi * i / windowSize_)));
+    }
+
+    const float binHz = static_cast<float>(config_.sampleRate) / fftSize_;
+    speechFirstBin_ = std::min(static_cast<size_t>(std::ceil(kSpeechLowHz / binHz)), bins_ - 1);
+    speechEndBin_ = std::min(static_cast<size_t>(std::ceil(kSpeechHighHz / binHz)), bins_);
+
+    const int framesPerSecond = std::max(1, config_.sampleRate / static_cast<int>(frameSize_));
+    subWindowFrames_ = std::max(1, kNoiseWindowMs * framesPerSecond / 1000 / kMinSubWindows);
+
+    gainFloor_ = dbToGain(static_cast<float>(std::min(config_.denoiseLevel, 0)));
+    agcTarget_ = std::clamp(config_.agcTarget, 1, 32767) * kernels::kInt16ToFloat;
+    agcMaxGain_ = dbToGain(static_cast<float>(std::max(config_.agcMaxGain, 0)));
+    agcMinGain_ = dbToGain(kAgcMinGainDb);
+    agcRiseStep_ = dbToGain(kAgcRiseDbPerSecond / framesPerSecond);
+    agcFallStep_ = dbToGain(-kAgcFallDbPerSecond / framesPerSecond);
+
+    reset();
+}
+
+bool FloatPreprocessor::process(int16_t* samples, size_t frames) {
+    if (frames != frameSize_) {
+        return false;
+    }
+
+    kernels::int16ToFloat(samples, input_.data() + frameSize_, frameSize_);
+    bool speech = processFrame();
+    kernels::floatToInt16(block_.data(), samples, frameSize_);
+    return speech;
+}
+
+bool FloatPreprocessor::process(float* samples, size_t frames) {
+    if (frames != frameSize_) {
+        return false;
+    }
+
+    std::memcpy(input_.data() + frameSize_, samples, frameSize_ * sizeof(float));
+    bool speech = processFrame();
+    std::memcpy(samples, block_.data(), frameSize_ * sizeof(float));
+    return speech;
+}
+
+bool FloatPreprocessor::processFrame() {
+    denoiseEnabled_ = denoiseRequested_.load(std::memory_order_relaxed);
+    const bool agcEnabled = agcRequested_.load(std::memory_order_relaxed);
+    if (agcEnabled != agcEnabled_) {
+        // Start over from unity gain rather than a stale level
+        agcEnabled_ = agcEnabled;
+        agcGain_ = 1.0f;
+        speechPeak_ = 0.0f;
+    }
+
+    // The new frame sits behind the previous one in input_
+    for (size_t i = 0; i < windowSize_; i++) {
+        block_[i] = input_[i] * window_[i];
+    }
+    std::fill(block_.begin() + windowSize_, block_.end(), 0.0f);
+    std::memcpy(input_.data(), input_.data() + frameSize_, frameSize_ * sizeof(float));
+
+    fft_.forward(block_.data(), re_.data(), im_.data());
+    analyze();
+    if (denoiseEnabled_) {
+        applyWienerGain(re_.data(), im_.data(), power_.data(), noise_.data(),
+                        cleanPower_.data(), bins_, gainFloor_);
+    }
+    fft_.inverse(re_.data(), im_.data(), block_.data());
+
+    // Overlap-add: the first half completes the previous frame (one frame of latency)
+    for (size_t i = 0; i < frameSize_; i++) {
+        block_[i] = block_[i] * window_[i] + overlap_[i];
+        overlap_[i] = block_[frameSize_ + i] * window_[frameSize_ + i];
+    }
+
+    if (agcEnabled_) {
+        applyAgc(block_.data());
+    }
+
+    return config_.vadEnabled ? speechProbability_ > 0.5f : true;
+}
+
+void FloatPreprocessor::analyze() {
+    for (size_t k = 0; k < bins_; k++) {
+        power_[k] = re_[k] * re_[k] + im_[k] * im_[k] + kPowerFloor;
+    }
+    updateNoise();
+
+    float speechPower = 0.0f;
+    float speechNoise = 0.0f;
+    for (size_t k = speechFirstBin_; k < speechEndBin_; k++) {
+        speechPower += power_[k];
+        speechNoise += noise_[k];
+    }
+    const float snrDb = 10.0f * std::log10(speechPower / std::max(speechNoise, kPowerFloor));
+    speechProbability_ = std::clamp((snrDb - kProbabilityLowDb) / (kProbabilityHighDb - kProbabilityLowDb),
+                                    0.0f, 1.0f);
+}
+
+void FloatPreprocessor::updateNoise() {
+    if (!primed_) {
+        // Assume the first frame is noise so the start is not passed through unsuppressed
+        std::copy(power_.begin(), power_.end(), smoothedPower_.begin());
+        std::copy(power_.begin(), power_.end(), subWindowMin_.begin());
+        std::copy(power_.begin(), power_.end(), windowMin_.begin());
+        for (int w = 0; w < kMinSubWindows; w++) {
+            std::copy(power_.begin(), power_.end(), windowMins_.begin() + w * bins_);
+        }
+        primed_ = true;
+    }
+
+    for (size_t k = 0; k < bins_; k++) {
+        const float smoothed = kPowerSmoothing * smoothedPower_[k] + (1.0f - kPowerSmoothing) * power_[k];
+        smoothedPower_[k] = smoothed;
+        subWindowMin_[k] = std::min(subWindowMin_[k], smoothed);
+        noise_[k] = kNoiseBias * std::min(windowMin_[k], subWindowMin_[k]);
+    }
+
+    if (++subWindowCount_ < subWindowFrames_) {
+        return;
+    }
+
+    // Sub-window complete: store its minimum and recompute the window minimum
+    subWindowCount_ = 0;
+    std::copy(subWindowMin_.begin(), subWindowMin_.end(), windowMins_.begin() + subWindowIndex_ * bins_);
+    subWindowIndex_ = (subWindowIndex_ + 1) % kMinSubWindows;
+    std::copy(smoothedPower_.begin(), smoothedPower_.end(), subWindowMin_.begin());
+
+    std::copy(windowMins_.begin(), windowMins_.begin() + bins_, windowMin_.begin());
+    for (int w = 1; w < kMinSubWindows; w++) {
+        const float* mins = windowMins_.data() + w * bins_;
+        for (size_t k = 0; k < bins_; k++) {
+            windowMin_[k] = std::min(windowMin_[k], mins[k]);
+        }
+    }
+}
+
+void FloatPreprocessor::applyAgc(float* samples) {
+    const float peak = kernels::maxAbs(samples, frameSize_);
+
+    // Follow the speech peak envelope; hold the gain through pauses and noise
+    float desired = agcGain_;
+    if (speechProbability_ > 0.5f) {
+        speechPeak_ = peak > speechPeak_ ? peak : kAgcPeakRelease * speechPeak_ + (1.0f - kAgcPeakRelease) * peak;
+        if (speechPeak_ > 0.0f) {
+            desired = std::clamp(agcTarget_ / speechPeak_, agcMinGain_, agcMaxGain_);
+        }
+    }
+
+    float gain = std::clamp(desired, agcGain_ * agcFallStep_, agcGain_ * agcRiseStep_);
+    if (peak * std::max(gain, agcGain_) > kAgcLimit) {
+        // Drop at once; a ramp down from the old gain would clip the frame start
+        gain = std::min(gain, kAgcLimit / peak);
+        kernels::applyGain(samples, frameSize_, gain);
+    } else {
+        kernels::applyGainRamp(samples, frameSize_, agcGain_, gain);
+    }
+    agcGain_ = gain;
+}
+
+float FloatPreprocessor::getSpeechProbability() const {
+    return speechProbability_;
+}
+
+void FloatPreprocessor::setDenoiseEnabled(bool enabled) {
+    denoiseRequested_.store(enabled, std::memory_order_relaxed);
+}
+
+void FloatPreprocessor::setAgcEnabled(bool enabled) {
+    agcRequested_.store(enabled, std::memory_order_relaxed);
+}
+
+void FloatPreprocessor::setDereverbEnabled(bool enabled) {
+    // Not implemented by this preprocessor; kept for interface compatibility
+    config_.dereverbEnabled = enabled;
+}
+
+void FloatPreprocessor::reset() {
+    std::fill(input_.begin(), input_.end(), 0.0f);
+    std::fill(block_.begin(), block_.end(), 0.0f);
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    std::fill(cleanPower_.begin(), cleanPower_.end(), 0.0f);
+    std::fill(noise_.begin(), noise_.end(), kPowerFloor);
+    subWindowCount_ = 0;
+    subWindowIndex_ = 0;
+    primed_ = false;
+    speechProbability_ = 0.0f;
+    agcGain_ = 1.0f;
+    speechPeak_ = 0.0f;
+}
+
+}  // namespace sayses
@@ -8,6 +8,7 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <vector>
 #include <cstring>
 #include <chrono>
 #include <algorithm>
@@ -56,6 +57,7 @@ private:
     int packetsLost_{0};
     int packetsLate_{0};
     int packetsReordered_{0};
+    int64_t lastPlayedSequence_{-1};
 
     // Constants
     static constexpr size_t kMaxPackets = 100;  // Maximum packets to buffer
@@ -153,6 +155,7 @@ size_t JitterBufferImpl::get(int16_t* output, size_t frames) {
             std::memset(output + copyFrames, 0, (frames - copyFrames) * sizeof(int16_t));
         }
 
+        lastPlayedSequence_ = packet.sequence;
         packets_.erase(it);
         nextPlaySequence_++;
 
@@ -181,6 +184,7 @@ size_t JitterBufferImpl::get(int16_t* output, size_t frames) {
                 std::memset(output + copyFrames, 0, (frames - copyFrames) * sizeof(int16_t));
             }
 
+            lastPlayedSequence_ = packet.sequence;
             packets_.erase(it);
             nextPlaySequence_++;
 
@@ -214,6 +218,7 @@ JitterBuffer::Stats JitterBufferImpl::getStats() const {
     stats.packetsLost = packetsLost_;
     stats.packetsLate = packetsLate_;
     stats.packetsReordered = packetsReordered_;
+    stats.lastPlayedSequence = lastPlayedSequence_;
 
     if (packetsReceived_ > 0) {
         stats.lossRate = static_cast<float>(packetsLost_) / packetsReceived_;
@@ -235,6 +240,7 @@ void JitterBufferImpl::reset() {
     packetsLost_ = 0;
     packetsLate_ = 0;
     packetsReordered_ = 0;
+    lastPlayedSequence_ = -1;
 }
 
 void JitterBufferImpl::adjustDelay() {
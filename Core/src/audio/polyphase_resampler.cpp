@@ -0,0 +1,222 @@
+/**
+ * Polyphase Resampler Implementation
+ * Fixed integer-ratio FIR resampling between 48 kHz and the Bluetooth /
+ * narrowband rates (8, 16, 24 kHz), replacing the generic Speex resampler
+ * on those routes
+ */
+
+#include "speex_dsp.h"
+#include "audio_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace sayses {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr int kHighRate = 48000;
+constexpr size_t kTapsPerPhase = 32;        // Filter taps per output sample (multiple of 8)
+constexpr size_t kChunkFrames = 256;        // Input samples converted to float per pass
+
+// Kaiser-windowed sinc prototype: -0.2 dB at 0.8 of the low-rate Nyquist,
+// -6 dB at 0.9, images/aliases >= 75 dB down from 1.05 on
+constexpr double kCutoff = 0.9;             // -6 dB point, of the low-rate Nyquist frequency
+constexpr double kKaiserBeta = 7.0;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Low-pass prototype of factor * kTapsPerPhase taps at the high rate with
+ * unity DC gain, cut off just below the low rate's Nyquist frequency.
+ */
+std::vector<double> designPrototype(int factor) {
+    const size_t length = static_cast<size_t>(factor) * kTapsPerPhase;
+    const double center = (length - 1) / 2.0;
+    const double cutoff = kCutoff / factor;  // Relative to the high-rate Nyquist
+
+    std::vector<double> taps(length);
+    double sum = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        const double t = i - center;
+        const double sinc = t == 0.0 ? 1.0 : std::sin(kPi * cutoff * t) / (kPi * cutoff * t);
+        const double r = t / center;
+        const double window = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(kKaiserBeta);
+        taps[i] = sinc * window;
+        sum += taps[i];
+    }
+    for (double& tap : taps) {
+        tap /= sum;
+    }
+    return taps;
+}
+
+}  // namespace
+
+// ============================================================================
+// PolyphaseResampler
+// ============================================================================
+
+/**
+ * Upsampling by L computes each output as one of L sub-filters (phases) of
+ * the prototype against the last kTapsPerPhase input samples; downsampling
+ * by L runs the whole prototype once per L input samples. Either way every
+ * output sample costs one contiguous kTapsPerPhase * (1 or L) dot product.
+ * Taps are stored time-reversed so they line up with the sample window.
+ */
+class PolyphaseResampler : public SpeexResampler {
+public:
+    PolyphaseResampler(int inputRate, int outputRate)
+        : inputRate_(inputRate)
+        , outputRate_(outputRate)
+        , upsample_(outputRate > inputRate)
+        , factor_(upsample_ ? outputRate / inputRate : inputRate / outputRate)
+        , windowFrames_(upsample_ ? kTapsPerPhase : kTapsPerPhase * factor_)
+        , taps_(kTapsPerPhase * factor_)
+        , work_(windowFrames_ - 1 + kChunkFrames, 0.0f)
+        , output_(kChunkFrames * factor_) {
+
+        const std::vector<double> prototype = designPrototype(static_cast<int>(factor_));
+        const size_t length = prototype.size();
+        if (upsample_) {
+            // Phase p, window position j (oldest first) -> prototype[p + (T - 1 - j) * L],
+            // scaled by L for the zeros the upsampling inserts
+            for (size_t p = 0; p < factor_; p++) {
+                for (size_t j = 0; j < kTapsPerPhase; j++) {
+                    taps_[p * kTapsPerPhase + j] =
+                        static_cast<float>(prototype[p + (kTapsPerPhase - 1 - j) * factor_] * factor_);
+                }
+            }
+        } else {
+            for (size_t j = 0; j < length; j++) {
+                taps_[j] = static_cast<float>(prototype[length - 1 - j]);
+            }
+        }
+    }
+
+    bool process(const int16_t* input, size_t& inputFrames,
+                 int16_t* output, size_t& outputFrames) override {
+        return run(input, inputFrames, output, outputFrames);
+    }
+
+    bool process(const float* input, size_t& inputFrames,
+                 float* output, size_t& outputFrames) override {
+        return run(input, inputFrames, output, outputFrames);
+    }
+
+    float getRatio() const override {
+        return static_cast<float>(outputRate_) / inputRate_;
+    }
+
+    void reset() override {
+        std::fill(work_.begin(), work_.end(), 0.0f);
+        phase_ = 0;
+    }
+
+    int getLatency() const override {
+        // Half the prototype, counted in input samples
+        const size_t length = kTapsPerPhase * factor_;
+        return static_cast<int>(upsample_ ? length / (2 * factor_) : length / 2);
+    }
+
+private:
+    // The filter runs in float; int16 streams convert on the way in and out
+    static void load(const int16_t* input, float* work, size_t frames) {
+        kernels::int16ToFloat(input, work, frames);
+    }
+    static void load(const float* input, float* work, size_t frames) {
+        memcpy(work, input, frames * sizeof(float));
+    }
+    static void store(const float* samples, int16_t* output, size_t frames) {
+        kernels::floatToInt16(samples, output, frames);
+    }
+    static void store(const float* samples, float* output, size_t frames) {
+        memcpy(output, samples, frames * sizeof(float));
+    }
+
+    template <typename Sample>
+    bool run(const Sample* input, size_t& inputFrames, Sample* output, size_t& outputFrames) {
+        const size_t history = windowFrames_ - 1;
+        size_t consumed = 0;
+        size_t produced = 0;
+
+        while (consumed < inputFrames) {
+            size_t chunk = std::min(kChunkFrames, inputFrames - consumed);
+            const size_t room = outputFrames - produced;
+            if (upsample_) {
+                chunk = std::min(chunk, room / factor_);
+            } else {
+                // Stop before the input that would complete an output we have no room for
+                chunk = std::min(chunk, (room + 1) * factor_ - 1 - phase_);
+            }
+            if (chunk == 0) {
+                break;
+            }
+
+            load(input + consumed, work_.data() + history, chunk);
+
+            size_t count = 0;
+            if (upsample_) {
+                for (size_t n = 0; n < chunk; n++) {
+                    const float* window = work_.data() + n;
+                    for (size_t p = 0; p < factor_; p++) {
+                        output_[count++] = kernels::dotProduct(&taps_[p * kTapsPerPhase], window, kTapsPerPhase);
+                    }
+                }
+            } else {
+                for (size_t n = 0; n < chunk; n++) {
+                    if (++phase_ == factor_) {
+                        phase_ = 0;
+                        output_[count++] = kernels::dotProduct(taps_.data(), work_.data() + n, windowFrames_);
+                    }
+                }
+            }
+
+            store(output_.data(), output + produced, count);
+            memmove(work_.data(), work_.data() + chunk, history * sizeof(float));
+            consumed += chunk;
+            produced += count;
+        }
+
+        inputFrames = consumed;
+        outputFrames = produced;
+        return true;
+    }
+
+    const int inputRate_;
+    const int outputRate_;
+    const bool upsample_;
+    const size_t factor_;
+    const size_t windowFrames_;     // Input samples each output depends on
+    std::vector<float> taps_;       // Time-reversed: upsampling factor_ phases of kTapsPerPhase
+    std::vector<float> work_;       // History followed by the current chunk
+    std::vector<float> output_;
+    size_t phase_{0};               // Downsampling: inputs since the last output
+};
+
+std::unique_ptr<SpeexResampler> SpeexResampler::createPolyphase(
+    int channels, int inputRate, int outputRate) {
+    if (channels != 1 || inputRate == outputRate) {
+        return nullptr;
+    }
+    const int lowRate = std::min(inputRate, outputRate);
+    const int highRate = std::max(inputRate, outputRate);
+    if (highRate != kHighRate || (lowRate != 8000 && lowRate != 16000 && lowRate != 24000)) {
+        return nullptr;
+    }
+    return std::make_unique<PolyphaseResampler>(inputRate, outputRate);
+}
+
+}  // namespace sayses
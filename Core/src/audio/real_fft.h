@@ -0,0 +1,224 @@
+/**
+ * Real FFT
+ * Radix-2 FFT of real blocks for the spectral VAD and the float preprocessor
+ */
+
+#pragma once
+
+#include "audio_kernels.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sayses {
+
+/**
+ * Real-input FFT via a half-size complex radix-2 FFT.
+ * Real and imaginary parts are kept in separate arrays and every stage has
+ * contiguous twiddles, so stages with a span of four or more run four
+ * butterflies per SIMD step. Tables are built once; no method allocates.
+ *
+ * Spectra have size()/2 + 1 bins (DC .. Nyquist) as separate re/im arrays.
+ */
+class RealFft {
+public:
+    /**
+     * @param size Power of two, at least 4
+     */
+    explicit RealFft(size_t size)
+        : size_(size)
+        , half_(size / 2)
+        , bitReverse_(half_)
+        , twiddleRe_(half_)
+        , twiddleIm_(half_)
+        , splitRe_(half_ + 1)
+        , splitIm_(half_ + 1)
+        , re_(half_)
+        , im_(half_) {
+
+        int bits = 0;
+        while ((size_t(1) << bits) < half_) {
+            bits++;
+        }
+        for (size_t i = 0; i < half_; i++) {
+            uint32_t reversed = 0;
+            for (int b = 0; b < bits; b++) {
+                reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+            }
+            bitReverse_[i] = reversed;
+        }
+        // The stage with butterfly span s reads twiddles [s - 1, 2s - 1)
+        for (size_t span = 1; span < half_; span <<= 1) {
+            for (size_t j = 0; j < span; j++) {
+                double angle = -kPi * j / span;
+                twiddleRe_[span - 1 + j] = static_cast<float>(std::cos(angle));
+                twiddleIm_[span - 1 + j] = static_cast<float>(std::sin(angle));
+            }
+        }
+        for (size_t k = 0; k <= half_; k++) {
+            double angle = -kPi * k / half_;
+            splitRe_[k] = static_cast<float>(std::cos(angle));
+            splitIm_[k] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    /**
+     * @param input size() real samples
+     * @param re, im Receive X[k] for k = 0 .. size()/2
+     */
+    void forward(const float* input, float* re, float* im) {
+        // Pack even/odd samples as one complex sequence of half the length
+        for (size_t n = 0; n < half_; n++) {
+            re_[bitReverse_[n]] = input[2 * n];
+            im_[bitReverse_[n]] = input[2 * n + 1];
+        }
+        transform();
+
+        // Split into the spectrum of the real input:
+        // X[k] = E[k] + W^k O[k], E = (Z[k] + Z*[N/2-k]) / 2, O = (Z[k] - Z*[N/2-k]) / 2i
+        for (size_t k = 0; k <= half_; k++) {
+            const size_t a = k == half_ ? 0 : k;
+            const size_t b = k == 0 ? 0 : half_ - k;
+            const float evenRe = 0.5f * (re_[a] + re_[b]);
+            const float evenIm = 0.5f * (im_[a] - im_[b]);
+            const float oddRe = 0.5f * (im_[a] + im_[b]);
+            const float oddIm = -0.5f * (re_[a] - re_[b]);
+            re[k] = evenRe + splitRe_[k] * oddRe - splitIm_[k] * oddIm;
+            im[k] = evenIm + splitRe_[k] * oddIm + splitIm_[k] * oddRe;
+        }
+    }
+
+    /**
+     * Inverse of forward(), including the 1/size() scaling.
+     * @param re, im size()/2 + 1 bins of a real signal's spectrum (DC and Nyquist imaginary parts zero)
+     * @param output Receives size() real samples
+     */
+    void inverse(const float* re, const float* im, float* output) {
+        // Rebuild Z[k] = E[k] + i O[k] with E = (X[k] + X*[N/2-k]) / 2, O = (X[k] - X*[N/2-k]) / 2W^k,
+        // conjugated so the forward butterflies compute the inverse transform
+        for (size_t k = 0; k < half_; k++) {
+            const size_t m = half_ - k;
+            const float evenRe = 0.5f * (re[k] + re[m]);
+            const float evenIm = 0.5f * (im[k] - im[m]);
+            const float diffRe = 0.5f * (re[k] - re[m]);
+            const float diffIm = 0.5f * (im[k] + im[m]);
+            // Multiply by conj(W^k) = 1 / W^k
+            const float oddRe = diffRe * splitRe_[k] + diffIm * splitIm_[k];
+            const float oddIm = diffIm * splitRe_[k] - diffRe * splitIm_[k];
+            re_[bitReverse_[k]] = evenRe - oddIm;
+            im_[bitReverse_[k]] = -(evenIm + oddRe);
+        }
+        transform();
+
+        const float scale = 1.0f / static_cast<float>(half_);
+        for (size_t n = 0; n < half_; n++) {
+            output[2 * n] = re_[n] * scale;
+            output[2 * n + 1] = -im_[n] * scale;
+        }
+    }
+
+    /**
+     * @param input size() real samples
+     * @param power Receives |X[k]|^2 for k = 0 .. size()/2
+     */
+    void powerSpectrum(const float* input, float* power) {
+        for (size_t n = 0; n < half_; n++) {
+            re_[bitReverse_[n]] = input[2 * n];
+            im_[bitReverse_[n]] = input[2 * n + 1];
+        }
+        transform();
+
+        for (size_t k = 0; k <= half_; k++) {
+            const size_t a = k == half_ ? 0 : k;
+            const size_t b = k == 0 ? 0 : half_ - k;
+            const float evenRe = 0.5f * (re_[a] + re_[b]);
+            const float evenIm = 0.5f * (im_[a] - im_[b]);
+            const float oddRe = 0.5f * (im_[a] + im_[b]);
+            const float oddIm = -0.5f * (re_[a] - re_[b]);
+            const float xRe = evenRe + splitRe_[k] * oddRe - splitIm_[k] * oddIm;
+            const float xIm = evenIm + splitRe_[k] * oddIm + splitIm_[k] * oddRe;
+            power[k] = xRe * xRe + xIm * xIm;
+        }
+    }
+
+    static size_t nextPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+private:
+    static constexpr double kPi = 3.14159265358979323846;
+
+    // In-place complex FFT of re_/im_, which are already in bit-reversed order
+    void transform() {
+        for (size_t span = 1; span < half_; span <<= 1) {
+            const float* wRe = &twiddleRe_[span - 1];
+            const float* wIm = &twiddleIm_[span - 1];
+            for (size_t i = 0; i < half_; i += 2 * span) {
+                float* aRe = &re_[i];
+                float* aIm = &im_[i];
+                float* bRe = &re_[i + span];
+                float* bIm = &im_[i + span];
+                size_t j = 0;
+#if defined(SAYSES_KERNELS_NEON)
+                for (; j + 4 <= span; j += 4) {
+                    const float32x4_t br = vld1q_f32(bRe + j);
+                    const float32x4_t bi = vld1q_f32(bIm + j);
+                    const float32x4_t wr = vld1q_f32(wRe + j);
+                    const float32x4_t wi = vld1q_f32(wIm + j);
+                    const float32x4_t tr = vsubq_f32(vmulq_f32(br, wr), vmulq_f32(bi, wi));
+                    const float32x4_t ti = vaddq_f32(vmulq_f32(br, wi), vmulq_f32(bi, wr));
+                    const float32x4_t ar = vld1q_f32(aRe + j);
+                    const float32x4_t ai = vld1q_f32(aIm + j);
+                    vst1q_f32(bRe + j, vsubq_f32(ar, tr));
+                    vst1q_f32(bIm + j, vsubq_f32(ai, ti));
+                    vst1q_f32(aRe + j, vaddq_f32(ar, tr));
+                    vst1q_f32(aIm + j, vaddq_f32(ai, ti));
+                }
+#elif defined(SAYSES_KERNELS_SSE2)
+                for (; j + 4 <= span; j += 4) {
+                    const __m128 br = _mm_loadu_ps(bRe + j);
+                    const __m128 bi = _mm_loadu_ps(bIm + j);
+                    const __m128 wr = _mm_loadu_ps(wRe + j);
+                    const __m128 wi = _mm_loadu_ps(wIm + j);
+                    const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+                    const __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+                    const __m128 ar = _mm_loadu_ps(aRe + j);
+                    const __m128 ai = _mm_loadu_ps(aIm + j);
+                    _mm_storeu_ps(bRe + j, _mm_sub_ps(ar, tr));
+                    _mm_storeu_ps(bIm + j, _mm_sub_ps(ai, ti));
+                    _mm_storeu_ps(aRe + j, _mm_add_ps(ar, tr));
+                    _mm_storeu_ps(aIm + j, _mm_add_ps(ai, ti));
+                }
+#endif
+                for (; j < span; j++) {
+                    const float tRe = bRe[j] * wRe[j] - bIm[j] * wIm[j];
+                    const float tIm = bRe[j] * wIm[j] + bIm[j] * wRe[j];
+                    bRe[j] = aRe[j] - tRe;
+                    bIm[j] = aIm[j] - tIm;
+                    aRe[j] += tRe;
+                    aIm[j] += tIm;
+                }
+            }
+        }
+    }
+
+    size_t size_;
+    size_t half_;
+    std::vector<uint32_t> bitReverse_;
+    std::vector<float> twiddleRe_;      // Per-stage twiddles, stage with span s at offset s - 1
+    std::vector<float> twiddleIm_;
+    std::vector<float> splitRe_;
+    std::vector<float> splitIm_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+};
+
+}  // namespace sayses
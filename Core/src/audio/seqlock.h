@@ -0,0 +1,77 @@
+/**
+ * SeqLock
+ * Single-writer, multi-reader publication of small POD snapshots
+ * Readers never block the writer; they retry if a write raced them
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sayses {
+
+/**
+ * Sequence lock around a trivially copyable value.
+ * The payload is stored as relaxed atomic words so concurrent
+ * reads and writes are well-defined; the sequence counter makes
+ * torn snapshots detectable.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() { store(T{}); }
+
+    /**
+     * Publish a new value. Must only be called from the single writer thread.
+     */
+    void store(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < kWords; ++i) {
+            data_[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Read a consistent snapshot. Wait-free for the writer, lock-free for readers.
+     */
+    T load() const {
+        uint64_t words[kWords];
+        uint32_t before;
+        uint32_t after;
+
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<uint64_t> data_[kWords];
+};
+
+}  // namespace sayses
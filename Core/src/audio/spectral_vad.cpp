@@ -0,0 +1,332 @@
+/**
+ * Spectral Voice Activity Detection Implementation
+ * Sub-band SNR against a minimum-statistics noise floor, gated by the share
+ * of energy in the speech band, with the same attack/hold as the energy VAD
+ */
+
+#include "vad.h"
+#include "audio_kernels.h"
+#include "real_fft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace sayses {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Analysis bands (Hz); the DC bin is skipped and bands above Nyquist dropped
+constexpr float kBandEdgesHz[] = {
+    0, 100, 250, 500, 750, 1000, 1250, 1500, 2000, 2500,
+    3000, 3500, 4000, 5000, 6500, 8000, 12000, 24000
+};
+constexpr int kMaxBands = sizeof(kBandEdgesHz) / sizeof(kBandEdgesHz[0]) - 1;
+constexpr float kSpeechLowHz = 250.0f;
+constexpr float kSpeechHighHz = 4000.0f;
+
+constexpr float kPreEmphasis = 0.9f;       // Keeps rumble from leaking into the speech bands
+constexpr float kEnergySmoothing = 0.5f;   // Per-hop smoothing of the energies the decision uses
+constexpr float kPowerSmoothing = 0.85f;   // Per-hop smoothing before the minimum search
+constexpr int kMinSubWindows = 8;          // Minimum statistics: window split into U sub-windows
+constexpr float kNoiseBias = 1.5f;         // Minimum of smoothed power underestimates the mean
+constexpr int kFormantBands = 4;           // SNR is averaged over the strongest speech bands
+constexpr float kMaxBandSnrDb = 30.0f;     // One loud band must not carry the average
+constexpr float kEnergyFloor = 1e-10f;
+
+}  // namespace
+
+class SpectralVoiceActivityDetector : public VoiceActivityDetector {
+public:
+    explicit SpectralVoiceActivityDetector(const Config& config);
+    ~SpectralVoiceActivityDetector() override = default;
+
+    bool process(const int16_t* samples, size_t frames) override;
+    bool process(const int16_t* samples, size_t frames,
+                 const AudioFrameFeatures& features) override;
+    bool isVoiceDetected() const override;
+    float getSignalLevel() const override;
+    void setThreshold(float threshold) override;
+    float getThreshold() const override;
+    void reset() override;
+
+private:
+    struct Band {
+        size_t firstBin;
+        size_t endBin;
+        bool speech;
+    };
+
+    bool analyzeHop();
+    void updateNoiseFloor();
+    void updateState(bool speechHop);
+
+    Config config_;
+
+    // Framing: hop = 10ms, analysis window = hop rounded up to a power of two
+    size_t hopSize_;
+    size_t fftSize_;
+    size_t pending_{0};
+    float lastInput_{0.0f};
+    bool primed_{false};                   // First hop seeds the smoothers
+    std::vector<float> history_;
+    std::vector<float> window_;
+    std::vector<float> windowed_;
+    std::vector<float> power_;
+    RealFft fft_;
+
+    // Per-band energies and minimum-statistics noise floor
+    std::vector<Band> bands_;
+    std::vector<float> bandEnergy_;
+    std::vector<float> smoothedPower_;
+    std::vector<float> subWindowMin_;      // Running minimum of the current sub-window
+    std::vector<float> windowMins_;        // kMinSubWindows minima per band, ring buffer
+    std::vector<float> noiseFloor_;
+    int subWindowHops_;
+    int subWindowCount_{0};
+    int subWindowIndex_{0};
+    int subWindowsFilled_{0};
+
+    // State
+    std::atomic<bool> voiceDetected_{false};
+    std::atomic<float> signalLevel_{0.0f};
+    std::atomic<float> threshold_;
+    float smoothedLevel_{0.0f};
+    static constexpr float kSmoothingFactor = 0.1f;
+
+    // Timing (in samples, advanced per hop)
+    int holdSamples_;
+    int attackSamples_;
+    int holdCounter_{0};
+    int attackCounter_{0};
+};
+
+// Factory
+std::unique_ptr<VoiceActivityDetector> VoiceActivityDetector::createSpectral(const Config& config) {
+    return std::make_unique<SpectralVoiceActivityDetector>(config);
+}
+
+SpectralVoiceActivityDetector::SpectralVoiceActivityDetector(const Config& config)
+    : config_(config)
+    , hopSize_(static_cast<size_t>(std::max(config.sampleRate / 100, 16)))
+    , fftSize_(RealFft::nextPowerOfTwo(hopSize_))
+    , history_(fftSize_, 0.0f)
+    , window_(fftSize_)
+    , windowed_(fftSize_)
+    , power_(fftSize_ / 2 + 1)
+    , fft_(fftSize_)
+    , threshold_(config.threshold) {
+
+    holdSamples_ = (config_.holdTimeMs * config_.sampleRate) / 1000;
+    attackSamples_ = (config_.attackTimeMs * config_.sampleRate) / 1000;
+
+    // Periodic Hann window
+    for (size_t i = 0; i < fftSize_; i++) {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * i / fftSize_));
+    }
+
+    const float binHz = static_cast<float>(config_.sampleRate) / fftSize_;
+    const size_t lastBin = fftSize_ / 2;
+    for (int b = 0; b < kMaxBands; b++) {
+        size_t first = std::max<size_t>(1, static_cast<size_t>(std::ceil(kBandEdgesHz[b] / binHz)));
+        size_t end = std::min(static_cast<size_t>(std::ceil(kBandEdgesHz[b + 1] / binHz)), lastBin + 1);
+        if (first >= end) {
+            continue;
+        }
+        bool speech = kBandEdgesHz[b] >= kSpeechLowHz && kBandEdgesHz[b + 1] <= kSpeechHighHz;
+        bands_.push_back({first, end, speech});
+    }
+
+    const size_t bandCount = bands_.size();
+    bandEnergy_.assign(bandCount, 0.0f);
+    smoothedPower_.assign(bandCount, 0.0f);
+    subWindowMin_.assign(bandCount, std::numeric_limits<float>::max());
+    windowMins_.assign(bandCount * kMinSubWindows, std::numeric_limits<float>::max());
+    noiseFloor_.assign(bandCount, 0.0f);
+
+    int windowHops = std::max(config_.noiseWindowMs / 10, kMinSubWindows);
+    subWindowHops_ = windowHops / kMinSubWindows;
+}
+
+bool SpectralVoiceActivityDetector::process(const int16_t* samples, size_t frames) {
+    return process(samples, frames, kernels::analyzeFrame(samples, frames));
+}
+
+bool SpectralVoiceActivityDetector::process(const int16_t* samples, size_t frames,
+                                            const AudioFrameFeatures& features) {
+    smoothedLevel_ = smoothedLevel_ * (1.0f - kSmoothingFactor) + features.rms * kSmoothingFactor;
+    signalLevel_ = smoothedLevel_;
+
+    // Slide the samples into the analysis window; analyze every full hop
+    size_t offset = 0;
+    while (offset < frames) {
+        size_t take = std::min(frames - offset, hopSize_ - pending_);
+        std::memmove(history_.data(), history_.data() + take, (fftSize_ - take) * sizeof(float));
+        float* tail = history_.data() + fftSize_ - take;
+        kernels::int16ToFloat(samples + offset, tail, take);
+        for (size_t i = 0; i < take; i++) {
+            float input = tail[i];
+            tail[i] = input - kPreEmphasis * lastInput_;
+            lastInput_ = input;
+        }
+        pending_ += take;
+        offset += take;
+
+        if (pending_ == hopSize_) {
+            pending_ = 0;
+            updateState(analyzeHop());
+        }
+    }
+
+    return voiceDetected_;
+}
+
+bool SpectralVoiceActivityDetector::analyzeHop() {
+    for (size_t i = 0; i < fftSize_; i++) {
+        windowed_[i] = history_[i] * window_[i];
+    }
+    fft_.powerSpectrum(windowed_.data(), power_.data());
+
+    for (size_t b = 0; b < bands_.size(); b++) {
+        float energy = kEnergyFloor;
+        for (size_t k = bands_[b].firstBin; k < bands_[b].endBin; k++) {
+            energy += power_[k];
+        }
+        bandEnergy_[b] = primed_ ? kEnergySmoothing * bandEnergy_[b] + (1.0f - kEnergySmoothing) * energy
+                                 : energy;
+    }
+
+    updateNoiseFloor();
+    primed_ = true;
+
+    // A-posteriori SNR of the speech bands, each clamped to [0, 30] dB, and
+    // the speech bands' share of the energy above the noise floor
+    float snrDb[kMaxBands];
+    int speechBands = 0;
+    float speechExcess = 0.0f;
+    float totalExcess = kEnergyFloor;
+    for (size_t b = 0; b < bands_.size(); b++) {
+        float excess = std::max(bandEnergy_[b] - noiseFloor_[b], 0.0f);
+        totalExcess += excess;
+        if (!bands_[b].speech) {
+            continue;
+        }
+        float snr = 10.0f * std::log10(bandEnergy_[b] / std::max(noiseFloor_[b], kEnergyFloor));
+        snrDb[speechBands++] = std::min(std::max(snr, 0.0f), kMaxBandSnrDb);
+        speechExcess += excess;
+    }
+
+    // Voiced speech concentrates in a few formant bands: average the strongest
+    int formants = std::min(kFormantBands, speechBands);
+    std::partial_sort(snrDb, snrDb + formants, snrDb + speechBands, std::greater<float>());
+    float snrSum = 0.0f;
+    for (int i = 0; i < formants; i++) {
+        snrSum += snrDb[i];
+    }
+    float meanSnrDb = formants > 0 ? snrSum / formants : 0.0f;
+
+    float level = smoothedLevel_;
+    bool loudEnough = level > threshold_.load() && level > config_.minSignalLevel;
+    return loudEnough &&
+           meanSnrDb > config_.snrThresholdDb &&
+           speechExcess / totalExcess > config_.speechBandRatio;
+}
+
+void SpectralVoiceActivityDetector::updateNoiseFloor() {
+    const size_t bandCount = bands_.size();
+    for (size_t b = 0; b < bandCount; b++) {
+        smoothedPower_[b] = !primed_ ? bandEnergy_[b]
+                                     : kPowerSmoothing * smoothedPower_[b] +
+                                       (1.0f - kPowerSmoothing) * bandEnergy_[b];
+        subWindowMin_[b] = std::min(subWindowMin_[b], smoothedPower_[b]);
+    }
+
+    // Close a sub-window: O(U) per band, every subWindowHops_ hops
+    if (++subWindowCount_ >= subWindowHops_) {
+        subWindowCount_ = 0;
+        for (size_t b = 0; b < bandCount; b++) {
+            windowMins_[b * kMinSubWindows + subWindowIndex_] = subWindowMin_[b];
+            subWindowMin_[b] = std::numeric_limits<float>::max();
+        }
+        subWindowIndex_ = (subWindowIndex_ + 1) % kMinSubWindows;
+        subWindowsFilled_ = std::min(subWindowsFilled_ + 1, kMinSubWindows);
+    }
+
+    for (size_t b = 0; b < bandCount; b++) {
+        float minimum = subWindowMin_[b];
+        const float* mins = &windowMins_[b * kMinSubWindows];
+        for (int u = 0; u < subWindowsFilled_; u++) {
+            minimum = std::min(minimum, mins[u]);
+        }
+        if (minimum == std::numeric_limits<float>::max()) {
+            minimum = smoothedPower_[b];
+        }
+        noiseFloor_[b] = kNoiseBias * minimum;
+    }
+}
+
+void SpectralVoiceActivityDetector::updateState(bool speechHop) {
+    const int hop = static_cast<int>(hopSize_);
+
+    if (speechHop) {
+        attackCounter_ += hop;
+        if (attackCounter_ >= attackSamples_) {
+            voiceDetected_ = true;
+            holdCounter_ = holdSamples_;
+        }
+    } else {
+        attackCounter_ = 0;
+        if (holdCounter_ > 0) {
+            holdCounter_ -= hop;
+            if (holdCounter_ <= 0) {
+                voiceDetected_ = false;
+                holdCounter_ = 0;
+            }
+        }
+    }
+}
+
+bool SpectralVoiceActivityDetector::isVoiceDetected() const {
+    return voiceDetected_;
+}
+
+float SpectralVoiceActivityDetector::getSignalLevel() const {
+    return signalLevel_;
+}
+
+void SpectralVoiceActivityDetector::setThreshold(float threshold) {
+    threshold_ = std::max(0.0f, std::min(1.0f, threshold));
+}
+
+float SpectralVoiceActivityDetector::getThreshold() const {
+    return threshold_;
+}
+
+void SpectralVoiceActivityDetector::reset() {
+    voiceDetected_ = false;
+    signalLevel_ = 0.0f;
+    smoothedLevel_ = 0.0f;
+    holdCounter_ = 0;
+    attackCounter_ = 0;
+
+    pending_ = 0;
+    lastInput_ = 0.0f;
+    primed_ = false;
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    std::fill(bandEnergy_.begin(), bandEnergy_.end(), 0.0f);
+    std::fill(smoothedPower_.begin(), smoothedPower_.end(), 0.0f);
+    std::fill(subWindowMin_.begin(), subWindowMin_.end(), std::numeric_limits<float>::max());
+    std::fill(windowMins_.begin(), windowMins_.end(), std::numeric_limits<float>::max());
+    std::fill(noiseFloor_.begin(), noiseFloor_.end(), 0.0f);
+    subWindowCount_ = 0;
+    subWindowIndex_ = 0;
+    subWindowsFilled_ = 0;
+}
+
+}  // namespace sayses
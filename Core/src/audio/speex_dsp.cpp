@@ -1,15 +1,17 @@
 /**
  * Speex DSP Implementation
- * Wrapper around libspeexdsp for preprocessing and resampling
+ * Wrapper around libspeexdsp for preprocessing, resampling and echo cancellation
  */
 
 #include "speex_dsp.h"
+#include "audio_kernels.h"
 
+#include <speex/speex_echo.h>
 #include <speex/speex_preprocess.h>
 #include <speex/speex_resampler.h>
 
-#include <cmath>
 #include <algorithm>
+#include <vector>
 
 namespace sayses {
 
@@ -23,8 +25,8 @@ public:
     ~SpeexPreprocessorImpl() override;
 
     bool process(int16_t* samples, size_t frames) override;
+    bool process(float* samples, size_t frames) override;
     float getSpeechProbability() const override;
-    float getInputLevel() const override;
     void setDenoiseEnabled(bool enabled) override;
     void setAgcEnabled(bool enabled) override;
     void setDereverbEnabled(bool enabled) override;
@@ -36,7 +38,7 @@ private:
     Config config_;
     SpeexPreprocessState* state_{nullptr};
     float speechProbability_{0.0f};
-    float inputLevel_{0.0f};
+    std::vector<int16_t> int16Frame_;  // Float frames go through int16
 };
 
 std::unique_ptr<SpeexPreprocessor> SpeexPreprocessor::create(const Config& config) {
@@ -44,7 +46,8 @@ std::unique_ptr<SpeexPreprocessor> SpeexPreprocessor::create(const Config& confi
 }
 
 SpeexPreprocessorImpl::SpeexPreprocessorImpl(const Config& config)
-    : config_(config) {
+    : config_(config)
+    , int16Frame_(static_cast<size_t>(std::max(config.frameSize, 0))) {
 
     // Create preprocessor state
     state_ = speex_preprocess_state_init(config_.frameSize, config_.sampleRate);
@@ -117,23 +120,21 @@ bool SpeexPreprocessorImpl::process(int16_t* samples, size_t frames) {
     speex_preprocess_ctl(state_, SPEEX_PREPROCESS_GET_PROB, &prob);
     speechProbability_ = prob / 100.0f;
 
-    // Calculate input level (RMS after processing)
-    double sum = 0.0;
-    for (size_t i = 0; i < frames; i++) {
-        double normalized = samples[i] / 32768.0;
-        sum += normalized * normalized;
-    }
-    inputLevel_ = static_cast<float>(std::sqrt(sum / frames));
-
     return vadResult != 0;
 }
 
-float SpeexPreprocessorImpl::getSpeechProbability() const {
-    return speechProbability_;
+bool SpeexPreprocessorImpl::process(float* samples, size_t frames) {
+    if (frames != int16Frame_.size()) {
+        return false;
+    }
+    kernels::floatToInt16(samples, int16Frame_.data(), frames);
+    bool result = process(int16Frame_.data(), frames);
+    kernels::int16ToFloat(int16Frame_.data(), samples, frames);
+    return result;
 }
 
-float SpeexPreprocessorImpl::getInputLevel() const {
-    return inputLevel_;
+float SpeexPreprocessorImpl::getSpeechProbability() const {
+    return speechProbability_;
 }
 
 void SpeexPreprocessorImpl::setDenoiseEnabled(bool enabled) {
@@ -169,13 +170,14 @@ void SpeexPreprocessorImpl::reset() {
         }
     }
     speechProbability_ = 0.0f;
-    inputLevel_ = 0.0f;
 }
 
 // ============================================================================
 // SpeexResampler Implementation
 // ============================================================================
 
+constexpr size_t kResamplerChunkFrames = 512;  // Float input rescaled per libspeexdsp call
+
 class SpeexResamplerImpl : public SpeexResampler {
 public:
     SpeexResamplerImpl(int channels, int inputRate, int outputRate, Quality quality);
@@ -183,6 +185,8 @@ public:
 
     bool process(const int16_t* input, size_t& inputFrames,
                  int16_t* output, size_t& outputFrames) override;
+    bool process(const float* input, size_t& inputFrames,
+                 float* output, size_t& outputFrames) override;
     float getRatio() const override;
     void reset() override;
     int getLatency() const override;
@@ -192,9 +196,20 @@ private:
     int inputRate_;
     int outputRate_;
     SpeexResamplerState* state_{nullptr};
+    std::vector<float> scaled_;  // Float input at the int16 scale libspeexdsp expects
 };
 
 std::unique_ptr<SpeexResampler> SpeexResampler::create(
+    int channels, int inputRate, int outputRate, Quality quality) {
+    if (static_cast<int>(quality) <= static_cast<int>(Quality::VoIP)) {
+        if (auto polyphase = createPolyphase(channels, inputRate, outputRate)) {
+            return polyphase;
+        }
+    }
+    return createSpeex(channels, inputRate, outputRate, quality);
+}
+
+std::unique_ptr<SpeexResampler> SpeexResampler::createSpeex(
     int channels, int inputRate, int outputRate, Quality quality) {
     return std::make_unique<SpeexResamplerImpl>(channels, inputRate, outputRate, quality);
 }
@@ -202,7 +217,8 @@ std::unique_ptr<SpeexResampler> SpeexResampler::create(
 SpeexResamplerImpl::SpeexResamplerImpl(int channels, int inputRate, int outputRate, Quality quality)
     : channels_(channels)
     , inputRate_(inputRate)
-    , outputRate_(outputRate) {
+    , outputRate_(outputRate)
+    , scaled_(kResamplerChunkFrames) {
 
     int err;
     state_ = speex_resampler_init(
@@ -249,6 +265,47 @@ bool SpeexResamplerImpl::process(const int16_t* input, size_t& inputFrames,
     return err == RESAMPLER_ERR_SUCCESS;
 }
 
+bool SpeexResamplerImpl::process(const float* input, size_t& inputFrames,
+                                  float* output, size_t& outputFrames) {
+    if (!state_) {
+        return false;
+    }
+
+    // libspeexdsp's float API works at int16 scale in both its builds, so
+    // the input is rescaled through a preallocated chunk buffer
+    size_t consumed = 0;
+    size_t produced = 0;
+    int err = RESAMPLER_ERR_SUCCESS;
+    while (consumed < inputFrames && produced < outputFrames) {
+        size_t chunk = std::min(inputFrames - consumed, scaled_.size());
+        for (size_t i = 0; i < chunk; i++) {
+            scaled_[i] = input[consumed + i] * 32768.0f;
+        }
+
+        spx_uint32_t inLen = static_cast<spx_uint32_t>(chunk);
+        spx_uint32_t outLen = static_cast<spx_uint32_t>(outputFrames - produced);
+        err = speex_resampler_process_float(
+            state_,
+            0,  // Channel 0 (mono)
+            scaled_.data(),
+            &inLen,
+            output + produced,
+            &outLen
+        );
+        if (err != RESAMPLER_ERR_SUCCESS || (inLen == 0 && outLen == 0)) {
+            break;
+        }
+        consumed += inLen;
+        produced += outLen;
+    }
+
+    inputFrames = consumed;
+    outputFrames = produced;
+    kernels::applyGain(output, outputFrames, kernels::kInt16ToFloat);
+
+    return err == RESAMPLER_ERR_SUCCESS;
+}
+
 float SpeexResamplerImpl::getRatio() const {
     return static_cast<float>(outputRate_) / inputRate_;
 }
@@ -264,4 +321,69 @@ int SpeexResamplerImpl::getLatency() const {
     return speex_resampler_get_input_latency(state_);
 }
 
+// ============================================================================
+// SpeexEchoCanceller Implementation
+// ============================================================================
+
+class SpeexEchoCancellerImpl : public SpeexEchoCanceller {
+public:
+    SpeexEchoCancellerImpl(int sampleRate, int frameSize, int tailMs);
+    ~SpeexEchoCancellerImpl() override;
+
+    bool process(const int16_t* captured, const int16_t* played,
+                 int16_t* output, size_t frames) override;
+    int getTailMs() const override;
+    void reset() override;
+
+private:
+    int frameSize_;
+    int tailMs_;
+    SpeexEchoState* state_{nullptr};
+};
+
+std::unique_ptr<SpeexEchoCanceller> SpeexEchoCanceller::create(int sampleRate, int frameSize, int tailMs) {
+    return std::make_unique<SpeexEchoCancellerImpl>(sampleRate, frameSize, tailMs);
+}
+
+SpeexEchoCancellerImpl::SpeexEchoCancellerImpl(int sampleRate, int frameSize, int tailMs)
+    : frameSize_(frameSize)
+    , tailMs_(tailMs) {
+
+    // Filter length in samples, a whole number of frames
+    int frames = std::max(1, (tailMs * sampleRate / 1000 + frameSize - 1) / frameSize);
+    state_ = speex_echo_state_init(frameSize, frames * frameSize);
+
+    if (state_) {
+        int rate = sampleRate;
+        speex_echo_ctl(state_, SPEEX_ECHO_SET_SAMPLING_RATE, &rate);
+    }
+}
+
+SpeexEchoCancellerImpl::~SpeexEchoCancellerImpl() {
+    if (state_) {
+        speex_echo_state_destroy(state_);
+        state_ = nullptr;
+    }
+}
+
+bool SpeexEchoCancellerImpl::process(const int16_t* captured, const int16_t* played,
+                                     int16_t* output, size_t frames) {
+    if (!state_ || frames != static_cast<size_t>(frameSize_)) {
+        return false;
+    }
+
+    speex_echo_cancellation(state_, captured, played, output);
+    return true;
+}
+
+int SpeexEchoCancellerImpl::getTailMs() const {
+    return tailMs_;
+}
+
+void SpeexEchoCancellerImpl::reset() {
+    if (state_) {
+        speex_echo_state_reset(state_);
+    }
+}
+
 }  // namespace sayses
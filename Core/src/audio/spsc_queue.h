@@ -0,0 +1,98 @@
+/**
+ * SPSC Queue
+ * Bounded single-producer / single-consumer queue of fixed-size slots
+ * Slots are preallocated and filled in place, so neither side allocates or copies twice
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace sayses {
+
+/**
+ * Lock-free bounded queue for handing fixed-size records between two threads.
+ * The producer calls writeSlot()/publish(), the consumer readSlot()/release().
+ * Positions grow monotonically; capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscQueue slots must be trivially copyable");
+
+public:
+    explicit SpscQueue(size_t capacity)
+        : capacity_(roundUp(capacity))
+        , mask_(capacity_ - 1)
+        , slots_(std::make_unique<T[]>(capacity_)) {
+    }
+
+    /**
+     * Producer: get the next free slot, or nullptr if the queue is full.
+     */
+    T* writeSlot() {
+        uint64_t write = writePos_.load(std::memory_order_relaxed);
+        if (write - readPos_.load(std::memory_order_acquire) >= capacity_) {
+            return nullptr;
+        }
+        return &slots_[write & mask_];
+    }
+
+    /**
+     * Producer: make the slot returned by writeSlot() visible to the consumer.
+     */
+    void publish() {
+        writePos_.store(writePos_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Consumer: get the oldest published slot, or nullptr if the queue is empty.
+     */
+    const T* readSlot() const {
+        uint64_t read = readPos_.load(std::memory_order_relaxed);
+        if (read == writePos_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots_[read & mask_];
+    }
+
+    /**
+     * Consumer: hand the slot returned by readSlot() back to the producer.
+     */
+    void release() {
+        readPos_.store(readPos_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Number of published slots (approximate when called from a third thread).
+     */
+    size_t size() const {
+        return static_cast<size_t>(writePos_.load(std::memory_order_acquire) -
+                                   readPos_.load(std::memory_order_acquire));
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t roundUp(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<uint64_t> writePos_{0};
+    alignas(64) std::atomic<uint64_t> readPos_{0};
+};
+
+}  // namespace sayses
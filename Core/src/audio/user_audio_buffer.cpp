@@ -5,8 +5,12 @@
  */
 
 #include "user_audio_buffer.h"
+#include "audio_kernels.h"
+#include "seqlock.h"
 
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <chrono>
 
@@ -71,18 +75,35 @@ void CrossfadeImpl::applyFadeOut(float* samples, size_t frames) {
 // FloatMixer Implementation
 // ============================================================================
 
+/**
+ * Peak limiter constants.
+ * The limiter sees the whole mixed frame plus a short lookahead before it
+ * is output, so the gain always ramps down over at least kLimiterLookahead
+ * samples before a peak arrives, even when the peak opens a frame.
+ */
+constexpr float kLimiterThreshold = 0.891f;   // -1 dBFS ceiling
+constexpr float kLimiterRelease = 0.2f;       // Fraction of the gap recovered per frame
+constexpr size_t kLimiterLookahead = 32;      // Minimum attack (0.67ms at 48kHz), also the added delay
+
 class FloatMixerImpl : public FloatMixer {
 public:
     explicit FloatMixerImpl(int frameSize);
 
     void clear() override;
     void add(const float* samples, size_t frames) override;
+    void add(const float* samples, size_t frames, float startGain, float endGain) override;
     void getMixed(int16_t* output, size_t frames) override;
+    void getMixed(float* output, size_t frames) override;
     const float* getFloatBuffer() const override { return mixBuffer_.data(); }
 
 private:
+    void limit(float* output, size_t frames);
+
     int frameSize_;
     std::vector<float> mixBuffer_;
+    std::vector<float> limiterBuffer_;  // Lookahead tail followed by the frame being limited
+    std::vector<float> outputBuffer_;
+    float limiterGain_{1.0f};
 };
 
 std::unique_ptr<FloatMixer> FloatMixer::create(int frameSize) {
@@ -91,7 +112,9 @@ std::unique_ptr<FloatMixer> FloatMixer::create(int frameSize) {
 
 FloatMixerImpl::FloatMixerImpl(int frameSize)
     : frameSize_(frameSize)
-    , mixBuffer_(frameSize, 0.0f) {
+    , mixBuffer_(frameSize, 0.0f)
+    , limiterBuffer_(frameSize + kLimiterLookahead, 0.0f)
+    , outputBuffer_(frameSize, 0.0f) {
 }
 
 void FloatMixerImpl::clear() {
@@ -100,28 +123,259 @@ void FloatMixerImpl::clear() {
 
 void FloatMixerImpl::add(const float* samples, size_t frames) {
     size_t addFrames = std::min(frames, static_cast<size_t>(frameSize_));
-    for (size_t i = 0; i < addFrames; ++i) {
-        mixBuffer_[i] += samples[i];
+    kernels::accumulate(mixBuffer_.data(), samples, addFrames);
+}
+
+void FloatMixerImpl::add(const float* samples, size_t frames, float startGain, float endGain) {
+    size_t addFrames = std::min(frames, static_cast<size_t>(frameSize_));
+    if (startGain != endGain) {
+        kernels::accumulateScaledRamp(mixBuffer_.data(), samples, addFrames, startGain, endGain);
+    } else if (endGain == 1.0f) {
+        kernels::accumulate(mixBuffer_.data(), samples, addFrames);
+    } else if (endGain != 0.0f) {
+        kernels::accumulateScaled(mixBuffer_.data(), samples, addFrames, endGain);
     }
 }
 
 void FloatMixerImpl::getMixed(int16_t* output, size_t frames) {
     size_t outFrames = std::min(frames, static_cast<size_t>(frameSize_));
-    for (size_t i = 0; i < outFrames; ++i) {
-        float sample = mixBuffer_[i];
+    limit(outputBuffer_.data(), outFrames);
 
-        // Soft clipping
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
+    // Saturating conversion catches anything the limiter let through
+    kernels::floatToInt16(outputBuffer_.data(), output, outFrames);
+}
+
+void FloatMixerImpl::getMixed(float* output, size_t frames) {
+    size_t outFrames = std::min(frames, static_cast<size_t>(frameSize_));
+    limit(output, outFrames);
 
-        output[i] = static_cast<int16_t>(sample * 32767.0f);
+    // Float devices don't saturate for us
+    kernels::clip(output, outFrames);
+}
+
+void FloatMixerImpl::limit(float* output, size_t frames) {
+    // limiterBuffer_ holds the previous call's lookahead tail; the mix goes
+    // behind it. The first `frames` samples are limited and output, the last
+    // kLimiterLookahead carry over to the next call. getFloatBuffer() keeps
+    // returning the raw mix.
+    float* samples = limiterBuffer_.data();
+    std::copy(mixBuffer_.begin(), mixBuffer_.begin() + frames, samples + kLimiterLookahead);
+
+    float peak = kernels::maxAbs(samples, frames + kLimiterLookahead);
+    float target = peak > kLimiterThreshold ? kLimiterThreshold / peak : 1.0f;
+
+    if (target >= 1.0f && limiterGain_ >= 1.0f) {
+        // Fast path: nothing to do
+    } else if (target < limiterGain_) {
+        // Attack: reach the target gain by the first sample that would exceed
+        // the ceiling at the current gain, so no sample overshoots. A peak
+        // is seen kLimiterLookahead samples before it is output, so the ramp
+        // is never shorter than that.
+        size_t rampFrames = 0;
+        float trigger = kLimiterThreshold / limiterGain_;
+        while (rampFrames < frames && std::fabs(samples[rampFrames]) <= trigger) {
+            ++rampFrames;
+        }
+        kernels::applyGainRamp(samples, rampFrames, limiterGain_, target);
+        kernels::applyGain(samples + rampFrames, frames - rampFrames, target);
+        limiterGain_ = target;
+    } else {
+        // Release: recover gradually towards the target. The ramp stays at or
+        // below the target, so this frame can't overshoot either.
+        float next = limiterGain_ + (target - limiterGain_) * kLimiterRelease;
+        if (target - next < 1e-4f) {
+            next = target;
+        }
+        kernels::applyGainRamp(samples, frames, limiterGain_, next);
+        limiterGain_ = next;
     }
+
+    std::copy(samples, samples + frames, output);
+    std::copy(samples + frames, samples + frames + kLimiterLookahead, samples);
+}
+
+// ============================================================================
+// SampleRing Implementation
+// ============================================================================
+
+/**
+ * Fixed-capacity contiguous single-producer/single-consumer ring of mono samples.
+ * Storage is either float or int16; reads always produce float.
+ * Positions are monotonic counters, masked into a power-of-two capacity.
+ * The producer only advances writePos_, the consumer only advances readPos_,
+ * so neither side ever waits for the other.
+ */
+class SampleRing {
+public:
+    SampleRing(size_t minCapacity, bool storeInt16);
+
+    size_t size() const {
+        uint64_t write = writePos_.load(std::memory_order_acquire);
+        uint64_t read = readPos_.load(std::memory_order_acquire);
+        return static_cast<size_t>(write - read);
+    }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Append samples, converting to the storage format (producer only).
+     * @return Number of samples dropped because the ring was full
+     */
+    size_t write(const int16_t* input, size_t frames);
+    size_t write(const float* input, size_t frames);
+
+    /**
+     * Pop up to frames samples as float (consumer only).
+     * @return Number of samples read
+     */
+    size_t read(float* output, size_t frames);
+
+    /**
+     * Drop the oldest samples without reading them (consumer only).
+     */
+    void discard(size_t frames);
+
+    /**
+     * Position after the last written sample (producer only).
+     */
+    uint64_t writePosition() const { return writePos_.load(std::memory_order_relaxed); }
+
+    /**
+     * Drop every sample before position, keeping later writes (consumer only).
+     */
+    void discardTo(uint64_t position);
+
+private:
+    size_t capacity_;
+    size_t mask_;
+    bool storeInt16_;
+    std::vector<float> floatData_;
+    std::vector<int16_t> int16Data_;
+
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<uint64_t> readPos_{0};
+    alignas(64) std::atomic<uint64_t> writePos_{0};
+};
+
+static size_t nextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+SampleRing::SampleRing(size_t minCapacity, bool storeInt16)
+    : capacity_(nextPowerOfTwo(minCapacity))
+    , mask_(capacity_ - 1)
+    , storeInt16_(storeInt16) {
+
+    if (storeInt16_) {
+        int16Data_.resize(capacity_);
+    } else {
+        floatData_.resize(capacity_);
+    }
+}
+
+size_t SampleRing::write(const int16_t* input, size_t frames) {
+    uint64_t write = writePos_.load(std::memory_order_relaxed);
+    uint64_t read = readPos_.load(std::memory_order_acquire);
+
+    // The producer can't move the read position, so overflow drops the newest samples
+    size_t space = capacity_ - static_cast<size_t>(write - read);
+    size_t writeFrames = std::min(frames, space);
+
+    // Contiguous write split at the wrap point
+    size_t start = static_cast<size_t>(write) & mask_;
+    size_t first = std::min(writeFrames, capacity_ - start);
+    size_t second = writeFrames - first;
+
+    if (storeInt16_) {
+        std::memcpy(int16Data_.data() + start, input, first * sizeof(int16_t));
+        std::memcpy(int16Data_.data(), input + first, second * sizeof(int16_t));
+    } else {
+        kernels::int16ToFloat(input, floatData_.data() + start, first);
+        kernels::int16ToFloat(input + first, floatData_.data(), second);
+    }
+
+    writePos_.store(write + writeFrames, std::memory_order_release);
+    return frames - writeFrames;
+}
+
+size_t SampleRing::write(const float* input, size_t frames) {
+    uint64_t write = writePos_.load(std::memory_order_relaxed);
+    uint64_t read = readPos_.load(std::memory_order_acquire);
+
+    size_t space = capacity_ - static_cast<size_t>(write - read);
+    size_t writeFrames = std::min(frames, space);
+
+    size_t start = static_cast<size_t>(write) & mask_;
+    size_t first = std::min(writeFrames, capacity_ - start);
+    size_t second = writeFrames - first;
+
+    if (storeInt16_) {
+        kernels::floatToInt16(input, int16Data_.data() + start, first);
+        kernels::floatToInt16(input + first, int16Data_.data(), second);
+    } else {
+        std::memcpy(floatData_.data() + start, input, first * sizeof(float));
+        std::memcpy(floatData_.data(), input + first, second * sizeof(float));
+    }
+
+    writePos_.store(write + writeFrames, std::memory_order_release);
+    return frames - writeFrames;
+}
+
+size_t SampleRing::read(float* output, size_t frames) {
+    uint64_t read = readPos_.load(std::memory_order_relaxed);
+    uint64_t write = writePos_.load(std::memory_order_acquire);
+    size_t readFrames = std::min(frames, static_cast<size_t>(write - read));
+
+    size_t start = static_cast<size_t>(read) & mask_;
+    size_t first = std::min(readFrames, capacity_ - start);
+    size_t second = readFrames - first;
+
+    if (storeInt16_) {
+        kernels::int16ToFloat(int16Data_.data() + start, output, first);
+        kernels::int16ToFloat(int16Data_.data(), output + first, second);
+    } else {
+        std::memcpy(output, floatData_.data() + start, first * sizeof(float));
+        std::memcpy(output + first, floatData_.data(), second * sizeof(float));
+    }
+
+    readPos_.store(read + readFrames, std::memory_order_release);
+    return readFrames;
+}
+
+void SampleRing::discard(size_t frames) {
+    uint64_t read = readPos_.load(std::memory_order_relaxed);
+    uint64_t write = writePos_.load(std::memory_order_acquire);
+    size_t discardFrames = std::min(frames, static_cast<size_t>(write - read));
+    readPos_.store(read + discardFrames, std::memory_order_release);
+}
+
+void SampleRing::discardTo(uint64_t position) {
+    uint64_t read = readPos_.load(std::memory_order_relaxed);
+    if (position <= read) {
+        return;
+    }
+    uint64_t write = writePos_.load(std::memory_order_acquire);
+    readPos_.store(std::min(position, write), std::memory_order_release);
 }
 
 // ============================================================================
 // UserAudioBuffer Implementation
 // ============================================================================
 
+// Largest single write we expect: one 120ms Opus packet
+constexpr int kMaxWriteMs = 120;
+
+/**
+ * Lock-free per-user buffer.
+ * Threading model: addSamples() and reset() are called from one producer
+ * (network/decode) thread, readFloat() from one consumer (render) thread.
+ * Each side owns its own state and publishes its counters through a SeqLock,
+ * so getStats() can be called from anywhere without blocking either side.
+ */
 class UserAudioBufferImpl : public UserAudioBuffer {
 public:
     UserAudioBufferImpl(uint32_t userId, const Config& config);
@@ -129,7 +383,10 @@ public:
     uint32_t getUserId() const override { return userId_; }
     void addSamples(const int16_t* samples, size_t frames,
                     int64_t sequence, bool isPLC) override;
+    void addSamples(const float* samples, size_t frames,
+                    int64_t sequence, bool isPLC) override;
     size_t readFloat(float* output, size_t frames) override;
+    size_t skip(size_t frames) override;
     bool isReady() const override;
     bool isActive() const override;
     Stats getStats() const override;
@@ -137,32 +394,58 @@ public:
     void notifyTalkingEnded() override;
 
 private:
-    void convertToFloat(const int16_t* input, size_t frames);
+    // Counters owned by the producer thread
+    struct ProducerStats {
+        uint32_t packetsReceived = 0;
+        uint32_t packetsDecoded = 0;
+        uint32_t sequenceGaps = 0;
+        uint32_t plcFrames = 0;
+        uint32_t droppedWrites = 0;
+        int64_t lastSequence = -1;
+        int maxGapMs = 0;
+    };
+
+    // Counters owned by the consumer thread
+    struct ConsumerStats {
+        uint32_t bufferUnderruns = 0;
+        uint32_t bufferOverruns = 0;
+        uint32_t fadeIns = 0;
+        uint32_t fadeOuts = 0;
+    };
+
+    template <typename Sample>
+    void writeSamples(const Sample* samples, size_t frames, int64_t sequence, bool isPLC);
     void detectSequenceGap(int64_t sequence);
+    bool beginRead();
 
     uint32_t userId_;
     Config config_;
     std::unique_ptr<Crossfade> crossfade_;
 
-    mutable std::mutex mutex_;
-
-    // Float buffer (ring buffer)
-    std::deque<float> buffer_;
+    // Sample storage (preallocated, never grows)
+    SampleRing buffer_;
     size_t minBufferSize_;
     size_t maxBufferSize_;
 
-    // Sequence tracking
+    // Producer state
     int64_t lastSequence_{-1};
     int64_t sequenceIncrement_{1};
+    std::chrono::steady_clock::time_point lastPacketTime_;
+    ProducerStats producerStats_;
 
-    // State
-    bool playbackStarted_{false};
+    // Consumer state
+    std::atomic<bool> playbackStarted_{false};
     bool needsFadeIn_{true};
-    bool needsFadeOut_{false};
-    std::chrono::steady_clock::time_point lastPacketTime_;
+    ConsumerStats consumerStats_;
+
+    // Cross-thread requests
+    std::atomic<bool> needsFadeOut_{false};
+    std::atomic<bool> flushRequested_{false};
+    std::atomic<uint64_t> flushPosition_{0};  // Write position at the last reset()
 
-    // Statistics
-    Stats stats_;
+    // Statistics snapshots
+    SeqLock<ProducerStats> producerSnapshot_;
+    SeqLock<ConsumerStats> consumerSnapshot_;
 };
 
 std::unique_ptr<UserAudioBuffer> UserAudioBuffer::create(uint32_t userId, const Config& config) {
@@ -172,7 +455,9 @@ std::unique_ptr<UserAudioBuffer> UserAudioBuffer::create(uint32_t userId, const
 UserAudioBufferImpl::UserAudioBufferImpl(uint32_t userId, const Config& config)
     : userId_(userId)
     , config_(config)
-    , crossfade_(Crossfade::create(config.frameSize)) {
+    , crossfade_(Crossfade::create(config.frameSize))
+    , buffer_(static_cast<size_t>((config.maxBufferMs + kMaxWriteMs) * config.sampleRate) / 1000,
+              config.storeInt16) {
 
     // Calculate buffer sizes in samples
     minBufferSize_ = (config_.minBufferMs * config_.sampleRate) / 1000;
@@ -183,8 +468,17 @@ UserAudioBufferImpl::UserAudioBufferImpl(uint32_t userId, const Config& config)
 
 void UserAudioBufferImpl::addSamples(const int16_t* samples, size_t frames,
                                       int64_t sequence, bool isPLC) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    writeSamples(samples, frames, sequence, isPLC);
+}
 
+void UserAudioBufferImpl::addSamples(const float* samples, size_t frames,
+                                      int64_t sequence, bool isPLC) {
+    writeSamples(samples, frames, sequence, isPLC);
+}
+
+template <typename Sample>
+void UserAudioBufferImpl::writeSamples(const Sample* samples, size_t frames,
+                                        int64_t sequence, bool isPLC) {
     auto now = std::chrono::steady_clock::now();
 
     // Track packet timing
@@ -192,8 +486,8 @@ void UserAudioBufferImpl::addSamples(const int16_t* samples, size_t frames,
         auto gapMs = std::chrono::duration_cast<std::chrono::milliseconds>(
             now - lastPacketTime_
         ).count();
-        if (gapMs > stats_.maxGapMs) {
-            stats_.maxGapMs = static_cast<int>(gapMs);
+        if (gapMs > producerStats_.maxGapMs) {
+            producerStats_.maxGapMs = static_cast<int>(gapMs);
         }
     }
     lastPacketTime_ = now;
@@ -201,33 +495,21 @@ void UserAudioBufferImpl::addSamples(const int16_t* samples, size_t frames,
     // Detect sequence gaps
     detectSequenceGap(sequence);
 
-    stats_.packetsReceived++;
+    producerStats_.packetsReceived++;
     if (isPLC) {
-        stats_.plcFrames++;
+        producerStats_.plcFrames++;
     } else {
-        stats_.packetsDecoded++;
+        producerStats_.packetsDecoded++;
     }
-    stats_.lastSequence = sequence;
+    producerStats_.lastSequence = sequence;
     lastSequence_ = sequence;
 
-    // Convert and add to buffer
-    convertToFloat(samples, frames);
-
-    // Handle buffer overflow
-    while (buffer_.size() > maxBufferSize_) {
-        buffer_.pop_front();
-        stats_.bufferOverruns++;
+    // Convert and publish to the consumer
+    if (buffer_.write(samples, frames) > 0) {
+        producerStats_.droppedWrites++;
     }
 
-    stats_.currentBufferSize = buffer_.size();
-}
-
-void UserAudioBufferImpl::convertToFloat(const int16_t* input, size_t frames) {
-    // Convert int16 to float and add to buffer
-    for (size_t i = 0; i < frames; ++i) {
-        float sample = input[i] / 32768.0f;
-        buffer_.push_back(sample);
-    }
+    producerSnapshot_.store(producerStats_);
 }
 
 void UserAudioBufferImpl::detectSequenceGap(int64_t sequence) {
@@ -240,7 +522,7 @@ void UserAudioBufferImpl::detectSequenceGap(int64_t sequence) {
     if (sequence != expectedSequence) {
         int64_t gap = sequence - lastSequence_;
         if (gap > sequenceIncrement_) {
-            stats_.sequenceGaps++;
+            producerStats_.sequenceGaps++;
         }
 
         // Update sequence increment estimate
@@ -250,36 +532,55 @@ void UserAudioBufferImpl::detectSequenceGap(int64_t sequence) {
     }
 }
 
-size_t UserAudioBufferImpl::readFloat(float* output, size_t frames) {
-    std::lock_guard<std::mutex> lock(mutex_);
+bool UserAudioBufferImpl::beginRead() {
+    // Honor a reset requested by the producer side
+    // (only what was written before it; a new talk spurt may already follow)
+    if (flushRequested_.exchange(false, std::memory_order_acq_rel)) {
+        buffer_.discardTo(flushPosition_.load(std::memory_order_acquire));
+        playbackStarted_.store(false, std::memory_order_relaxed);
+        needsFadeIn_ = true;
+        consumerStats_ = ConsumerStats{};
+    }
+
+    size_t available = buffer_.size();
 
     // Check if we should start playback
-    if (!playbackStarted_) {
-        if (buffer_.size() >= minBufferSize_) {
-            playbackStarted_ = true;
+    if (!playbackStarted_.load(std::memory_order_relaxed)) {
+        if (available >= minBufferSize_) {
+            playbackStarted_.store(true, std::memory_order_relaxed);
             needsFadeIn_ = true;
         } else {
-            // Not ready - output silence
-            std::fill(output, output + frames, 0.0f);
-            return 0;
+            // Not ready
+            return false;
         }
     }
 
     // Check for buffer underrun
-    if (buffer_.empty()) {
-        playbackStarted_ = false;
+    if (available == 0) {
+        playbackStarted_.store(false, std::memory_order_relaxed);
         needsFadeIn_ = true;
-        stats_.bufferUnderruns++;
+        consumerStats_.bufferUnderruns++;
+        consumerSnapshot_.store(consumerStats_);
+        return false;
+    }
+
+    // Handle buffer overflow: drop the oldest samples in one step
+    if (available > maxBufferSize_) {
+        buffer_.discard(available - maxBufferSize_);
+        consumerStats_.bufferOverruns++;
+    }
+    return true;
+}
+
+size_t UserAudioBufferImpl::readFloat(float* output, size_t frames) {
+    if (!beginRead()) {
+        // Not playing - output silence
         std::fill(output, output + frames, 0.0f);
         return 0;
     }
 
-    // Read from buffer
-    size_t readFrames = std::min(frames, buffer_.size());
-    for (size_t i = 0; i < readFrames; ++i) {
-        output[i] = buffer_.front();
-        buffer_.pop_front();
-    }
+    // Read from buffer (at most two contiguous spans)
+    size_t readFrames = buffer_.read(output, frames);
 
     // Pad with zeros if needed
     if (readFrames < frames) {
@@ -290,49 +591,78 @@ size_t UserAudioBufferImpl::readFloat(float* output, size_t frames) {
     if (needsFadeIn_) {
         crossfade_->applyFadeIn(output, readFrames);
         needsFadeIn_ = false;
-        stats_.fadeIns++;
+        consumerStats_.fadeIns++;
     }
 
     // Apply fade-out if user stopped talking
-    if (needsFadeOut_ && buffer_.empty()) {
+    if (buffer_.empty() && needsFadeOut_.exchange(false, std::memory_order_acq_rel)) {
         crossfade_->applyFadeOut(output, readFrames);
-        needsFadeOut_ = false;
-        stats_.fadeOuts++;
+        consumerStats_.fadeOuts++;
     }
 
-    stats_.currentBufferSize = buffer_.size();
+    consumerSnapshot_.store(consumerStats_);
     return readFrames;
 }
 
+size_t UserAudioBufferImpl::skip(size_t frames) {
+    if (!beginRead()) {
+        return 0;
+    }
+
+    size_t skipFrames = std::min(frames, buffer_.size());
+    buffer_.discard(skipFrames);
+
+    // Whatever is read next starts mid-stream, so fade it in
+    needsFadeIn_ = true;
+    if (buffer_.empty()) {
+        needsFadeOut_.store(false, std::memory_order_relaxed);
+    }
+
+    consumerSnapshot_.store(consumerStats_);
+    return skipFrames;
+}
+
 bool UserAudioBufferImpl::isReady() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     return buffer_.size() >= minBufferSize_;
 }
 
 bool UserAudioBufferImpl::isActive() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return !buffer_.empty() || playbackStarted_;
+    return !buffer_.empty() || playbackStarted_.load(std::memory_order_relaxed);
 }
 
 UserAudioBuffer::Stats UserAudioBufferImpl::getStats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return stats_;
+    ProducerStats producer = producerSnapshot_.load();
+    ConsumerStats consumer = consumerSnapshot_.load();
+
+    Stats stats;
+    stats.packetsReceived = producer.packetsReceived;
+    stats.packetsDecoded = producer.packetsDecoded;
+    stats.sequenceGaps = producer.sequenceGaps;
+    stats.plcFrames = producer.plcFrames;
+    stats.bufferUnderruns = consumer.bufferUnderruns;
+    stats.bufferOverruns = consumer.bufferOverruns + producer.droppedWrites;
+    stats.fadeIns = consumer.fadeIns;
+    stats.fadeOuts = consumer.fadeOuts;
+    stats.lastSequence = producer.lastSequence;
+    stats.currentBufferSize = buffer_.size();
+    stats.maxGapMs = producer.maxGapMs;
+    return stats;
 }
 
 void UserAudioBufferImpl::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    buffer_.clear();
+    // Producer-side state is reset here; the consumer flushes on its next read
     lastSequence_ = -1;
-    playbackStarted_ = false;
-    needsFadeIn_ = true;
-    needsFadeOut_ = false;
-    stats_ = Stats{};
+    sequenceIncrement_ = 1;
+    producerStats_ = ProducerStats{};
+    producerSnapshot_.store(producerStats_);
+
+    needsFadeOut_.store(false, std::memory_order_relaxed);
+    flushPosition_.store(buffer_.writePosition(), std::memory_order_relaxed);
+    flushRequested_.store(true, std::memory_order_release);
 }
 
 void UserAudioBufferImpl::notifyTalkingEnded() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    needsFadeOut_ = true;
+    needsFadeOut_.store(true, std::memory_order_release);
 }
 
 }  // namespace sayses
@@ -4,6 +4,7 @@
  */
 
 #include "vad.h"
+#include "audio_kernels.h"
 
 #include <cmath>
 #include <algorithm>
@@ -17,6 +18,8 @@ public:
     ~VoiceActivityDetectorImpl() override = default;
 
     bool process(const int16_t* samples, size_t frames) override;
+    bool process(const int16_t* samples, size_t frames,
+                 const AudioFrameFeatures& features) override;
     bool isVoiceDetected() const override;
     float getSignalLevel() const override;
     void setThreshold(float threshold) override;
@@ -24,9 +27,6 @@ public:
     void reset() override;
 
 private:
-    float calculateRMS(const int16_t* samples, size_t frames);
-    float calculatePeak(const int16_t* samples, size_t frames);
-
     Config config_;
 
     // State
@@ -60,11 +60,13 @@ VoiceActivityDetectorImpl::VoiceActivityDetectorImpl(const Config& config)
 }
 
 bool VoiceActivityDetectorImpl::process(const int16_t* samples, size_t frames) {
-    // Calculate RMS energy
-    float rms = calculateRMS(samples, frames);
+    return process(samples, frames, kernels::analyzeFrame(samples, frames));
+}
 
-    // Smooth the level
-    smoothedLevel_ = smoothedLevel_ * (1.0f - kSmoothingFactor) + rms * kSmoothingFactor;
+bool VoiceActivityDetectorImpl::process(const int16_t* samples, size_t frames,
+                                        const AudioFrameFeatures& features) {
+    // Smooth the RMS energy
+    smoothedLevel_ = smoothedLevel_ * (1.0f - kSmoothingFactor) + features.rms * kSmoothingFactor;
     signalLevel_ = smoothedLevel_;
 
     float currentThreshold = threshold_.load();
@@ -123,30 +125,4 @@ void VoiceActivityDetectorImpl::reset() {
     attackCounter_ = 0;
 }
 
-float VoiceActivityDetectorImpl::calculateRMS(const int16_t* samples, size_t frames) {
-    if (frames == 0) return 0.0f;
-
-    double sum = 0.0;
-    for (size_t i = 0; i < frames; i++) {
-        double normalized = samples[i] / 32768.0;
-        sum += normalized * normalized;
-    }
-
-    return static_cast<float>(std::sqrt(sum / frames));
-}
-
-float VoiceActivityDetectorImpl::calculatePeak(const int16_t* samples, size_t frames) {
-    if (frames == 0) return 0.0f;
-
-    int16_t peak = 0;
-    for (size_t i = 0; i < frames; i++) {
-        int16_t absVal = samples[i] >= 0 ? samples[i] : -samples[i];
-        if (absVal > peak) {
-            peak = absVal;
-        }
-    }
-
-    return peak / 32768.0f;
-}
-
 }  // namespace sayses
@@ -0,0 +1,252 @@
+/**
+ * Encoder Controller Implementation
+ * Loss-driven FEC, delay/loss-driven bitrate backoff, frames per packet and
+ * the server bandwidth budget for the Opus encoder
+ */
+
+#include "encoder_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace sayses {
+
+namespace {
+
+// Per-packet header bytes
+constexpr int kIpv4Header = 20;
+constexpr int kUdpHeader = 8;
+constexpr int kOcbTag = 4;               // CryptState's nonce byte + 3 tag bytes
+constexpr int kTcpHeader = 32;           // 20 + timestamp option
+constexpr int kTlsRecordOverhead = 29;   // Record header, explicit nonce, GCM tag
+constexpr int kTunnelPrefix = 6;         // Mumble message type + length
+constexpr int kVoiceHeader = 5;          // Type/target, sequence and length varints
+
+constexpr int kOpusMinBitrate = 6000;    // Lowest useful voice bitrate, unless the budget is lower
+constexpr int kOpusHardMinBitrate = 500; // libopus' floor, for a limit that barely covers headers
+
+// Loss
+constexpr uint32_t kMinPacketsForLoss = 50;  // Fewer sent in an interval says nothing about loss
+constexpr float kLossDecay = 0.3f;           // Fraction of a lower reading taken per interval
+constexpr float kFecOnLoss = 0.02f;          // Turn FEC on at 2% loss ...
+constexpr float kFecOffLoss = 0.005f;        // ... and off again below 0.5%
+constexpr int kMaxLossPercent = 30;          // Opus gains little from expecting more
+constexpr float kHeavyLoss = 0.10f;          // Loss this high is congestion, not noise
+
+// Bitrate
+constexpr float kRttQueueingMs = 150.0f;     // RTT this far above its floor means queues are building
+constexpr float kRttFloorDriftMs = 5.0f;     // Floor creeps up per interval to follow route changes
+constexpr float kBackoffFactor = 0.75f;      // Multiplicative decrease on congestion
+constexpr int kRecoveryStep = 4000;          // Additive increase per clean interval
+
+// Frames per packet
+constexpr int kPacketFrames[] = {1, 2, 4, 6};  // 10/20/40/60ms at 10ms frames, the sizes Mumble clients send
+constexpr int kTunnelMinFrames = 2;          // TCP + TLS headers cost 2.5x UDP's per packet
+constexpr float kLongRttMs = 150.0f;         // Batch twice as much from here ...
+constexpr float kShortRttMs = 120.0f;        // ... until the RTT is back below this
+
+}  // namespace
+
+// ============================================================================
+// Overhead
+// ============================================================================
+
+int EncoderController::overheadBitrate(Transport transport, int framesPerPacket, int frameDurationUs) {
+    const int64_t packetUs = static_cast<int64_t>(std::max(framesPerPacket, 1)) *
+                             std::max(frameDurationUs, 1);
+    const int bytes = transport == Transport::Udp
+        ? kIpv4Header + kUdpHeader + kOcbTag + kVoiceHeader
+        : kIpv4Header + kTcpHeader + kTlsRecordOverhead + kTunnelPrefix + kVoiceHeader;
+
+    // One packet every packetUs
+    return static_cast<int>(bytes * 8 * int64_t{1000000} / packetUs);
+}
+
+// ============================================================================
+// EncoderControllerImpl
+// ============================================================================
+
+class EncoderControllerImpl : public EncoderController {
+public:
+    explicit EncoderControllerImpl(const Config& config);
+
+    void setMaxBandwidth(uint32_t bitsPerSecond) override;
+    void setTransport(Transport transport) override;
+    bool update(const LinkStats& stats, std::chrono::steady_clock::time_point now) override;
+    Codec::EncoderSettings getSettings() const override { return settings_; }
+    float getLossEstimate() const override { return lossEstimate_; }
+    int getFramesPerPacket() const override { return framesPerPacket_; }
+    int getTotalBitrate() const override;
+
+private:
+    void evaluate(const LinkStats& stats);
+    int chooseFramesPerPacket() const;
+    bool applyBudget();
+
+    Config config_;
+    Transport transport_{Transport::Udp};
+    uint32_t maxBandwidth_{0};
+    bool budgetChanged_{false};
+
+    // Measurement state
+    bool started_{false};
+    std::chrono::steady_clock::time_point lastUpdate_;
+    LinkStats lastStats_;
+    float lossEstimate_{0.0f};
+    float rttFloorMs_{0.0f};
+    bool longRtt_{false};
+
+    // Decisions
+    int targetBitrate_;
+    bool fecEnabled_{false};
+    Codec::EncoderSettings settings_;
+    int framesPerPacket_{1};
+};
+
+std::unique_ptr<EncoderController> EncoderController::create(const Config& config) {
+    return std::make_unique<EncoderControllerImpl>(config);
+}
+
+EncoderControllerImpl::EncoderControllerImpl(const Config& config)
+    : config_(config)
+    , targetBitrate_(config.maxBitrate) {
+
+    settings_.bitrate = config_.maxBitrate;
+    settings_.inbandFec = false;
+    settings_.packetLossPercent = 0;
+}
+
+void EncoderControllerImpl::setMaxBandwidth(uint32_t bitsPerSecond) {
+    if (bitsPerSecond != maxBandwidth_) {
+        maxBandwidth_ = bitsPerSecond;
+        budgetChanged_ = true;
+    }
+}
+
+void EncoderControllerImpl::setTransport(Transport transport) {
+    if (transport != transport_) {
+        transport_ = transport;
+        budgetChanged_ = true;
+    }
+}
+
+int EncoderControllerImpl::getTotalBitrate() const {
+    return settings_.bitrate + overheadBitrate(transport_, framesPerPacket_, config_.frameDurationUs);
+}
+
+bool EncoderControllerImpl::update(const LinkStats& stats, std::chrono::steady_clock::time_point now) {
+    if (!started_) {
+        // First sample is the baseline for the deltas
+        started_ = true;
+        lastUpdate_ = now;
+        lastStats_ = stats;
+        return applyBudget();
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate_).count();
+    if (elapsed < config_.updateIntervalMs) {
+        // A new server limit must not wait for the next interval
+        return budgetChanged_ && applyBudget();
+    }
+
+    evaluate(stats);
+    lastUpdate_ = now;
+    lastStats_ = stats;
+    return applyBudget();
+}
+
+void EncoderControllerImpl::evaluate(const LinkStats& stats) {
+    // Counters restart with a new crypt state (reconnect or resync)
+    const bool restarted = stats.good < lastStats_.good || stats.late < lastStats_.late ||
+                           stats.lost < lastStats_.lost;
+    const uint32_t good = restarted ? stats.good : stats.good - lastStats_.good;
+    const uint32_t late = restarted ? stats.late : stats.late - lastStats_.late;
+    const uint32_t lost = restarted ? stats.lost : stats.lost - lastStats_.lost;
+
+    // Late packets mostly miss their playout slot, so they count as lost.
+    // Rise at once, decay slowly; an idle interval carries no information.
+    if (good + lost >= kMinPacketsForLoss) {
+        float loss = static_cast<float>(lost + late) / static_cast<float>(good + lost);
+        loss = std::min(loss, 1.0f);
+        lossEstimate_ = loss > lossEstimate_ ? loss : lossEstimate_ + (loss - lossEstimate_) * kLossDecay;
+    }
+
+    // FEC with hysteresis; the expected loss tells Opus how much to spend on it
+    if (!fecEnabled_ && lossEstimate_ >= kFecOnLoss) {
+        fecEnabled_ = true;
+    } else if (fecEnabled_ && lossEstimate_ < kFecOffLoss) {
+        fecEnabled_ = false;
+    }
+
+    // Queueing delay: RTT against a slowly rising floor
+    bool queueing = false;
+    if (stats.rttMs > 0.0f) {
+        rttFloorMs_ = rttFloorMs_ > 0.0f ? std::min(stats.rttMs, rttFloorMs_ + kRttFloorDriftMs)
+                                         : stats.rttMs;
+        queueing = stats.rttMs > rttFloorMs_ + kRttQueueingMs;
+        longRtt_ = stats.rttMs >= (longRtt_ ? kShortRttMs : kLongRttMs);
+    }
+
+    // Random loss is FEC's job; only congestion lowers the bitrate
+    if (queueing || lossEstimate_ >= kHeavyLoss) {
+        targetBitrate_ = std::max(static_cast<int>(targetBitrate_ * kBackoffFactor), config_.minBitrate);
+    } else if (lossEstimate_ < kFecOnLoss) {
+        targetBitrate_ = std::min(targetBitrate_ + kRecoveryStep, config_.maxBitrate);
+    }
+}
+
+int EncoderControllerImpl::chooseFramesPerPacket() const {
+    // Tunnelled packets always batch; a long round trip hides another 10-30ms
+    int minFrames = transport_ == Transport::TcpTunnel ? kTunnelMinFrames : 1;
+    if (longRtt_) {
+        minFrames *= 2;
+    }
+
+    // Then the fewest frames whose headers leave room for the bitrate
+    const int maxFrames = std::clamp(config_.maxFramesPerPacket, 1, kPacketFrames[std::size(kPacketFrames) - 1]);
+    int frames = 1;
+    for (int candidate : kPacketFrames) {
+        if (candidate > maxFrames) {
+            break;
+        }
+        frames = candidate;
+        if (candidate < minFrames) {
+            continue;
+        }
+        if (maxBandwidth_ == 0 ||
+            static_cast<int64_t>(targetBitrate_) + overheadBitrate(transport_, candidate, config_.frameDurationUs) <=
+                maxBandwidth_) {
+            break;
+        }
+    }
+    return frames;
+}
+
+bool EncoderControllerImpl::applyBudget() {
+    budgetChanged_ = false;
+
+    const int frames = chooseFramesPerPacket();
+    Codec::EncoderSettings next;
+    next.bitrate = std::max(targetBitrate_, kOpusMinBitrate);
+    if (maxBandwidth_ > 0) {
+        // The server limit counts headers too and wins over the quality
+        // floor; only a limit that can't carry headers plus Opus' minimum is missed
+        const int budget = static_cast<int>(std::min<uint32_t>(maxBandwidth_, INT32_MAX)) -
+                           overheadBitrate(transport_, frames, config_.frameDurationUs);
+        next.bitrate = std::max(std::min(next.bitrate, budget), kOpusHardMinBitrate);
+    }
+    next.inbandFec = fecEnabled_;
+    next.packetLossPercent = fecEnabled_
+        ? std::clamp(static_cast<int>(std::ceil(lossEstimate_ * 100.0f)), 1, kMaxLossPercent)
+        : 0;
+
+    const bool changed = next.bitrate != settings_.bitrate || next.inbandFec != settings_.inbandFec ||
+                         next.packetLossPercent != settings_.packetLossPercent ||
+                         frames != framesPerPacket_;
+    settings_ = next;
+    framesPerPacket_ = frames;
+    return changed;
+}
+
+}  // namespace sayses
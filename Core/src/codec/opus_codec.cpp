@@ -6,7 +6,10 @@
 #include "codec.h"
 
 #include <opus.h>
+#include <atomic>
 #include <cstring>
+#include <mutex>
+#include <stdexcept>
 
 namespace sayses {
 
@@ -23,6 +26,16 @@ public:
 
     int decodePLC(int16_t* output, size_t maxOutputFrames) override;
 
+    int encode(const float* input, size_t inputFrames,
+               uint8_t* output, size_t maxOutputBytes) override;
+
+    int decode(const uint8_t* input, size_t inputBytes,
+               float* output, size_t maxOutputFrames) override;
+
+    int decodePLC(float* output, size_t maxOutputFrames) override;
+
+    bool setEncoderSettings(const EncoderSettings& settings) override;
+
     void reset() override;
 
     Type getType() const override { return Type::Opus; }
@@ -30,9 +43,17 @@ public:
     int getSampleRate() const override { return config_.sampleRate; }
 
 private:
+    void applyEncoderSettings(const EncoderSettings& settings);
+    void applyPendingSettings();
+
     Config config_;
     OpusEncoder* encoder_{nullptr};
     OpusDecoder* decoder_{nullptr};
+
+    // Settings handed over from the network side, applied on the encoding thread
+    std::mutex settingsMutex_;
+    EncoderSettings pendingSettings_;
+    std::atomic<bool> settingsPending_{false};
 };
 
 // Factory method
@@ -45,11 +66,12 @@ OpusCodec::OpusCodec(const Config& config)
 
     int error;
 
-    // Create encoder
+    // Create encoder. The low-delay application is CELT only and saves the
+    // 4ms of lookahead SILK needs; 2.5 and 5ms frames are CELT anyway.
     encoder_ = opus_encoder_create(
         config_.sampleRate,
         config_.channels,
-        OPUS_APPLICATION_VOIP,
+        config_.lowDelay ? OPUS_APPLICATION_RESTRICTED_LOWDELAY : OPUS_APPLICATION_VOIP,
         &error
     );
 
@@ -59,14 +81,17 @@ OpusCodec::OpusCodec(const Config& config)
 
     // Configure encoder (matching Android SAYses / Mumla settings)
     // Use 64kbps for good voice quality (as documented)
-    int bitrate = config_.bitrate > 0 ? config_.bitrate : 64000;
-    opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(bitrate));
     opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(config_.complexity));
     opus_encoder_ctl(encoder_, OPUS_SET_VBR(config_.vbr ? 1 : 0));
     opus_encoder_ctl(encoder_, OPUS_SET_DTX(config_.dtx ? 1 : 0));
     opus_encoder_ctl(encoder_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
-    opus_encoder_ctl(encoder_, OPUS_SET_INBAND_FEC(1));  // Enable forward error correction
-    opus_encoder_ctl(encoder_, OPUS_SET_PACKET_LOSS_PERC(10));  // Expect ~10% packet loss
+
+    // Bitrate and loss protection; an EncoderController may retune them live
+    EncoderSettings settings;
+    settings.bitrate = config_.bitrate > 0 ? config_.bitrate : 64000;
+    settings.inbandFec = config_.inbandFec;
+    settings.packetLossPercent = config_.packetLossPercent;
+    applyEncoderSettings(settings);
 
     // Create decoder
     decoder_ = opus_decoder_create(
@@ -98,6 +123,7 @@ int OpusCodec::encode(const int16_t* input, size_t inputFrames,
     if (!encoder_) {
         return -1;
     }
+    applyPendingSettings();
 
     int result = opus_encode(
         encoder_,
@@ -146,6 +172,91 @@ int OpusCodec::decodePLC(int16_t* output, size_t maxOutputFrames) {
     return result;
 }
 
+int OpusCodec::encode(const float* input, size_t inputFrames,
+                      uint8_t* output, size_t maxOutputBytes) {
+    if (!encoder_) {
+        return -1;
+    }
+    applyPendingSettings();
+
+    int result = opus_encode_float(
+        encoder_,
+        input,
+        static_cast<int>(inputFrames),
+        output,
+        static_cast<opus_int32>(maxOutputBytes)
+    );
+
+    return result;
+}
+
+int OpusCodec::decode(const uint8_t* input, size_t inputBytes,
+                      float* output, size_t maxOutputFrames) {
+    if (!decoder_) {
+        return -1;
+    }
+
+    // The decoder works in float internally; this skips its int16 output stage
+    int result = opus_decode_float(
+        decoder_,
+        input,
+        static_cast<opus_int32>(inputBytes),
+        output,
+        static_cast<int>(maxOutputFrames),
+        0  // decode_fec = 0 (not using FEC for this packet)
+    );
+
+    return result;
+}
+
+int OpusCodec::decodePLC(float* output, size_t maxOutputFrames) {
+    if (!decoder_) {
+        return -1;
+    }
+
+    int result = opus_decode_float(
+        decoder_,
+        nullptr,
+        0,
+        output,
+        static_cast<int>(maxOutputFrames),
+        0
+    );
+
+    return result;
+}
+
+bool OpusCodec::setEncoderSettings(const EncoderSettings& settings) {
+    if (!encoder_) {
+        return false;
+    }
+
+    // encode() may be running on another thread, so the encoder ctls are
+    // deferred to it instead of racing the encoder state from here
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    pendingSettings_ = settings;
+    settingsPending_.store(true, std::memory_order_release);
+    return true;
+}
+
+void OpusCodec::applyPendingSettings() {
+    if (!settingsPending_.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+    EncoderSettings settings;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        settings = pendingSettings_;
+    }
+    applyEncoderSettings(settings);
+}
+
+void OpusCodec::applyEncoderSettings(const EncoderSettings& settings) {
+    opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(settings.bitrate));
+    opus_encoder_ctl(encoder_, OPUS_SET_INBAND_FEC(settings.inbandFec ? 1 : 0));
+    opus_encoder_ctl(encoder_, OPUS_SET_PACKET_LOSS_PERC(settings.packetLossPercent));
+}
+
 void OpusCodec::reset() {
     if (encoder_) {
         opus_encoder_ctl(encoder_, OPUS_RESET_STATE);
@@ -0,0 +1,121 @@
+/**
+ * Opus Packetizer Implementation
+ * opus_repacketizer over preallocated frame slots
+ */
+
+#include "opus_packetizer.h"
+
+#include <opus.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace sayses {
+
+class OpusPacketizerImpl : public OpusPacketizer {
+public:
+    OpusPacketizerImpl();
+    ~OpusPacketizerImpl() override;
+
+    void setFramesPerPacket(int frames) override;
+    int getFramesPerPacket() const override { return framesPerPacket_; }
+
+    int addFrame(const uint8_t* frame, size_t frameBytes,
+                 uint8_t* output, size_t maxOutputBytes, int& packetFrames) override;
+    int flush(uint8_t* output, size_t maxOutputBytes, int& packetFrames) override;
+    void reset() override;
+
+private:
+    uint8_t* slot(int index) { return slots_.data() + static_cast<size_t>(index) * kMaxFrameBytes; }
+    bool append(int index, size_t frameBytes);
+    int emit(uint8_t* output, size_t maxOutputBytes, int& packetFrames);
+
+    OpusRepacketizer* repacketizer_{nullptr};
+    std::vector<uint8_t> slots_;  // The repacketizer references frames until it emits them
+    int framesPerPacket_{1};
+    int collected_{0};
+};
+
+std::unique_ptr<OpusPacketizer> OpusPacketizer::create() {
+    return std::make_unique<OpusPacketizerImpl>();
+}
+
+OpusPacketizerImpl::OpusPacketizerImpl()
+    : slots_(kMaxFramesPerPacket * kMaxFrameBytes) {
+    repacketizer_ = opus_repacketizer_create();
+    if (!repacketizer_) {
+        throw std::runtime_error("Failed to create Opus repacketizer");
+    }
+}
+
+OpusPacketizerImpl::~OpusPacketizerImpl() {
+    if (repacketizer_) {
+        opus_repacketizer_destroy(repacketizer_);
+    }
+}
+
+void OpusPacketizerImpl::setFramesPerPacket(int frames) {
+    framesPerPacket_ = std::clamp(frames, 1, kMaxFramesPerPacket);
+}
+
+int OpusPacketizerImpl::addFrame(const uint8_t* frame, size_t frameBytes,
+                                 uint8_t* output, size_t maxOutputBytes, int& packetFrames) {
+    packetFrames = 0;
+    if (!frame || frameBytes == 0 || frameBytes > kMaxFrameBytes) {
+        return OPUS_BAD_ARG;
+    }
+
+    int written = 0;
+    std::memcpy(slot(collected_), frame, frameBytes);
+    if (!append(collected_, frameBytes)) {
+        if (collected_ == 0) {
+            return OPUS_INVALID_PACKET;
+        }
+
+        // Different TOC: ship what we have, the new frame starts over
+        written = emit(output, maxOutputBytes, packetFrames);
+        if (written < 0) {
+            return written;
+        }
+        std::memmove(slot(0), frame, frameBytes);
+        if (!append(0, frameBytes)) {
+            return OPUS_INVALID_PACKET;
+        }
+    }
+
+    if (written == 0 && collected_ >= framesPerPacket_) {
+        written = emit(output, maxOutputBytes, packetFrames);
+    }
+    return written;
+}
+
+int OpusPacketizerImpl::flush(uint8_t* output, size_t maxOutputBytes, int& packetFrames) {
+    packetFrames = 0;
+    return collected_ > 0 ? emit(output, maxOutputBytes, packetFrames) : 0;
+}
+
+void OpusPacketizerImpl::reset() {
+    opus_repacketizer_init(repacketizer_);
+    collected_ = 0;
+}
+
+bool OpusPacketizerImpl::append(int index, size_t frameBytes) {
+    if (opus_repacketizer_cat(repacketizer_, slot(index), static_cast<opus_int32>(frameBytes)) != OPUS_OK) {
+        return false;
+    }
+    collected_ = index + 1;
+    return true;
+}
+
+int OpusPacketizerImpl::emit(uint8_t* output, size_t maxOutputBytes, int& packetFrames) {
+    const opus_int32 maxBytes = static_cast<opus_int32>(std::min<size_t>(maxOutputBytes, INT32_MAX));
+    int result = opus_repacketizer_out(repacketizer_, output, maxBytes);
+
+    // Frames are dropped on failure too; a stuck packet would block every later one
+    packetFrames = result > 0 ? collected_ : 0;
+    reset();
+    return result;
+}
+
+}  // namespace sayses
@@ -5,6 +5,7 @@
 
 #include "codec.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace sayses {
@@ -22,6 +23,16 @@ public:
 
     int decodePLC(int16_t* output, size_t maxOutputFrames) override;
 
+    int encode(const float* input, size_t inputFrames,
+               uint8_t* output, size_t maxOutputBytes) override;
+
+    int decode(const uint8_t* input, size_t inputBytes,
+               float* output, size_t maxOutputFrames) override;
+
+    int decodePLC(float* output, size_t maxOutputFrames) override;
+
+    bool setEncoderSettings(const EncoderSettings& settings) override;
+
     void reset() override;
 
     Type getType() const override { return Type::Speex; }
@@ -61,6 +72,25 @@ int SpeexCodec::decodePLC(int16_t* output, size_t maxOutputFrames) {
     return static_cast<int>(maxOutputFrames);
 }
 
+int SpeexCodec::encode(const float* input, size_t inputFrames,
+                       uint8_t* output, size_t maxOutputBytes) {
+    return -1;
+}
+
+int SpeexCodec::decode(const uint8_t* input, size_t inputBytes,
+                       float* output, size_t maxOutputFrames) {
+    return -1;
+}
+
+int SpeexCodec::decodePLC(float* output, size_t maxOutputFrames) {
+    std::fill(output, output + maxOutputFrames, 0.0f);
+    return static_cast<int>(maxOutputFrames);
+}
+
+bool SpeexCodec::setEncoderSettings(const EncoderSettings& settings) {
+    return false;
+}
+
 void SpeexCodec::reset() {
     // Nothing to reset
 }
@@ -4,98 +4,14 @@
  * Based on Mumble's CryptState implementation
  */
 
-#include <openssl/aes.h>
+#include "crypto.h"
+
 #include <openssl/rand.h>
 
 #include <cstring>
-#include <cstdint>
-#include <mutex>
 
 namespace sayses {
 
-/**
- * OCB-AES128 encryption state for Mumble UDP packets.
- * Implements the OCB (Offset Codebook) mode of operation.
- */
-class CryptState {
-public:
-    CryptState();
-    ~CryptState() = default;
-
-    /**
-     * Initialize with key and nonces from server.
-     */
-    bool init(const uint8_t key[16],
-              const uint8_t clientNonce[16],
-              const uint8_t serverNonce[16]);
-
-    /**
-     * Encrypt a packet.
-     * @param src Source data
-     * @param dst Destination buffer (must be src_len + 4 bytes)
-     * @param srcLen Source length
-     * @return true on success
-     */
-    bool encrypt(const uint8_t* src, uint8_t* dst, size_t srcLen);
-
-    /**
-     * Decrypt a packet.
-     * @param src Source data
-     * @param dst Destination buffer
-     * @param srcLen Source length (includes 4-byte tag)
-     * @return true on success
-     */
-    bool decrypt(const uint8_t* src, uint8_t* dst, size_t srcLen);
-
-    /**
-     * Check if crypto is initialized.
-     */
-    bool isValid() const { return initialized_; }
-
-    /**
-     * Request nonce resync.
-     */
-    void requestResync() { needResync_ = true; }
-
-    /**
-     * Check if resync is needed.
-     */
-    bool needsResync() const { return needResync_; }
-
-private:
-    void ocbEncrypt(const uint8_t* plain, uint8_t* encrypted,
-                    size_t len, const uint8_t* nonce, uint8_t* tag);
-    bool ocbDecrypt(const uint8_t* encrypted, uint8_t* plain,
-                    size_t len, const uint8_t* nonce, const uint8_t* tag);
-
-    void aesEncrypt(uint8_t* dst, const uint8_t* src);
-    void xorBlock(uint8_t* dst, const uint8_t* a, const uint8_t* b);
-    void shift(uint8_t* dst, const uint8_t* src);
-    void generateSubkeys();
-
-    // Key material
-    uint8_t key_[16];
-    uint8_t clientNonce_[16];
-    uint8_t serverNonce_[16];
-
-    // AES
-    AES_KEY aesKey_;
-    uint8_t L_[16];    // L = E_K(0^n)
-    uint8_t delta_[16];
-
-    // State
-    bool initialized_{false};
-    bool needResync_{false};
-    std::mutex mutex_;
-
-    // Nonce tracking
-    uint32_t encryptNonce_{0};
-    uint32_t decryptNonce_{0};
-    uint32_t lastGood_{0};
-    uint32_t late_{0};
-    uint32_t lost_{0};
-};
-
 CryptState::CryptState() {
     std::memset(key_, 0, sizeof(key_));
     std::memset(clientNonce_, 0, sizeof(clientNonce_));
@@ -112,15 +28,18 @@ bool CryptState::init(const uint8_t key[16],
     std::memcpy(serverNonce_, serverNonce, 16);
 
     // Initialize AES key
-    if (AES_set_encrypt_key(key_, 128, &aesKey_) != 0) {
+    if (AES_set_encrypt_key(key_, 128, &aesKey_) != 0 ||
+        AES_set_decrypt_key(key_, 128, &aesDecryptKey_) != 0) {
         return false;
     }
 
     generateSubkeys();
 
     encryptNonce_ = 0;
-    decryptNonce_ = 0;
+    decryptNonce_ = 1;
+    std::memset(decryptHistory_, 0, sizeof(decryptHistory_));
     lastGood_ = 0;
+    good_ = 0;
     late_ = 0;
     lost_ = 0;
     needResync_ = false;
@@ -204,10 +123,17 @@ bool CryptState::decrypt(const uint8_t* src, uint8_t* dst, size_t srcLen) {
 
     uint8_t nonceByte = src[0];
 
-    // Reconstruct full nonce
+    // Reconstruct full nonce (diff is 0 for the expected packet)
     int32_t diff = static_cast<int8_t>(nonceByte - static_cast<uint8_t>(decryptNonce_));
     uint32_t predictedNonce = decryptNonce_ + diff;
 
+    // Replay: this nonce was already accepted. It is neither late nor a resync
+    // reason; the window covers every nonce diff can reach behind the counter.
+    uint32_t& seen = decryptHistory_[predictedNonce & 0xFF];
+    if (seen == predictedNonce) {
+        return false;
+    }
+
     nonce[0] = static_cast<uint8_t>(predictedNonce);
     nonce[1] = static_cast<uint8_t>(predictedNonce >> 8);
     nonce[2] = static_cast<uint8_t>(predictedNonce >> 16);
@@ -217,7 +143,7 @@ bool CryptState::decrypt(const uint8_t* src, uint8_t* dst, size_t srcLen) {
     uint8_t expectedTag[16];
     size_t plainLen = srcLen - 4;
 
-    ocbEncrypt(dst, const_cast<uint8_t*>(src + 4), plainLen, nonce, expectedTag);
+    ocbDecrypt(src + 4, dst, plainLen, nonce, expectedTag);
 
     // Verify tag (first 3 bytes)
     if (expectedTag[0] != src[1] ||
@@ -227,12 +153,33 @@ bool CryptState::decrypt(const uint8_t* src, uint8_t* dst, size_t srcLen) {
         return false;
     }
 
-    // Update nonce counter
-    decryptNonce_ = predictedNonce + 1;
+    // Loss accounting: a jump forward skipped packets, an older nonce (not a
+    // replay, see above) is one of them arriving late. The nonce counter
+    // itself never moves backwards.
+    seen = predictedNonce;
+    good_++;
+    if (diff >= 0) {
+        lost_ += static_cast<uint32_t>(diff);
+        decryptNonce_ = predictedNonce + 1;
+    } else {
+        late_++;
+        if (lost_ > 0) {
+            lost_--;
+        }
+    }
 
     return true;
 }
 
+CryptState::Stats CryptState::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.good = good_;
+    stats.late = late_;
+    stats.lost = lost_;
+    return stats;
+}
+
 void CryptState::ocbEncrypt(const uint8_t* plain, uint8_t* encrypted,
                             size_t len, const uint8_t* nonce, uint8_t* tag) {
     // OCB-AES128 encryption
@@ -283,14 +230,47 @@ void CryptState::ocbEncrypt(const uint8_t* plain, uint8_t* encrypted,
     aesEncrypt(tag, checksum);
 }
 
-bool CryptState::ocbDecrypt(const uint8_t* encrypted, uint8_t* plain,
-                            size_t len, const uint8_t* nonce, const uint8_t* tag) {
-    // OCB decryption is similar to encryption due to the mode's properties
-    uint8_t computedTag[16];
-    ocbEncrypt(encrypted, plain, len, nonce, computedTag);
+void CryptState::ocbDecrypt(const uint8_t* encrypted, uint8_t* plain,
+                            size_t len, const uint8_t* nonce, uint8_t* tag) {
+    // Inverse of ocbEncrypt(); the tag is computed over the recovered plaintext
+
+    uint8_t offset[16];
+    uint8_t checksum[16];
+    std::memset(checksum, 0, 16);
+
+    aesEncrypt(offset, nonce);
+
+    size_t fullBlocks = len / 16;
+    for (size_t i = 0; i < fullBlocks; i++) {
+        xorBlock(offset, offset, L_);
+
+        // P = offset XOR D_K(C XOR offset)
+        uint8_t tmp[16];
+        xorBlock(tmp, encrypted + i * 16, offset);
+        uint8_t dec[16];
+        AES_decrypt(tmp, dec, &aesDecryptKey_);
+        xorBlock(plain + i * 16, dec, offset);
+
+        xorBlock(checksum, checksum, plain + i * 16);
+    }
+
+    // The partial block is a keystream XOR, same as on the way in
+    size_t remaining = len % 16;
+    if (remaining > 0) {
+        shift(offset, offset);
 
-    // Verify tag
-    return std::memcmp(computedTag, tag, 16) == 0;
+        uint8_t pad[16];
+        aesEncrypt(pad, offset);
+
+        for (size_t i = 0; i < remaining; i++) {
+            plain[fullBlocks * 16 + i] = encrypted[fullBlocks * 16 + i] ^ pad[i];
+            checksum[i] ^= plain[fullBlocks * 16 + i];
+        }
+        checksum[remaining] ^= 0x80;
+    }
+
+    xorBlock(checksum, checksum, offset);
+    aesEncrypt(tag, checksum);
 }
 
 }  // namespace sayses
@@ -0,0 +1,118 @@
+/**
+ * Mumble Crypto
+ * OCB-AES128 encryption for UDP audio packets
+ * Based on Mumble's CryptState implementation
+ */
+
+#pragma once
+
+#include <openssl/aes.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace sayses {
+
+/**
+ * OCB-AES128 encryption state for Mumble UDP packets.
+ * Implements the OCB (Offset Codebook) mode of operation.
+ */
+class CryptState {
+public:
+    /**
+     * Receive counters, as reported in Mumble's Ping message.
+     */
+    struct Stats {
+        uint32_t good = 0;   // Packets decrypted
+        uint32_t late = 0;   // Arrived after a newer packet (counted lost before)
+        uint32_t lost = 0;   // Skipped in the nonce sequence and not seen since
+    };
+
+    CryptState();
+    ~CryptState() = default;
+
+    /**
+     * Initialize with key and nonces from server.
+     */
+    bool init(const uint8_t key[16],
+              const uint8_t clientNonce[16],
+              const uint8_t serverNonce[16]);
+
+    /**
+     * Encrypt a packet.
+     * @param src Source data
+     * @param dst Destination buffer (must be src_len + 4 bytes)
+     * @param srcLen Source length
+     * @return true on success
+     */
+    bool encrypt(const uint8_t* src, uint8_t* dst, size_t srcLen);
+
+    /**
+     * Decrypt a packet.
+     * Replays of a nonce seen in the last 256 packets are rejected.
+     * @param src Source data
+     * @param dst Destination buffer
+     * @param srcLen Source length (includes 4-byte tag)
+     * @return true on success
+     */
+    bool decrypt(const uint8_t* src, uint8_t* dst, size_t srcLen);
+
+    /**
+     * Check if crypto is initialized.
+     */
+    bool isValid() const { return initialized_; }
+
+    /**
+     * Request nonce resync.
+     */
+    void requestResync() { needResync_ = true; }
+
+    /**
+     * Check if resync is needed.
+     */
+    bool needsResync() const { return needResync_; }
+
+    /**
+     * Get the receive counters since init().
+     */
+    Stats getStats() const;
+
+private:
+    void ocbEncrypt(const uint8_t* plain, uint8_t* encrypted,
+                    size_t len, const uint8_t* nonce, uint8_t* tag);
+    void ocbDecrypt(const uint8_t* encrypted, uint8_t* plain,
+                    size_t len, const uint8_t* nonce, uint8_t* tag);
+
+    void aesEncrypt(uint8_t* dst, const uint8_t* src);
+    void xorBlock(uint8_t* dst, const uint8_t* a, const uint8_t* b);
+    void shift(uint8_t* dst, const uint8_t* src);
+    void generateSubkeys();
+
+    // Key material
+    uint8_t key_[16];
+    uint8_t clientNonce_[16];
+    uint8_t serverNonce_[16];
+
+    // AES
+    AES_KEY aesKey_;
+    AES_KEY aesDecryptKey_;
+    uint8_t L_[16];    // L = E_K(0^n)
+    uint8_t delta_[16];
+
+    // State
+    bool initialized_{false};
+    bool needResync_{false};
+    mutable std::mutex mutex_;
+
+    // Nonce tracking
+    uint32_t encryptNonce_{0};
+    uint32_t decryptNonce_{1};         // Next expected nonce (the first packet is 1)
+    uint32_t decryptHistory_[256]{};   // Nonce last accepted per low byte (replay window)
+    uint32_t lastGood_{0};
+    uint32_t good_{0};
+    uint32_t late_{0};
+    uint32_t lost_{0};
+};
+
+}  // namespace sayses
@@ -4,6 +4,7 @@
  */
 
 #include "mumble_client.h"
+#include "mumble_protocol.h"
 #include "Mumble.pb.h"
 
 #include <openssl/ssl.h>
@@ -27,39 +28,6 @@
 
 namespace sayses {
 
-// Mumble protocol message types (must match server ordering)
-enum class MessageType : uint16_t {
-    Version = 0,
-    UDPTunnel = 1,
-    Authenticate = 2,
-    Ping = 3,
-    Reject = 4,
-    ServerSync = 5,
-    ChannelRemove = 6,
-    ChannelState = 7,
-    UserRemove = 8,
-    UserState = 9,
-    BanList = 10,
-    TextMessage = 11,
-    PermissionDenied = 12,
-    ACL = 13,
-    QueryUsers = 14,
-    CryptSetup = 15,
-    ContextActionModify = 16,
-    ContextAction = 17,
-    UserList = 18,
-    VoiceTarget = 19,
-    PermissionQuery = 20,
-    CodecVersion = 21,
-    UserStats = 22,
-    RequestBlob = 23,
-    ServerConfig = 24,
-    SuggestConfig = 25
-};
-
-// Mumble version encoding: Major << 16 | Minor << 8 | Patch
-constexpr uint32_t MUMBLE_VERSION = (1 << 16) | (3 << 8) | 0;
-
 class MumbleClientImpl : public MumbleClient {
 public:
     MumbleClientImpl();
@@ -530,15 +498,8 @@ bool MumbleClientImpl::sendRawMessage(MessageType type, const uint8_t* data, siz
 
     if (!ssl_) return false;
 
-    // Build header: 2-byte type + 4-byte length
-    uint8_t header[6];
-    uint16_t typeVal = static_cast<uint16_t>(type);
-    header[0] = (typeVal >> 8) & 0xFF;
-    header[1] = typeVal & 0xFF;
-    header[2] = (length >> 24) & 0xFF;
-    header[3] = (length >> 16) & 0xFF;
-    header[4] = (length >> 8) & 0xFF;
-    header[5] = length & 0xFF;
+    uint8_t header[kMessageHeaderSize];
+    writeMessageHeader(header, type, static_cast<uint32_t>(length));
 
     // Send header
     if (SSL_write(ssl_, header, 6) != 6) {
@@ -0,0 +1,180 @@
+/**
+ * Mumble Protocol
+ * Wire constants and encoding helpers shared by client and test server
+ * Based on Mumble 1.3.x protocol specification
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sayses {
+
+// Mumble protocol message types (must match server ordering)
+enum class MessageType : uint16_t {
+    Version = 0,
+    UDPTunnel = 1,
+    Authenticate = 2,
+    Ping = 3,
+    Reject = 4,
+    ServerSync = 5,
+    ChannelRemove = 6,
+    ChannelState = 7,
+    UserRemove = 8,
+    UserState = 9,
+    BanList = 10,
+    TextMessage = 11,
+    PermissionDenied = 12,
+    ACL = 13,
+    QueryUsers = 14,
+    CryptSetup = 15,
+    ContextActionModify = 16,
+    ContextAction = 17,
+    UserList = 18,
+    VoiceTarget = 19,
+    PermissionQuery = 20,
+    CodecVersion = 21,
+    UserStats = 22,
+    RequestBlob = 23,
+    ServerConfig = 24,
+    SuggestConfig = 25
+};
+
+// Mumble version encoding: Major << 16 | Minor << 8 | Patch
+constexpr uint32_t MUMBLE_VERSION = (1 << 16) | (3 << 8) | 0;
+
+// TCP framing: 2-byte type + 4-byte length, big endian
+constexpr size_t kMessageHeaderSize = 6;
+
+inline void writeMessageHeader(uint8_t* header, MessageType type, uint32_t length) {
+    uint16_t typeVal = static_cast<uint16_t>(type);
+    header[0] = (typeVal >> 8) & 0xFF;
+    header[1] = typeVal & 0xFF;
+    header[2] = (length >> 24) & 0xFF;
+    header[3] = (length >> 16) & 0xFF;
+    header[4] = (length >> 8) & 0xFF;
+    header[5] = length & 0xFF;
+}
+
+inline void readMessageHeader(const uint8_t* header, uint16_t& type, uint32_t& length) {
+    type = static_cast<uint16_t>((header[0] << 8) | header[1]);
+    length = (static_cast<uint32_t>(header[2]) << 24) | (header[3] << 16) | (header[4] << 8) | header[5];
+}
+
+// =============================================================================
+// Voice packets (UDP, or tunnelled through UDPTunnel)
+// =============================================================================
+
+// Byte 0 of a voice packet: type << 5 | target
+enum class UdpMessageType : uint8_t {
+    CELTAlpha = 0,
+    Ping = 1,
+    Speex = 2,
+    CELTBeta = 3,
+    Opus = 4
+};
+
+constexpr uint8_t kVoiceTargetNormal = 0;
+constexpr uint8_t kVoiceTargetLoopback = 31;   // Server sends the packet back to the sender
+
+// Opus length prefix: bit 13 marks the last packet of a transmission
+constexpr uint64_t kOpusTerminator = 0x2000;
+constexpr uint64_t kOpusLengthMask = 0x1FFF;
+
+inline uint8_t voiceHeader(UdpMessageType type, uint8_t target) {
+    return static_cast<uint8_t>((static_cast<uint8_t>(type) << 5) | (target & 0x1F));
+}
+
+inline UdpMessageType voiceType(uint8_t header) {
+    return static_cast<UdpMessageType>(header >> 5);
+}
+
+inline uint8_t voiceTarget(uint8_t header) {
+    return header & 0x1F;
+}
+
+/**
+ * Encode a non-negative varint in Mumble's PacketDataStream format.
+ * @param out Destination, at least 9 bytes
+ * @return Bytes written
+ */
+inline size_t writeVarint(uint8_t* out, uint64_t value) {
+    if (value < 0x80) {
+        out[0] = static_cast<uint8_t>(value);
+        return 1;
+    }
+    if (value < 0x4000) {
+        out[0] = static_cast<uint8_t>((value >> 8) | 0x80);
+        out[1] = static_cast<uint8_t>(value);
+        return 2;
+    }
+    if (value < 0x200000) {
+        out[0] = static_cast<uint8_t>((value >> 16) | 0xC0);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value);
+        return 3;
+    }
+    if (value < 0x10000000) {
+        out[0] = static_cast<uint8_t>((value >> 24) | 0xE0);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+        return 4;
+    }
+    if (value <= 0xFFFFFFFFULL) {
+        out[0] = 0xF0;
+        for (int i = 0; i < 4; i++) {
+            out[1 + i] = static_cast<uint8_t>(value >> (24 - 8 * i));
+        }
+        return 5;
+    }
+    out[0] = 0xF4;
+    for (int i = 0; i < 8; i++) {
+        out[1 + i] = static_cast<uint8_t>(value >> (56 - 8 * i));
+    }
+    return 9;
+}
+
+/**
+ * Decode a varint written by writeVarint(). Negative encodings are
+ * rejected, they never occur in the fields we read.
+ * @return Bytes consumed, 0 if the input is truncated or malformed
+ */
+inline size_t readVarint(const uint8_t* in, size_t length, uint64_t& value) {
+    if (length < 1) {
+        return 0;
+    }
+    uint8_t b = in[0];
+    size_t size;
+    if ((b & 0x80) == 0x00) {
+        value = b & 0x7F;
+        return 1;
+    } else if ((b & 0xC0) == 0x80) {
+        value = b & 0x3F;
+        size = 2;
+    } else if ((b & 0xE0) == 0xC0) {
+        value = b & 0x1F;
+        size = 3;
+    } else if ((b & 0xF0) == 0xE0) {
+        value = b & 0x0F;
+        size = 4;
+    } else if ((b & 0xFC) == 0xF0) {
+        value = 0;
+        size = 5;
+    } else if ((b & 0xFC) == 0xF4) {
+        value = 0;
+        size = 9;
+    } else {
+        return 0;
+    }
+    if (length < size) {
+        return 0;
+    }
+    for (size_t i = 1; i < size; i++) {
+        value = (value << 8) | in[i];
+    }
+    return size;
+}
+
+}  // namespace sayses
@@ -0,0 +1,1199 @@
+/**
+ * Mumble Load Generator
+ * Hundreds of lightweight client sessions on one poll() loop, for load
+ * testing Murmur servers (or MockMumbleServer, see --mock).
+ *
+ * Each session authenticates, then, depending on its role, talks by
+ * replaying pre-encoded Opus packets, moves between channels and toggles
+ * self mute. The tool records per-session control-channel RTT, UDP ping
+ * RTT and voice delivery latency (send on one session to arrival on every
+ * listener in the channel; all sessions share one clock).
+ *
+ * MumbleClientImpl blocks on its socket with two threads per connection,
+ * so sessions here are built from the same protocol pieces (wire format,
+ * CryptState, Mumble.pb) on a shared non-blocking loop instead.
+ *
+ * Usage: SaysesLoadGen [--key=value ...], see printUsage().
+ */
+
+#include "mock_mumble_server.h"
+#include "bench_signal.h"
+#include "codec.h"
+#include "crypto.h"
+#include "mumble_protocol.h"
+#include "Mumble.pb.h"
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sayses {
+namespace {
+
+constexpr size_t kMaxDatagram = 2048;
+constexpr uint32_t kMaxMessageLength = 8 * 1024 * 1024;
+constexpr size_t kSendHistory = 1024;            // Per-talker send times kept for latency lookup
+constexpr int64_t kSequenceUs = 10000;           // Mumble sequence numbers count 10ms frames
+constexpr int64_t kPingIntervalUs = 1000000;     // Faster than the app's 15s, for RTT samples
+constexpr int kSynthFrames = 200;                // 2s of speech when no Opus file is given
+
+std::atomic<bool> gStop{false};
+
+void onSignal(int) {
+    gStop = true;
+}
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// splitmix64, so a seed reproduces the same schedule
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+
+    double uniform() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Exponentially distributed interval with the given mean
+    int64_t interval(int64_t meanUs) {
+        return static_cast<int64_t>(-std::log(1.0 - uniform()) * static_cast<double>(meanUs));
+    }
+
+private:
+    uint64_t state_;
+};
+
+// =============================================================================
+// Voice source
+// =============================================================================
+
+struct OpusPacket {
+    std::vector<uint8_t> data;
+    int64_t durationUs;
+};
+
+// Duration of an Opus packet from its TOC byte (RFC 6716, 3.1)
+int64_t opusPacketDurationUs(const std::vector<uint8_t>& packet) {
+    if (packet.empty()) {
+        return 0;
+    }
+    static const int64_t kSilkUs[4] = {10000, 20000, 40000, 60000};
+    static const int64_t kCeltUs[4] = {2500, 5000, 10000, 20000};
+
+    uint8_t toc = packet[0];
+    int config = toc >> 3;
+    int64_t frameUs;
+    if (config < 12) {
+        frameUs = kSilkUs[config & 3];
+    } else if (config < 16) {
+        frameUs = (config & 1) ? 20000 : 10000;
+    } else {
+        frameUs = kCeltUs[config & 3];
+    }
+
+    int frames;
+    switch (toc & 3) {
+        case 0:
+            frames = 1;
+            break;
+        case 1:
+        case 2:
+            frames = 2;
+            break;
+        default:
+            frames = packet.size() > 1 ? (packet[1] & 0x3F) : 0;
+            break;
+    }
+    return frameUs * frames;
+}
+
+/**
+ * Read the packets of an Ogg Opus file (as written by opusenc), skipping
+ * the OpusHead/OpusTags headers. Only the first logical stream is used.
+ */
+bool loadOggOpus(const std::string& path, std::vector<OpusPacket>& packets) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    std::fclose(file);
+
+    std::vector<uint8_t> partial;
+    uint32_t serial = 0;
+    bool haveSerial = false;
+    size_t pos = 0;
+
+    while (pos + 27 <= data.size() && std::memcmp(data.data() + pos, "OggS", 4) == 0) {
+        uint32_t pageSerial = data[pos + 14] | (data[pos + 15] << 8) | (data[pos + 16] << 16) |
+                              (static_cast<uint32_t>(data[pos + 17]) << 24);
+        size_t segments = data[pos + 26];
+        size_t body = pos + 27 + segments;
+        if (body > data.size()) {
+            break;
+        }
+        if (!haveSerial) {
+            serial = pageSerial;
+            haveSerial = true;
+        }
+
+        size_t offset = body;
+        for (size_t s = 0; s < segments; s++) {
+            size_t lace = data[pos + 27 + s];
+            if (offset + lace > data.size()) {
+                return false;
+            }
+            if (pageSerial == serial) {
+                partial.insert(partial.end(), data.begin() + offset, data.begin() + offset + lace);
+                if (lace < 255) {
+                    bool header = partial.size() >= 8 &&
+                                  (std::memcmp(partial.data(), "OpusHead", 8) == 0 ||
+                                   std::memcmp(partial.data(), "OpusTags", 8) == 0);
+                    if (!header && !partial.empty()) {
+                        int64_t duration = opusPacketDurationUs(partial);
+                        packets.push_back({partial, duration});
+                    }
+                    partial.clear();
+                }
+            }
+            offset += lace;
+        }
+        pos = offset;
+    }
+
+    packets.erase(std::remove_if(packets.begin(), packets.end(),
+                                 [](const OpusPacket& p) { return p.durationUs <= 0; }),
+                  packets.end());
+    return !packets.empty();
+}
+
+// Fallback: synthetic speech, encoded once up front
+std::vector<OpusPacket> encodeSyntheticSpeech() {
+    Codec::Config config;
+    auto codec = Codec::createOpus(config);
+    std::vector<int16_t> speech = bench::makeSpeech(bench::kFrameSize * kSynthFrames);
+
+    std::vector<OpusPacket> packets;
+    uint8_t packet[4000];
+    for (int f = 0; f < kSynthFrames; f++) {
+        int bytes = codec->encode(speech.data() + f * bench::kFrameSize, bench::kFrameSize,
+                                  packet, sizeof(packet));
+        if (bytes > 0) {
+            packets.push_back({std::vector<uint8_t>(packet, packet + bytes), kSequenceUs});
+        }
+    }
+    return packets;
+}
+
+// =============================================================================
+// Metrics
+// =============================================================================
+
+struct Percentiles {
+    size_t count = 0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+Percentiles percentiles(std::vector<float> samples) {
+    Percentiles result;
+    result.count = samples.size();
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        return static_cast<double>(samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]);
+    };
+    result.p50 = at(0.50);
+    result.p95 = at(0.95);
+    result.p99 = at(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+// =============================================================================
+// Sessions
+// =============================================================================
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 64738;
+    std::string password;
+    std::string namePrefix = "load";
+    int clients = 100;
+    int seconds = 30;
+    int rampMs = 5000;                 // Spread connects over this long
+    double talkFraction = 0.1;         // Share of sessions that talk
+    int talkMs = 3000;
+    int silenceMs = 7000;
+    int moveIntervalMs = 0;            // Mean time between channel moves, 0 = never
+    int muteIntervalMs = 0;            // Mean time between mute toggles, 0 = never
+    bool udp = false;                  // Voice over UDP instead of UDPTunnel
+    std::string opusPath;
+    uint64_t seed = 1;
+    std::string jsonPath;
+
+    // In-process MockMumbleServer instead of --host/--port
+    bool mock = false;
+    int mockChannels = 4;
+    double mockDelayMs = 0.0;
+    double mockJitterMs = 0.0;
+};
+
+enum class Phase {
+    Waiting,        // Not connected yet (ramp)
+    Connecting,     // TCP connect in progress
+    Handshake,      // TLS handshake
+    Synchronizing,  // Authenticated, waiting for ServerSync
+    Synchronized,
+    Failed
+};
+
+struct Session {
+    int index = 0;
+    Phase phase = Phase::Waiting;
+    int fd = -1;
+    int udpFd = -1;
+    SSL* ssl = nullptr;
+    bool wantWrite = false;
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    size_t outPos = 0;
+
+    uint32_t session = 0;
+    uint32_t channelId = 0;
+    bool selfMute = false;
+    CryptState crypt;
+    bool cryptReady = false;
+
+    // Schedule
+    int64_t connectAtUs = 0;
+    int64_t connectStartUs = 0;
+    int64_t nextPingUs = 0;
+    int64_t nextMoveUs = INT64_MAX;
+    int64_t nextMuteUs = INT64_MAX;
+
+    // Talking
+    bool talker = false;
+    int64_t phaseStartUs = 0;
+    int64_t nextVoiceUs = INT64_MAX;
+    bool inTransmission = false;
+    size_t packetIndex = 0;
+    uint64_t sequence = 0;
+    std::vector<int64_t> sentAtUs = std::vector<int64_t>(kSendHistory, 0);
+    std::vector<uint64_t> sentSequence = std::vector<uint64_t>(kSendHistory, UINT64_MAX);
+
+    // Results
+    double connectMs = 0.0;
+    std::string rejectReason;
+    std::vector<float> tcpRttMs;
+    std::vector<float> udpRttMs;
+    std::vector<float> voiceLatencyMs;   // As a listener
+    uint64_t voiceSent = 0;
+    uint64_t voiceReceived = 0;
+    uint64_t voiceUnmatched = 0;         // Not from one of our sessions, or too old
+    uint32_t moves = 0;
+    uint32_t muteToggles = 0;
+};
+
+class LoadGenerator {
+public:
+    LoadGenerator(const Options& options, std::vector<OpusPacket> packets);
+    ~LoadGenerator();
+
+    bool resolve(const std::string& host, int port);
+    void run();
+    void report() const;
+    bool writeJson(const std::string& path) const;
+
+private:
+    void startConnect(Session& s, int64_t now);
+    void onWritable(Session& s, int64_t now);
+    void onReadable(Session& s, int64_t now);
+    void continueHandshake(Session& s, int64_t now);
+    void flush(Session& s);
+    void fail(Session& s, const std::string& reason);
+    void close(Session& s);
+
+    void queueMessage(Session& s, MessageType type, const google::protobuf::Message& message);
+    void queueRaw(Session& s, MessageType type, const uint8_t* data, size_t length);
+    void handleMessage(Session& s, MessageType type, const uint8_t* data, size_t length, int64_t now);
+
+    void sendDatagram(Session& s, const uint8_t* data, size_t length);
+    void receiveUdp(Session& s, int64_t now);
+    void handleVoice(Session& s, const uint8_t* data, size_t length, int64_t now);
+
+    void runSchedule(Session& s, int64_t now);
+    void sendVoice(Session& s, int64_t now);
+    int64_t nextDue(const Session& s) const;
+
+    Options options_;
+    std::vector<OpusPacket> packets_;
+    int64_t cycleUs_;
+    Random random_;
+
+    SSL_CTX* sslCtx_{nullptr};
+    sockaddr_storage server_{};
+    socklen_t serverLength_{0};
+
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::map<uint32_t, Session*> bySession_;
+    std::vector<uint32_t> channels_;     // As announced by the server
+    int64_t startUs_{0};
+    int64_t endUs_{0};
+};
+
+LoadGenerator::LoadGenerator(const Options& options, std::vector<OpusPacket> packets)
+    : options_(options)
+    , packets_(std::move(packets))
+    , cycleUs_(static_cast<int64_t>(options.talkMs + options.silenceMs) * 1000)
+    , random_(options.seed) {
+    SSL_library_init();
+    SSL_load_error_strings();
+    sslCtx_ = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(sslCtx_, TLS1_2_VERSION);
+    SSL_CTX_set_verify(sslCtx_, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_mode(sslCtx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    int talkers = static_cast<int>(options.clients * options.talkFraction + 0.5);
+    for (int i = 0; i < options.clients; i++) {
+        auto s = std::make_unique<Session>();
+        s->index = i;
+        s->talker = i < talkers;
+        s->packetIndex = (static_cast<size_t>(i) * 37) % packets_.size();
+        sessions_.push_back(std::move(s));
+    }
+}
+
+LoadGenerator::~LoadGenerator() {
+    for (auto& s : sessions_) {
+        close(*s);
+    }
+    SSL_CTX_free(sslCtx_);
+}
+
+bool LoadGenerator::resolve(const std::string& host, int port) {
+    struct addrinfo hints{}, *result;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    std::string portStr = std::to_string(port);
+    if (getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result) != 0) {
+        return false;
+    }
+    std::memcpy(&server_, result->ai_addr, result->ai_addrlen);
+    serverLength_ = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+void LoadGenerator::run() {
+    startUs_ = nowUs();
+    endUs_ = startUs_ + static_cast<int64_t>(options_.seconds) * 1000000;
+    for (auto& s : sessions_) {
+        s->connectAtUs = startUs_ + (options_.clients > 1
+            ? static_cast<int64_t>(options_.rampMs) * 1000 * s->index / (options_.clients - 1) : 0);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<std::pair<Session*, bool>> owners;   // Session and whether the fd is UDP
+
+    while (!gStop) {
+        int64_t now = nowUs();
+        if (now >= endUs_) {
+            break;
+        }
+
+        int64_t due = endUs_;
+        for (auto& s : sessions_) {
+            runSchedule(*s, now);
+            flush(*s);
+            due = std::min(due, nextDue(*s));
+        }
+
+        fds.clear();
+        owners.clear();
+        for (auto& s : sessions_) {
+            if (s->fd >= 0) {
+                short events = POLLIN;
+                if (s->phase == Phase::Connecting || s->wantWrite || s->outPos < s->out.size()) {
+                    events |= POLLOUT;
+                }
+                fds.push_back({s->fd, events, 0});
+                owners.push_back({s.get(), false});
+            }
+            if (s->udpFd >= 0) {
+                fds.push_back({s->udpFd, POLLIN, 0});
+                owners.push_back({s.get(), true});
+            }
+        }
+
+        int timeoutMs = static_cast<int>(std::max<int64_t>(0, (due - nowUs() + 999) / 1000));
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            break;
+        }
+
+        now = nowUs();
+        for (size_t i = 0; i < fds.size(); i++) {
+            Session& s = *owners[i].first;
+            short revents = fds[i].revents;
+            if (revents == 0 || s.phase == Phase::Failed) {
+                continue;
+            }
+            if (owners[i].second) {
+                receiveUdp(s, now);
+            } else if (s.phase == Phase::Connecting) {
+                onWritable(s, now);
+            } else if (revents & (POLLIN | POLLOUT | POLLHUP | POLLERR)) {
+                onReadable(s, now);
+            }
+        }
+    }
+
+    for (auto& s : sessions_) {
+        close(*s);
+    }
+}
+
+int64_t LoadGenerator::nextDue(const Session& s) const {
+    switch (s.phase) {
+        case Phase::Waiting:
+            return s.connectAtUs;
+        case Phase::Synchronized:
+            return std::min({s.nextPingUs, s.nextMoveUs, s.nextMuteUs, s.nextVoiceUs});
+        default:
+            return INT64_MAX;
+    }
+}
+
+void LoadGenerator::runSchedule(Session& s, int64_t now) {
+    if (s.phase == Phase::Waiting && now >= s.connectAtUs) {
+        startConnect(s, now);
+        return;
+    }
+    if (s.phase != Phase::Synchronized) {
+        return;
+    }
+
+    if (now >= s.nextPingUs) {
+        MumbleProto::Ping ping;
+        ping.set_timestamp(static_cast<uint64_t>(now));
+        queueMessage(s, MessageType::Ping, ping);
+
+        if (s.udpFd >= 0 && s.cryptReady) {
+            // Also establishes the UDP path before the first voice packet
+            uint8_t packet[16];
+            size_t length = 0;
+            packet[length++] = voiceHeader(UdpMessageType::Ping, 0);
+            length += writeVarint(packet + length, static_cast<uint64_t>(now));
+            sendDatagram(s, packet, length);
+        }
+        s.nextPingUs = now + kPingIntervalUs;
+    }
+
+    if (now >= s.nextMoveUs) {
+        if (channels_.size() > 1) {
+            uint32_t target = s.channelId;
+            while (target == s.channelId) {
+                target = channels_[static_cast<size_t>(random_.uniform() * channels_.size()) % channels_.size()];
+            }
+            MumbleProto::UserState state;
+            state.set_session(s.session);
+            state.set_channel_id(target);
+            queueMessage(s, MessageType::UserState, state);
+            s.moves++;
+        }
+        s.nextMoveUs = now + random_.interval(static_cast<int64_t>(options_.moveIntervalMs) * 1000);
+    }
+
+    if (now >= s.nextMuteUs) {
+        MumbleProto::UserState state;
+        state.set_session(s.session);
+        state.set_self_mute(!s.selfMute);
+        queueMessage(s, MessageType::UserState, state);
+        s.muteToggles++;
+        s.nextMuteUs = now + random_.interval(static_cast<int64_t>(options_.muteIntervalMs) * 1000);
+    }
+
+    while (now >= s.nextVoiceUs) {
+        sendVoice(s, now);
+    }
+}
+
+void LoadGenerator::sendVoice(Session& s, int64_t now) {
+    const OpusPacket& opus = packets_[s.packetIndex];
+    int64_t due = s.nextVoiceUs;
+    s.nextVoiceUs += opus.durationUs;
+
+    int64_t talkUs = static_cast<int64_t>(options_.talkMs) * 1000;
+    int64_t phase = cycleUs_ > 0 ? (due - s.phaseStartUs) % cycleUs_ : 0;
+    bool talking = phase < talkUs && !s.selfMute;
+    if (!talking && !s.inTransmission) {
+        return;
+    }
+    // The frame that crosses the end of the talk spurt carries the terminator
+    bool last = !talking || phase + opus.durationUs >= talkUs;
+    s.inTransmission = !last;
+
+    uint8_t packet[kMaxDatagram];
+    size_t length = 0;
+    packet[length++] = voiceHeader(UdpMessageType::Opus, kVoiceTargetNormal);
+    length += writeVarint(packet + length, s.sequence);
+    length += writeVarint(packet + length, opus.data.size() | (last ? kOpusTerminator : 0));
+    if (length + opus.data.size() > sizeof(packet)) {
+        return;
+    }
+    std::memcpy(packet + length, opus.data.data(), opus.data.size());
+    length += opus.data.size();
+
+    size_t slot = s.sequence % kSendHistory;
+    s.sentAtUs[slot] = now;
+    s.sentSequence[slot] = s.sequence;
+    s.sequence += static_cast<uint64_t>(std::max<int64_t>(1, opus.durationUs / kSequenceUs));
+    s.packetIndex = (s.packetIndex + 1) % packets_.size();
+    s.voiceSent++;
+
+    if (options_.udp && s.cryptReady && s.udpFd >= 0) {
+        sendDatagram(s, packet, length);
+    } else {
+        queueRaw(s, MessageType::UDPTunnel, packet, length);
+    }
+}
+
+// =============================================================================
+// Connection handling
+// =============================================================================
+
+void LoadGenerator::startConnect(Session& s, int64_t now) {
+    s.connectStartUs = now;
+    s.fd = socket(server_.ss_family, SOCK_STREAM, 0);
+    if (s.fd < 0 || !setNonBlocking(s.fd)) {
+        fail(s, "socket");
+        return;
+    }
+    int one = 1;
+    setsockopt(s.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(s.fd, reinterpret_cast<sockaddr*>(&server_), serverLength_) < 0 && errno != EINPROGRESS) {
+        fail(s, "connect");
+        return;
+    }
+    s.phase = Phase::Connecting;
+}
+
+void LoadGenerator::onWritable(Session& s, int64_t now) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(s.fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        fail(s, "connect");
+        return;
+    }
+    s.ssl = SSL_new(sslCtx_);
+    SSL_set_fd(s.ssl, s.fd);
+    s.phase = Phase::Handshake;
+    continueHandshake(s, now);
+}
+
+void LoadGenerator::continueHandshake(Session& s, int64_t now) {
+    int result = SSL_connect(s.ssl);
+    if (result != 1) {
+        int error = SSL_get_error(s.ssl, result);
+        if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+            s.wantWrite = error == SSL_ERROR_WANT_WRITE;
+        } else {
+            fail(s, "tls");
+        }
+        return;
+    }
+    s.wantWrite = false;
+    s.phase = Phase::Synchronizing;
+
+    MumbleProto::Version version;
+    version.set_version(MUMBLE_VERSION);
+    version.set_release("SAYses LoadGen");
+    version.set_os("Linux");
+    queueMessage(s, MessageType::Version, version);
+
+    MumbleProto::Authenticate auth;
+    auth.set_username(options_.namePrefix + "-" + std::to_string(s.index));
+    if (!options_.password.empty()) {
+        auth.set_password(options_.password);
+    }
+    auth.set_opus(true);
+    queueMessage(s, MessageType::Authenticate, auth);
+    (void)now;
+}
+
+void LoadGenerator::onReadable(Session& s, int64_t now) {
+    if (s.phase == Phase::Handshake) {
+        continueHandshake(s, now);
+        return;
+    }
+
+    uint8_t buffer[16384];
+    while (true) {
+        int n = SSL_read(s.ssl, buffer, sizeof(buffer));
+        if (n > 0) {
+            s.in.insert(s.in.end(), buffer, buffer + n);
+            continue;
+        }
+        int error = SSL_get_error(s.ssl, n);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            s.wantWrite = true;
+        } else if (error != SSL_ERROR_WANT_READ) {
+            fail(s, s.rejectReason.empty() ? "disconnected" : s.rejectReason);
+            return;
+        }
+        break;
+    }
+
+    size_t offset = 0;
+    while (s.phase != Phase::Failed && s.in.size() - offset >= kMessageHeaderSize) {
+        uint16_t type;
+        uint32_t length;
+        readMessageHeader(s.in.data() + offset, type, length);
+        if (length > kMaxMessageLength) {
+            fail(s, "oversized message");
+            return;
+        }
+        if (s.in.size() - offset < kMessageHeaderSize + length) {
+            break;
+        }
+        handleMessage(s, static_cast<MessageType>(type), s.in.data() + offset + kMessageHeaderSize, length, now);
+        offset += kMessageHeaderSize + length;
+    }
+    if (s.phase != Phase::Failed) {
+        s.in.erase(s.in.begin(), s.in.begin() + offset);
+    }
+}
+
+void LoadGenerator::flush(Session& s) {
+    if (!s.ssl || s.phase == Phase::Handshake || s.phase == Phase::Failed) {
+        return;
+    }
+    while (s.outPos < s.out.size()) {
+        size_t pending = s.out.size() - s.outPos;
+        int n = SSL_write(s.ssl, s.out.data() + s.outPos, static_cast<int>(std::min<size_t>(pending, INT_MAX)));
+        if (n > 0) {
+            s.outPos += static_cast<size_t>(n);
+            continue;
+        }
+        int error = SSL_get_error(s.ssl, n);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            s.wantWrite = true;
+        } else if (error != SSL_ERROR_WANT_READ) {
+            fail(s, "write");
+        }
+        return;
+    }
+    s.wantWrite = false;
+    s.out.clear();
+    s.outPos = 0;
+}
+
+void LoadGenerator::fail(Session& s, const std::string& reason) {
+    if (s.rejectReason.empty()) {
+        s.rejectReason = reason;
+    }
+    close(s);
+    s.phase = Phase::Failed;
+}
+
+void LoadGenerator::close(Session& s) {
+    if (s.session != 0) {
+        bySession_.erase(s.session);
+    }
+    if (s.ssl) {
+        SSL_shutdown(s.ssl);
+        SSL_free(s.ssl);
+        s.ssl = nullptr;
+    }
+    for (int* fd : {&s.fd, &s.udpFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void LoadGenerator::queueMessage(Session& s, MessageType type, const google::protobuf::Message& message) {
+    std::string serialized;
+    if (message.SerializeToString(&serialized)) {
+        queueRaw(s, type, reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+    }
+}
+
+void LoadGenerator::queueRaw(Session& s, MessageType type, const uint8_t* data, size_t length) {
+    uint8_t header[kMessageHeaderSize];
+    writeMessageHeader(header, type, static_cast<uint32_t>(length));
+    s.out.insert(s.out.end(), header, header + kMessageHeaderSize);
+    s.out.insert(s.out.end(), data, data + length);
+}
+
+void LoadGenerator::handleMessage(Session& s, MessageType type, const uint8_t* data, size_t length,
+                                  int64_t now) {
+    int size = static_cast<int>(length);
+
+    switch (type) {
+        case MessageType::Reject: {
+            MumbleProto::Reject reject;
+            reject.ParseFromArray(data, size);
+            fail(s, "rejected: " + reject.reason());
+            break;
+        }
+        case MessageType::CryptSetup: {
+            MumbleProto::CryptSetup setup;
+            if (setup.ParseFromArray(data, size) && setup.key().size() == 16 &&
+                setup.client_nonce().size() == 16 && setup.server_nonce().size() == 16) {
+                s.cryptReady = s.crypt.init(reinterpret_cast<const uint8_t*>(setup.key().data()),
+                                            reinterpret_cast<const uint8_t*>(setup.client_nonce().data()),
+                                            reinterpret_cast<const uint8_t*>(setup.server_nonce().data()));
+            }
+            break;
+        }
+        case MessageType::ChannelState: {
+            MumbleProto::ChannelState state;
+            if (state.ParseFromArray(data, size) &&
+                std::find(channels_.begin(), channels_.end(), state.channel_id()) == channels_.end()) {
+                channels_.push_back(state.channel_id());
+            }
+            break;
+        }
+        case MessageType::UserState: {
+            MumbleProto::UserState state;
+            if (state.ParseFromArray(data, size) && s.session != 0 && state.session() == s.session) {
+                if (state.has_channel_id()) {
+                    s.channelId = state.channel_id();
+                }
+                if (state.has_self_mute()) {
+                    s.selfMute = state.self_mute();
+                }
+            }
+            break;
+        }
+        case MessageType::ServerSync: {
+            MumbleProto::ServerSync sync;
+            if (!sync.ParseFromArray(data, size)) {
+                break;
+            }
+            s.session = sync.session();
+            bySession_[s.session] = &s;
+            s.phase = Phase::Synchronized;
+            s.connectMs = (now - s.connectStartUs) / 1000.0;
+
+            if (options_.udp) {
+                s.udpFd = socket(server_.ss_family, SOCK_DGRAM, 0);
+                if (s.udpFd >= 0 && (!setNonBlocking(s.udpFd) ||
+                    ::connect(s.udpFd, reinterpret_cast<sockaddr*>(&server_), serverLength_) != 0)) {
+                    ::close(s.udpFd);
+                    s.udpFd = -1;
+                }
+            }
+
+            s.nextPingUs = now;
+            if (options_.moveIntervalMs > 0) {
+                s.nextMoveUs = now + random_.interval(static_cast<int64_t>(options_.moveIntervalMs) * 1000);
+            }
+            if (options_.muteIntervalMs > 0) {
+                s.nextMuteUs = now + random_.interval(static_cast<int64_t>(options_.muteIntervalMs) * 1000);
+            }
+            if (s.talker) {
+                // Random phase, so talkers do not key up in lockstep
+                s.phaseStartUs = now - static_cast<int64_t>(random_.uniform() * cycleUs_);
+                s.nextVoiceUs = now + kPingIntervalUs / 10;   // Let the UDP path settle first
+            }
+            break;
+        }
+        case MessageType::Ping: {
+            MumbleProto::Ping ping;
+            if (ping.ParseFromArray(data, size) && ping.has_timestamp()) {
+                s.tcpRttMs.push_back((now - static_cast<int64_t>(ping.timestamp())) / 1000.0f);
+            }
+            break;
+        }
+        case MessageType::UDPTunnel:
+            handleVoice(s, data, length, now);
+            break;
+        default:
+            break;
+    }
+}
+
+// =============================================================================
+// Voice
+// =============================================================================
+
+void LoadGenerator::sendDatagram(Session& s, const uint8_t* data, size_t length) {
+    uint8_t encrypted[kMaxDatagram + 4];
+    if (length <= kMaxDatagram && s.crypt.encrypt(data, encrypted, length)) {
+        send(s.udpFd, encrypted, length + 4, 0);
+    }
+}
+
+void LoadGenerator::receiveUdp(Session& s, int64_t now) {
+    uint8_t buffer[kMaxDatagram + 4];
+    uint8_t plain[kMaxDatagram + 4];
+    while (true) {
+        ssize_t n = recv(s.udpFd, buffer, sizeof(buffer), 0);
+        if (n <= 4) {
+            return;
+        }
+        if (!s.crypt.decrypt(buffer, plain, static_cast<size_t>(n))) {
+            continue;
+        }
+        size_t length = static_cast<size_t>(n) - 4;
+        if (voiceType(plain[0]) == UdpMessageType::Ping) {
+            uint64_t timestamp;
+            if (readVarint(plain + 1, length - 1, timestamp) > 0) {
+                s.udpRttMs.push_back((now - static_cast<int64_t>(timestamp)) / 1000.0f);
+            }
+            continue;
+        }
+        handleVoice(s, plain, length, now);
+    }
+}
+
+void LoadGenerator::handleVoice(Session& s, const uint8_t* data, size_t length, int64_t now) {
+    if (length < 3 || voiceType(data[0]) == UdpMessageType::Ping) {
+        return;
+    }
+    s.voiceReceived++;
+
+    uint64_t sender;
+    uint64_t sequence;
+    size_t pos = 1;
+    size_t used = readVarint(data + pos, length - pos, sender);
+    pos += used;
+    size_t usedSequence = used ? readVarint(data + pos, length - pos, sequence) : 0;
+    if (!usedSequence) {
+        s.voiceUnmatched++;
+        return;
+    }
+
+    auto it = bySession_.find(static_cast<uint32_t>(sender));
+    if (it == bySession_.end()) {
+        s.voiceUnmatched++;
+        return;
+    }
+    const Session& source = *it->second;
+    size_t slot = sequence % kSendHistory;
+    if (source.sentSequence[slot] != sequence) {
+        s.voiceUnmatched++;
+        return;
+    }
+    s.voiceLatencyMs.push_back((now - source.sentAtUs[slot]) / 1000.0f);
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+void LoadGenerator::report() const {
+    size_t synchronized = 0;
+    std::vector<float> connect;
+    std::vector<float> tcp;
+    std::vector<float> udp;
+    std::vector<float> voice;
+    std::vector<float> perClientVoiceP95;
+    std::vector<float> perClientTcpP95;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t unmatched = 0;
+    uint64_t moves = 0;
+    uint64_t toggles = 0;
+    std::map<std::string, int> failures;
+
+    for (const auto& s : sessions_) {
+        if (s->connectMs > 0.0) {
+            synchronized++;
+            connect.push_back(static_cast<float>(s->connectMs));
+        }
+        if (!s->rejectReason.empty()) {
+            failures[s->rejectReason]++;
+        }
+        tcp.insert(tcp.end(), s->tcpRttMs.begin(), s->tcpRttMs.end());
+        udp.insert(udp.end(), s->udpRttMs.begin(), s->udpRttMs.end());
+        voice.insert(voice.end(), s->voiceLatencyMs.begin(), s->voiceLatencyMs.end());
+        if (!s->voiceLatencyMs.empty()) {
+            perClientVoiceP95.push_back(static_cast<float>(percentiles(s->voiceLatencyMs).p95));
+        }
+        if (!s->tcpRttMs.empty()) {
+            perClientTcpP95.push_back(static_cast<float>(percentiles(s->tcpRttMs).p95));
+        }
+        sent += s->voiceSent;
+        received += s->voiceReceived;
+        unmatched += s->voiceUnmatched;
+        moves += s->moves;
+        toggles += s->muteToggles;
+    }
+
+    auto row = [](const char* name, const Percentiles& p) {
+        std::printf("  %-22s n=%-8zu p50 %8.2f  p95 %8.2f  p99 %8.2f  max %8.2f ms\n",
+                    name, p.count, p.p50, p.p95, p.p99, p.max);
+    };
+
+    std::printf("sessions: %zu/%d synchronized\n", synchronized, options_.clients);
+    for (const auto& failure : failures) {
+        std::printf("  %d x %s\n", failure.second, failure.first.c_str());
+    }
+    std::printf("actions: %llu channel moves, %llu mute toggles\n",
+                static_cast<unsigned long long>(moves), static_cast<unsigned long long>(toggles));
+    std::printf("voice: %llu packets sent, %llu received (%llu unmatched), transport %s\n",
+                static_cast<unsigned long long>(sent), static_cast<unsigned long long>(received),
+                static_cast<unsigned long long>(unmatched), options_.udp ? "udp" : "tcp tunnel");
+    row("connect", percentiles(connect));
+    row("tcp rtt", percentiles(tcp));
+    if (options_.udp) {
+        row("udp rtt", percentiles(udp));
+    }
+    row("voice latency", percentiles(voice));
+    row("per-client tcp p95", percentiles(perClientTcpP95));
+    row("per-client voice p95", percentiles(perClientVoiceP95));
+}
+
+bool LoadGenerator::writeJson(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    auto json = [](const Percentiles& p) {
+        char text[160];
+        std::snprintf(text, sizeof(text), "{\"n\": %zu, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                      p.count, p.p50, p.p95, p.p99, p.max);
+        return std::string(text);
+    };
+
+    std::fprintf(file, "{\n  \"clients\": %d,\n  \"seconds\": %d,\n  \"transport\": \"%s\",\n  \"sessions\": [\n",
+                 options_.clients, options_.seconds, options_.udp ? "udp" : "tcp");
+    for (size_t i = 0; i < sessions_.size(); i++) {
+        const Session& s = *sessions_[i];
+        std::string reason;
+        for (char c : s.rejectReason) {
+            if (c != '"' && c != '\\') {
+                reason += c;
+            }
+        }
+        std::fprintf(file,
+                     "    {\"index\": %d, \"session\": %u, \"talker\": %s, \"connect_ms\": %.3f, \"error\": \"%s\", "
+                     "\"voice_sent\": %llu, \"voice_received\": %llu, \"moves\": %u, \"mute_toggles\": %u, "
+                     "\"tcp_rtt_ms\": %s, \"udp_rtt_ms\": %s, \"voice_latency_ms\": %s}%s\n",
+                     s.index, s.session, s.talker ? "true" : "false", s.connectMs, reason.c_str(),
+                     static_cast<unsigned long long>(s.voiceSent),
+                     static_cast<unsigned long long>(s.voiceReceived),
+                     s.moves, s.muteToggles,
+                     json(percentiles(s.tcpRttMs)).c_str(),
+                     json(percentiles(s.udpRttMs)).c_str(),
+                     json(percentiles(s.voiceLatencyMs)).c_str(),
+                     i + 1 < sessions_.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+// =============================================================================
+// Command line
+// =============================================================================
+
+void printUsage() {
+    std::printf(
+        "Usage: SaysesLoadGen [options]\n"
+        "  --host=HOST --port=N    Server (default 127.0.0.1:64738)\n"
+        "  --password=PW           Server password\n"
+        "  --name=PREFIX           Username prefix (default load)\n"
+        "  --clients=N             Sessions (default 100)\n"
+        "  --seconds=N             Test length (default 30)\n"
+        "  --ramp-ms=N             Spread connects over N ms (default 5000)\n"
+        "  --talk-fraction=X       Share of sessions that talk (default 0.1)\n"
+        "  --talk-ms=N --silence-ms=N  Talker duty cycle (default 3000/7000)\n"
+        "  --move-interval-ms=N    Mean time between channel moves per session (0 = off)\n"
+        "  --mute-interval-ms=N    Mean time between mute toggles per session (0 = off)\n"
+        "  --opus=FILE             Ogg Opus file to replay (default: synthetic speech)\n"
+        "  --udp                   Voice over UDP (SAYses CryptState; use with the mock server)\n"
+        "  --seed=N                Schedule seed (default 1)\n"
+        "  --json=PATH             Per-session results\n"
+        "  --mock                  Run against an in-process MockMumbleServer\n"
+        "  --mock-channels=N --mock-delay-ms=X --mock-jitter-ms=X\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--", 2) != 0) {
+            return false;
+        }
+        const char* eq = std::strchr(arg, '=');
+        std::string key = eq ? std::string(arg + 2, eq) : std::string(arg + 2);
+        const char* value = eq ? eq + 1 : "";
+
+        if (key == "udp") {
+            o.udp = true;
+        } else if (key == "mock") {
+            o.mock = true;
+        } else if (!eq) {
+            return false;
+        } else if (key == "host") {
+            o.host = value;
+        } else if (key == "port") {
+            o.port = std::atoi(value);
+        } else if (key == "password") {
+            o.password = value;
+        } else if (key == "name") {
+            o.namePrefix = value;
+        } else if (key == "clients") {
+            o.clients = std::max(1, std::atoi(value));
+        } else if (key == "seconds") {
+            o.seconds = std::max(1, std::atoi(value));
+        } else if (key == "ramp-ms") {
+            o.rampMs = std::max(0, std::atoi(value));
+        } else if (key == "talk-fraction") {
+            o.talkFraction = std::min(1.0, std::max(0.0, std::atof(value)));
+        } else if (key == "talk-ms") {
+            o.talkMs = std::max(0, std::atoi(value));
+        } else if (key == "silence-ms") {
+            o.silenceMs = std::max(0, std::atoi(value));
+        } else if (key == "move-interval-ms") {
+            o.moveIntervalMs = std::max(0, std::atoi(value));
+        } else if (key == "mute-interval-ms") {
+            o.muteIntervalMs = std::max(0, std::atoi(value));
+        } else if (key == "opus") {
+            o.opusPath = value;
+        } else if (key == "seed") {
+            o.seed = std::strtoull(value, nullptr, 10);
+        } else if (key == "json") {
+            o.jsonPath = value;
+        } else if (key == "mock-channels") {
+            o.mockChannels = std::max(0, std::atoi(value));
+        } else if (key == "mock-delay-ms") {
+            o.mockDelayMs = std::atof(value);
+        } else if (key == "mock-jitter-ms") {
+            o.mockJitterMs = std::atof(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+}  // namespace sayses
+
+int main(int argc, char** argv) {
+    using namespace sayses;
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<OpusPacket> packets;
+    if (!options.opusPath.empty()) {
+        if (!loadOggOpus(options.opusPath, packets)) {
+            std::fprintf(stderr, "Cannot read Ogg Opus packets from %s\n", options.opusPath.c_str());
+            return 1;
+        }
+    } else {
+        packets = encodeSyntheticSpeech();
+    }
+    if (packets.empty()) {
+        std::fprintf(stderr, "No voice packets to replay\n");
+        return 1;
+    }
+
+    std::unique_ptr<MockMumbleServer> mock;
+    if (options.mock) {
+        MockMumbleServer::Config config;
+        config.port = 0;
+        config.channels = options.mockChannels;
+        config.maxUsers = static_cast<uint32_t>(options.clients);
+        if (options.mockDelayMs > 0.0 || options.mockJitterMs > 0.0) {
+            config.impairVoice = true;
+            config.network.baseDelayMs = options.mockDelayMs;
+            config.network.jitterMs = options.mockJitterMs;
+            config.network.jitter = options.mockJitterMs > 0.0
+                ? bench::NetworkImpairment::Jitter::Normal : bench::NetworkImpairment::Jitter::None;
+        }
+        mock = MockMumbleServer::create(config);
+        if (!mock->start()) {
+            std::fprintf(stderr, "Cannot start the mock server\n");
+            return 1;
+        }
+        options.host = "127.0.0.1";
+        options.port = mock->getPort();
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    LoadGenerator generator(options, std::move(packets));
+    if (!generator.resolve(options.host, options.port)) {
+        std::fprintf(stderr, "Cannot resolve %s\n", options.host.c_str());
+        return 1;
+    }
+
+    std::printf("%d sessions against %s:%d for %ds%s\n", options.clients, options.host.c_str(),
+                options.port, options.seconds, mock ? " (in-process mock server)" : "");
+    std::fflush(stdout);
+    generator.run();
+    generator.report();
+
+    if (mock) {
+        MockMumbleServer::Stats stats = mock->getStats();
+        std::printf("mock server: voice in %llu out %llu dropped %llu, pings %llu\n",
+                    static_cast<unsigned long long>(stats.voicePacketsIn),
+                    static_cast<unsigned long long>(stats.voicePacketsOut),
+                    static_cast<unsigned long long>(stats.voicePacketsDropped),
+                    static_cast<unsigned long long>(stats.pingsAnswered));
+        mock->stop();
+    }
+
+    if (!options.jsonPath.empty() && !generator.writeJson(options.jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
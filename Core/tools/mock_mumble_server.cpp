@@ -0,0 +1,1268 @@
+/**
+ * Mock Mumble Server Implementation
+ * Single-threaded poll() loop with non-blocking TLS and UDP sockets
+ */
+
+#include "mock_mumble_server.h"
+#include "bench_signal.h"
+#include "codec.h"
+#include "crypto.h"
+#include "mumble_protocol.h"
+#include "Mumble.pb.h"
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace sayses {
+
+namespace {
+
+constexpr int64_t kFrameUs = 10000;                  // Talkers send one 10ms Opus frame per packet
+constexpr size_t kMaxDatagram = 2048;
+constexpr uint32_t kMaxMessageLength = 8 * 1024 * 1024;
+constexpr uint32_t kRootChannel = 0;
+constexpr int kTalkerSignalFrames = 200;             // 2s of speech, cycled by every talker
+constexpr int kMaxPollMs = 250;
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Stable key for a UDP peer address
+std::string addressKey(const sockaddr_storage& address) {
+    char host[INET6_ADDRSTRLEN] = {0};
+    int port = 0;
+    if (address.ss_family == AF_INET) {
+        const auto* in = reinterpret_cast<const sockaddr_in*>(&address);
+        inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+        port = ntohs(in->sin_port);
+    } else if (address.ss_family == AF_INET6) {
+        const auto* in6 = reinterpret_cast<const sockaddr_in6*>(&address);
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        port = ntohs(in6->sin6_port);
+    }
+    return std::string(host) + "/" + std::to_string(port);
+}
+
+std::string hostOf(const std::string& key) {
+    return key.substr(0, key.find('/'));
+}
+
+void writeBigEndian32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+bool generateCertificate(SSL_CTX* ctx) {
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* keyCtx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    bool ok = keyCtx &&
+              EVP_PKEY_keygen_init(keyCtx) > 0 &&
+              EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyCtx, NID_X9_62_prime256v1) > 0 &&
+              EVP_PKEY_keygen(keyCtx, &key) > 0;
+    EVP_PKEY_CTX_free(keyCtx);
+    if (!ok) {
+        return false;
+    }
+
+    X509* cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600L * 24 * 365);
+    X509_set_pubkey(cert, key);
+
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("SAYses Mock Server"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    ok = X509_sign(cert, key, EVP_sha256()) > 0 &&
+         SSL_CTX_use_certificate(ctx, cert) == 1 &&
+         SSL_CTX_use_PrivateKey(ctx, key) == 1;
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+}  // namespace
+
+class MockMumbleServerImpl : public MockMumbleServer {
+public:
+    explicit MockMumbleServerImpl(const Config& config);
+    ~MockMumbleServerImpl() override;
+
+    bool start() override;
+    void stop() override;
+    int getPort() const override { return port_; }
+    Stats getStats() const override;
+
+    uint32_t addChannel(const std::string& name, uint32_t parentId) override;
+    uint32_t addUser(const std::string& name, uint32_t channelId) override;
+    void setTalking(uint32_t session, bool talking) override;
+    void setEcho(bool echo) override;
+    void setImpairment(bool enabled, const bench::NetworkImpairment::Config& network) override;
+
+private:
+    struct Connection {
+        int fd{-1};
+        SSL* ssl{nullptr};
+        uint32_t session{0};          // 0 until authenticated
+        bool handshakeDone{false};
+        bool wantWrite{false};        // TLS needs the socket writable to progress
+        bool closeAfterFlush{false};  // Rejected: close once the Reject is out
+        bool closing{false};
+        int64_t lastActivityUs{0};
+
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        size_t outPos{0};
+
+        CryptState crypt;
+        bool udpValid{false};
+        sockaddr_storage udpAddress{};
+        socklen_t udpAddressLength{0};
+        std::string peerHost;
+        std::unique_ptr<bench::NetworkImpairment> impairment;
+    };
+
+    struct ServerChannel {
+        uint32_t id;
+        uint32_t parentId;
+        std::string name;
+        int32_t position;
+    };
+
+    struct ServerUser {
+        uint32_t session;
+        std::string name;
+        uint32_t channelId;
+        bool selfMute{false};
+        bool selfDeaf{false};
+        Connection* connection{nullptr};  // nullptr for synthetic users
+
+        // Synthetic talkers
+        bool dutyCycle{false};        // Follows talkMs/silenceMs from phaseStartUs
+        bool talking{false};          // Manual talkers only
+        bool inTransmission{false};
+        int64_t phaseStartUs{0};
+        uint64_t sequence{0};
+        size_t packetIndex{0};
+    };
+
+    struct DelayedVoice {
+        int64_t dueUs;
+        uint64_t order;
+        uint32_t session;
+        std::vector<uint8_t> packet;
+
+        bool operator>(const DelayedVoice& other) const {
+            return dueUs != other.dueUs ? dueUs > other.dueUs : order > other.order;
+        }
+    };
+
+    // Setup
+    bool initSSL();
+    bool openSockets();
+    void populate();
+    void encodeTalkerSignal();
+
+    // Event loop
+    void loop();
+    void wake();
+    void acceptClients();
+    void readConnection(Connection& connection);
+    void flushConnection(Connection& connection);
+    void receiveUdp();
+    void runTimers(int64_t now);
+    void closeConnection(int fd);
+    int pollTimeoutMs(int64_t now) const;
+
+    // Control channel
+    void queueMessage(Connection& connection, MessageType type, const google::protobuf::Message& message);
+    void queueRaw(Connection& connection, MessageType type, const uint8_t* data, size_t length);
+    void broadcast(MessageType type, const google::protobuf::Message& message, uint32_t exceptSession = 0);
+    void handleMessage(Connection& connection, MessageType type, const uint8_t* data, size_t length);
+    void handleAuthenticate(Connection& connection, const uint8_t* data, size_t length);
+    void handleUserState(Connection& connection, const uint8_t* data, size_t length);
+    void handlePing(Connection& connection, const uint8_t* data, size_t length);
+    void sendCryptSetup(Connection& connection);
+    void reject(Connection& connection, MumbleProto::Reject::RejectType type, const std::string& reason);
+
+    MumbleProto::ChannelState channelState(const ServerChannel& channel) const;
+    MumbleProto::UserState userState(const ServerUser& user) const;
+
+    // Voice
+    void handleVoice(ServerUser& sender, const uint8_t* data, size_t length);
+    void routeVoice(const ServerUser& sender, const std::vector<uint8_t>& packet, bool toSender);
+    void deliverVoice(Connection& connection, const std::vector<uint8_t>& packet, int64_t now);
+    void sendVoiceNow(Connection& connection, const std::vector<uint8_t>& packet);
+    bool sendUdp(Connection& connection, const uint8_t* data, size_t length);
+    void tickTalkers(int64_t now);
+    void resetImpairment(Connection& connection);
+
+    Config config_;
+    int port_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    mutable std::mutex mutex_;   // Guards everything below
+
+    SSL_CTX* sslCtx_{nullptr};
+    int listenFd_{-1};
+    int udpFd_{-1};
+    int wakePipe_[2]{-1, -1};
+
+    std::map<int, std::unique_ptr<Connection>> connections_;   // By TCP socket
+    std::map<std::string, Connection*> udpPeers_;              // By UDP source address
+    std::map<uint32_t, ServerChannel> channels_;
+    std::map<uint32_t, ServerUser> users_;
+    uint32_t nextChannelId_{1};
+    uint32_t nextSession_{1};
+
+    std::vector<std::vector<uint8_t>> talkerPackets_;
+    int64_t nextTalkerTickUs_{0};
+
+    std::priority_queue<DelayedVoice, std::vector<DelayedVoice>, std::greater<DelayedVoice>> delayed_;
+    uint64_t delayedOrder_{0};
+
+    bool echo_{false};
+    bool impairVoice_{false};
+    bench::NetworkImpairment::Config network_;
+
+    Stats stats_;
+};
+
+// Factory
+std::unique_ptr<MockMumbleServer> MockMumbleServer::create(const Config& config) {
+    return std::make_unique<MockMumbleServerImpl>(config);
+}
+
+MockMumbleServerImpl::MockMumbleServerImpl(const Config& config)
+    : config_(config)
+    , echo_(config.echo)
+    , impairVoice_(config.impairVoice)
+    , network_(config.network) {
+    SSL_library_init();
+    SSL_load_error_strings();
+}
+
+MockMumbleServerImpl::~MockMumbleServerImpl() {
+    stop();
+}
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+bool MockMumbleServerImpl::start() {
+    if (running_) {
+        return false;
+    }
+
+    if (!initSSL() || !openSockets()) {
+        stop();
+        return false;
+    }
+
+    encodeTalkerSignal();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        populate();
+        nextTalkerTickUs_ = nowUs() + kFrameUs;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&MockMumbleServerImpl::loop, this);
+    return true;
+}
+
+void MockMumbleServerImpl::stop() {
+    running_ = false;
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& pair : connections_) {
+        Connection& connection = *pair.second;
+        if (connection.ssl) {
+            SSL_shutdown(connection.ssl);
+            SSL_free(connection.ssl);
+        }
+        close(connection.fd);
+    }
+    connections_.clear();
+    udpPeers_.clear();
+    users_.clear();
+    channels_.clear();
+    delayed_ = {};
+
+    for (int* fd : {&listenFd_, &udpFd_, &wakePipe_[0], &wakePipe_[1]}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (sslCtx_) {
+        SSL_CTX_free(sslCtx_);
+        sslCtx_ = nullptr;
+    }
+}
+
+bool MockMumbleServerImpl::initSSL() {
+    sslCtx_ = SSL_CTX_new(TLS_server_method());
+    if (!sslCtx_) {
+        return false;
+    }
+    SSL_CTX_set_min_proto_version(sslCtx_, TLS1_2_VERSION);
+
+    // The write buffer grows between retries of a partial write
+    SSL_CTX_set_mode(sslCtx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    // Client certificates are accepted but not checked
+    SSL_CTX_set_verify(sslCtx_, SSL_VERIFY_NONE, nullptr);
+
+    if (config_.certificatePath.empty()) {
+        return generateCertificate(sslCtx_);
+    }
+    return SSL_CTX_use_certificate_file(sslCtx_, config_.certificatePath.c_str(), SSL_FILETYPE_PEM) == 1 &&
+           SSL_CTX_use_PrivateKey_file(sslCtx_, config_.privateKeyPath.c_str(), SSL_FILETYPE_PEM) == 1;
+}
+
+bool MockMumbleServerImpl::openSockets() {
+    struct addrinfo hints{}, *result;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    std::string portStr = std::to_string(config_.port);
+    if (getaddrinfo(config_.host.c_str(), portStr.c_str(), &hints, &result) != 0) {
+        return false;
+    }
+
+    listenFd_ = socket(result->ai_family, SOCK_STREAM, 0);
+    int one = 1;
+    bool ok = listenFd_ >= 0 &&
+              setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+              bind(listenFd_, result->ai_addr, result->ai_addrlen) == 0 &&
+              listen(listenFd_, SOMAXCONN) == 0 &&
+              setNonBlocking(listenFd_);
+
+    // UDP shares the TCP port, which may have been picked by the kernel
+    sockaddr_storage bound{};
+    socklen_t boundLength = sizeof(bound);
+    if (ok) {
+        ok = getsockname(listenFd_, reinterpret_cast<sockaddr*>(&bound), &boundLength) == 0;
+    }
+    if (ok) {
+        port_ = bound.ss_family == AF_INET6
+            ? ntohs(reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port)
+            : ntohs(reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+    }
+    if (ok && config_.udp) {
+        udpFd_ = socket(result->ai_family, SOCK_DGRAM, 0);
+        ok = udpFd_ >= 0 &&
+             bind(udpFd_, reinterpret_cast<sockaddr*>(&bound), boundLength) == 0 &&
+             setNonBlocking(udpFd_);
+    }
+    freeaddrinfo(result);
+
+    return ok && pipe(wakePipe_) == 0 && setNonBlocking(wakePipe_[0]) && setNonBlocking(wakePipe_[1]);
+}
+
+void MockMumbleServerImpl::populate() {
+    channels_[kRootChannel] = {kRootChannel, kRootChannel, "Root", 0};
+    for (int i = 0; i < config_.channels; i++) {
+        uint32_t id = nextChannelId_++;
+        channels_[id] = {id, kRootChannel, "Channel " + std::to_string(id), static_cast<int32_t>(i)};
+    }
+
+    auto channelFor = [this](int index) -> uint32_t {
+        return config_.channels > 0 ? 1 + static_cast<uint32_t>(index % config_.channels) : kRootChannel;
+    };
+
+    for (int i = 0; i < config_.idleUsers; i++) {
+        uint32_t session = nextSession_++;
+        users_[session] = {session, "Idle " + std::to_string(i + 1), channelFor(i)};
+    }
+
+    // Stagger the talkers so they do not all key up at once
+    int64_t now = nowUs();
+    int64_t cycleUs = static_cast<int64_t>(config_.talkMs + config_.silenceMs) * 1000;
+    for (int i = 0; i < config_.talkers; i++) {
+        uint32_t session = nextSession_++;
+        ServerUser user{session, "Talker " + std::to_string(i + 1), channelFor(i)};
+        user.dutyCycle = true;
+        user.phaseStartUs = now - (cycleUs * i) / std::max(1, config_.talkers);
+        user.packetIndex = (static_cast<size_t>(i) * 37) % talkerPackets_.size();
+        users_[session] = user;
+    }
+}
+
+void MockMumbleServerImpl::encodeTalkerSignal() {
+    Codec::Config codecConfig;
+    auto codec = Codec::createOpus(codecConfig);
+    std::vector<int16_t> speech = bench::makeSpeech(bench::kFrameSize * kTalkerSignalFrames);
+
+    uint8_t packet[4000];
+    talkerPackets_.clear();
+    for (int f = 0; f < kTalkerSignalFrames; f++) {
+        int bytes = codec->encode(speech.data() + f * bench::kFrameSize, bench::kFrameSize,
+                                  packet, sizeof(packet));
+        if (bytes > 0) {
+            talkerPackets_.emplace_back(packet, packet + bytes);
+        }
+    }
+    if (talkerPackets_.empty()) {
+        // Keep talkers functional even without a working encoder
+        talkerPackets_.emplace_back(1, 0);
+    }
+}
+
+// =============================================================================
+// Event loop
+// =============================================================================
+
+void MockMumbleServerImpl::wake() {
+    if (wakePipe_[1] >= 0) {
+        uint8_t byte = 1;
+        (void)!write(wakePipe_[1], &byte, 1);
+    }
+}
+
+int MockMumbleServerImpl::pollTimeoutMs(int64_t now) const {
+    int64_t due = now + kMaxPollMs * 1000;
+    if (!delayed_.empty()) {
+        due = std::min(due, delayed_.top().dueUs);
+    }
+    due = std::min(due, nextTalkerTickUs_);
+    return static_cast<int>(std::max<int64_t>(0, (due - now + 999) / 1000));
+}
+
+void MockMumbleServerImpl::loop() {
+    std::vector<pollfd> fds;
+    std::vector<int> connectionFds;
+
+    while (running_) {
+        fds.clear();
+        connectionFds.clear();
+        int timeoutMs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fds.push_back({wakePipe_[0], POLLIN, 0});
+            fds.push_back({listenFd_, POLLIN, 0});
+            if (udpFd_ >= 0) {
+                fds.push_back({udpFd_, POLLIN, 0});
+            }
+            for (const auto& pair : connections_) {
+                const Connection& connection = *pair.second;
+                short events = POLLIN;
+                if (connection.wantWrite || connection.outPos < connection.out.size()) {
+                    events |= POLLOUT;
+                }
+                fds.push_back({pair.first, events, 0});
+                connectionFds.push_back(pair.first);
+            }
+            timeoutMs = pollTimeoutMs(nowUs());
+        }
+
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fds[0].revents & POLLIN) {
+            uint8_t drain[64];
+            while (read(wakePipe_[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            acceptClients();
+        }
+        size_t first = 2;
+        if (udpFd_ >= 0) {
+            if (fds[2].revents & POLLIN) {
+                receiveUdp();
+            }
+            first = 3;
+        }
+        for (size_t i = 0; i < connectionFds.size(); i++) {
+            const pollfd& pfd = fds[first + i];
+            auto it = connections_.find(pfd.fd);
+            if (it == connections_.end() || pfd.revents == 0) {
+                continue;
+            }
+            if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                it->second->closing = true;
+            } else {
+                // TLS may need either direction for either operation
+                readConnection(*it->second);
+            }
+        }
+
+        int64_t now = nowUs();
+        runTimers(now);
+
+        // Write everything queued this round, then drop dead or idle clients
+        std::vector<int> dead;
+        for (auto& pair : connections_) {
+            Connection& connection = *pair.second;
+            if (!connection.closing) {
+                flushConnection(connection);
+            }
+            bool idle = config_.idleTimeoutMs > 0 &&
+                        now - connection.lastActivityUs > static_cast<int64_t>(config_.idleTimeoutMs) * 1000;
+            bool rejected = connection.closeAfterFlush && connection.outPos >= connection.out.size();
+            if (connection.closing || idle || rejected) {
+                dead.push_back(pair.first);
+            }
+        }
+        for (int fd : dead) {
+            closeConnection(fd);
+        }
+    }
+}
+
+void MockMumbleServerImpl::acceptClients() {
+    while (true) {
+        sockaddr_storage address{};
+        socklen_t length = sizeof(address);
+        int fd = accept(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        if (fd < 0) {
+            return;
+        }
+        setNonBlocking(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // Like Murmur
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->ssl = SSL_new(sslCtx_);
+        SSL_set_fd(connection->ssl, fd);
+        connection->lastActivityUs = nowUs();
+        connection->peerHost = hostOf(addressKey(address));
+        connections_[fd] = std::move(connection);
+    }
+}
+
+void MockMumbleServerImpl::readConnection(Connection& connection) {
+    if (!connection.handshakeDone) {
+        int result = SSL_accept(connection.ssl);
+        if (result != 1) {
+            int error = SSL_get_error(connection.ssl, result);
+            if (error == SSL_ERROR_WANT_READ) {
+                connection.wantWrite = false;
+            } else if (error == SSL_ERROR_WANT_WRITE) {
+                connection.wantWrite = true;
+            } else {
+                connection.closing = true;
+            }
+            return;
+        }
+        connection.handshakeDone = true;
+        connection.wantWrite = false;
+    }
+
+    uint8_t buffer[16384];
+    while (true) {
+        int n = SSL_read(connection.ssl, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection.in.insert(connection.in.end(), buffer, buffer + n);
+            stats_.bytesIn += static_cast<uint64_t>(n);
+            continue;
+        }
+        int error = SSL_get_error(connection.ssl, n);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            connection.wantWrite = true;
+        } else if (error != SSL_ERROR_WANT_READ) {
+            connection.closing = true;
+        }
+        break;
+    }
+
+    // Dispatch every complete message
+    size_t offset = 0;
+    while (!connection.closing && connection.in.size() - offset >= kMessageHeaderSize) {
+        uint16_t type;
+        uint32_t length;
+        readMessageHeader(connection.in.data() + offset, type, length);
+        if (length > kMaxMessageLength) {
+            connection.closing = true;
+            break;
+        }
+        if (connection.in.size() - offset < kMessageHeaderSize + length) {
+            break;
+        }
+        connection.lastActivityUs = nowUs();
+        handleMessage(connection, static_cast<MessageType>(type),
+                      connection.in.data() + offset + kMessageHeaderSize, length);
+        offset += kMessageHeaderSize + length;
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+}
+
+void MockMumbleServerImpl::flushConnection(Connection& connection) {
+    if (!connection.handshakeDone) {
+        if (connection.wantWrite) {
+            readConnection(connection);
+        }
+        return;
+    }
+
+    while (connection.outPos < connection.out.size()) {
+        size_t pending = connection.out.size() - connection.outPos;
+        int n = SSL_write(connection.ssl, connection.out.data() + connection.outPos,
+                          static_cast<int>(std::min<size_t>(pending, INT_MAX)));
+        if (n > 0) {
+            connection.outPos += static_cast<size_t>(n);
+            stats_.bytesOut += static_cast<uint64_t>(n);
+            continue;
+        }
+        int error = SSL_get_error(connection.ssl, n);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            connection.wantWrite = true;
+        } else if (error != SSL_ERROR_WANT_READ) {
+            connection.closing = true;
+        }
+        return;
+    }
+
+    connection.wantWrite = false;
+    connection.out.clear();
+    connection.outPos = 0;
+}
+
+void MockMumbleServerImpl::closeConnection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    std::unique_ptr<Connection> connection = std::move(it->second);
+    connections_.erase(it);
+
+    for (auto peer = udpPeers_.begin(); peer != udpPeers_.end();) {
+        peer = peer->second == connection.get() ? udpPeers_.erase(peer) : std::next(peer);
+    }
+
+    if (connection->session != 0) {
+        users_.erase(connection->session);
+        MumbleProto::UserRemove remove;
+        remove.set_session(connection->session);
+        broadcast(MessageType::UserRemove, remove);
+    }
+
+    SSL_free(connection->ssl);
+    close(fd);
+}
+
+void MockMumbleServerImpl::runTimers(int64_t now) {
+    while (!delayed_.empty() && delayed_.top().dueUs <= now) {
+        const DelayedVoice& voice = delayed_.top();
+        auto user = users_.find(voice.session);
+        if (user != users_.end() && user->second.connection) {
+            sendVoiceNow(*user->second.connection, voice.packet);
+        }
+        delayed_.pop();
+    }
+
+    // Catch up tick by tick so talkers keep their 10ms cadence
+    while (nextTalkerTickUs_ <= now) {
+        tickTalkers(nextTalkerTickUs_);
+        nextTalkerTickUs_ += kFrameUs;
+    }
+}
+
+// =============================================================================
+// Control channel
+// =============================================================================
+
+void MockMumbleServerImpl::queueMessage(Connection& connection, MessageType type,
+                                        const google::protobuf::Message& message) {
+    std::string serialized;
+    if (message.SerializeToString(&serialized)) {
+        queueRaw(connection, type, reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+    }
+}
+
+void MockMumbleServerImpl::queueRaw(Connection& connection, MessageType type,
+                                    const uint8_t* data, size_t length) {
+    uint8_t header[kMessageHeaderSize];
+    writeMessageHeader(header, type, static_cast<uint32_t>(length));
+    connection.out.insert(connection.out.end(), header, header + kMessageHeaderSize);
+    connection.out.insert(connection.out.end(), data, data + length);
+}
+
+void MockMumbleServerImpl::broadcast(MessageType type, const google::protobuf::Message& message,
+                                     uint32_t exceptSession) {
+    std::string serialized;
+    if (!message.SerializeToString(&serialized)) {
+        return;
+    }
+    for (auto& pair : connections_) {
+        Connection& connection = *pair.second;
+        if (connection.session != 0 && connection.session != exceptSession) {
+            queueRaw(connection, type, reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+        }
+    }
+}
+
+void MockMumbleServerImpl::handleMessage(Connection& connection, MessageType type,
+                                         const uint8_t* data, size_t length) {
+    int size = static_cast<int>(length);
+
+    switch (type) {
+        case MessageType::Version:
+            // Any 1.x client is accepted
+            break;
+        case MessageType::Authenticate:
+            handleAuthenticate(connection, data, length);
+            break;
+        case MessageType::Ping:
+            handlePing(connection, data, length);
+            break;
+        case MessageType::UserState:
+            handleUserState(connection, data, length);
+            break;
+        case MessageType::UDPTunnel:
+            if (connection.session != 0) {
+                handleVoice(users_[connection.session], data, length);
+            }
+            break;
+        case MessageType::CryptSetup: {
+            // A resync request: hand out fresh key material, UDP has to re-establish
+            MumbleProto::CryptSetup setup;
+            if (connection.session != 0 && setup.ParseFromArray(data, size)) {
+                sendCryptSetup(connection);
+            }
+            break;
+        }
+        default:
+            // Not modelled - ignore
+            break;
+    }
+}
+
+void MockMumbleServerImpl::reject(Connection& connection, MumbleProto::Reject::RejectType type,
+                                  const std::string& reason) {
+    MumbleProto::Reject message;
+    message.set_type(type);
+    message.set_reason(reason);
+    queueMessage(connection, MessageType::Reject, message);
+    connection.closeAfterFlush = true;
+    stats_.clientsRejected++;
+}
+
+void MockMumbleServerImpl::handleAuthenticate(Connection& connection, const uint8_t* data, size_t length) {
+    MumbleProto::Authenticate auth;
+    if (connection.session != 0 || !auth.ParseFromArray(data, static_cast<int>(length))) {
+        return;
+    }
+
+    size_t connected = 0;
+    bool nameTaken = false;
+    for (const auto& pair : users_) {
+        connected += pair.second.connection ? 1 : 0;
+        nameTaken |= pair.second.name == auth.username();
+    }
+
+    if (auth.username().empty()) {
+        reject(connection, MumbleProto::Reject::InvalidUsername, "Invalid username");
+        return;
+    }
+    if (!config_.password.empty() && auth.password() != config_.password) {
+        reject(connection, MumbleProto::Reject::WrongServerPW, "Wrong server password");
+        return;
+    }
+    if (nameTaken) {
+        reject(connection, MumbleProto::Reject::UsernameInUse, "Username already in use");
+        return;
+    }
+    if (connected >= config_.maxUsers) {
+        reject(connection, MumbleProto::Reject::ServerFull, "Server is full");
+        return;
+    }
+
+    uint32_t session = nextSession_++;
+    ServerUser user{session, auth.username(), kRootChannel};
+    user.connection = &connection;
+    users_[session] = user;
+    connection.session = session;
+    resetImpairment(connection);
+    stats_.clientsAccepted++;
+
+    // Same order as Murmur: crypto, codec, channel tree, users, sync, config
+    sendCryptSetup(connection);
+
+    MumbleProto::CodecVersion codec;
+    codec.set_alpha(static_cast<int32_t>(0x8000000b));
+    codec.set_beta(0);
+    codec.set_prefer_alpha(true);
+    codec.set_opus(true);
+    queueMessage(connection, MessageType::CodecVersion, codec);
+
+    // Channel IDs grow with creation, so parents always come first
+    for (const auto& pair : channels_) {
+        queueMessage(connection, MessageType::ChannelState, channelState(pair.second));
+    }
+    for (const auto& pair : users_) {
+        queueMessage(connection, MessageType::UserState, userState(pair.second));
+    }
+    broadcast(MessageType::UserState, userState(users_[session]), session);
+
+    MumbleProto::ServerSync sync;
+    sync.set_session(session);
+    sync.set_max_bandwidth(config_.maxBandwidth);
+    sync.set_welcome_text(config_.welcomeText);
+    queueMessage(connection, MessageType::ServerSync, sync);
+
+    MumbleProto::ServerConfig serverConfig;
+    serverConfig.set_max_bandwidth(config_.maxBandwidth);
+    serverConfig.set_welcome_text(config_.welcomeText);
+    serverConfig.set_allow_html(true);
+    serverConfig.set_message_length(5000);
+    serverConfig.set_max_users(config_.maxUsers);
+    queueMessage(connection, MessageType::ServerConfig, serverConfig);
+}
+
+void MockMumbleServerImpl::sendCryptSetup(Connection& connection) {
+    uint8_t key[16];
+    uint8_t clientNonce[16];
+    uint8_t serverNonce[16];
+    RAND_bytes(key, sizeof(key));
+    RAND_bytes(clientNonce, sizeof(clientNonce));
+    RAND_bytes(serverNonce, sizeof(serverNonce));
+
+    // The server encrypts with the server nonce and decrypts with the client's
+    connection.crypt.init(key, serverNonce, clientNonce);
+    connection.udpValid = false;
+    for (auto peer = udpPeers_.begin(); peer != udpPeers_.end();) {
+        peer = peer->second == &connection ? udpPeers_.erase(peer) : std::next(peer);
+    }
+
+    MumbleProto::CryptSetup setup;
+    setup.set_key(key, sizeof(key));
+    setup.set_client_nonce(clientNonce, sizeof(clientNonce));
+    setup.set_server_nonce(serverNonce, sizeof(serverNonce));
+    queueMessage(connection, MessageType::CryptSetup, setup);
+}
+
+void MockMumbleServerImpl::handleUserState(Connection& connection, const uint8_t* data, size_t length) {
+    MumbleProto::UserState request;
+    if (connection.session == 0 || !request.ParseFromArray(data, static_cast<int>(length))) {
+        return;
+    }
+    // Only self-service changes; there are no admin rights to edit others
+    if (request.has_session() && request.session() != connection.session) {
+        return;
+    }
+
+    ServerUser& user = users_[connection.session];
+    MumbleProto::UserState change;
+    change.set_session(user.session);
+    change.set_actor(user.session);
+    bool changed = false;
+
+    if (request.has_channel_id() && request.channel_id() != user.channelId &&
+        channels_.count(request.channel_id())) {
+        user.channelId = request.channel_id();
+        change.set_channel_id(user.channelId);
+        changed = true;
+    }
+    if (request.has_self_deaf()) {
+        // Deafening implies muting, undeafening leaves mute as is
+        user.selfDeaf = request.self_deaf();
+        if (user.selfDeaf) {
+            user.selfMute = true;
+        }
+        changed = true;
+    }
+    if (request.has_self_mute()) {
+        // Unmuting also undeafens
+        user.selfMute = request.self_mute();
+        if (!user.selfMute) {
+            user.selfDeaf = false;
+        }
+        changed = true;
+    }
+    if (request.has_self_mute() || request.has_self_deaf()) {
+        change.set_self_mute(user.selfMute);
+        change.set_self_deaf(user.selfDeaf);
+    }
+
+    if (changed) {
+        broadcast(MessageType::UserState, change);
+    }
+}
+
+void MockMumbleServerImpl::handlePing(Connection& connection, const uint8_t* data, size_t length) {
+    MumbleProto::Ping ping;
+    if (!ping.ParseFromArray(data, static_cast<int>(length))) {
+        return;
+    }
+    MumbleProto::Ping reply;
+    reply.set_timestamp(ping.timestamp());
+    // Our decrypt counters for the client's UDP voice, as Murmur reports them
+    CryptState::Stats crypt = connection.crypt.getStats();
+    reply.set_good(crypt.good);
+    reply.set_late(crypt.late);
+    reply.set_lost(crypt.lost);
+    reply.set_resync(0);
+    queueMessage(connection, MessageType::Ping, reply);
+    stats_.pingsAnswered++;
+}
+
+MumbleProto::ChannelState MockMumbleServerImpl::channelState(const ServerChannel& channel) const {
+    MumbleProto::ChannelState state;
+    state.set_channel_id(channel.id);
+    if (channel.id != kRootChannel) {
+        state.set_parent(channel.parentId);
+    }
+    state.set_name(channel.name);
+    state.set_position(channel.position);
+    return state;
+}
+
+MumbleProto::UserState MockMumbleServerImpl::userState(const ServerUser& user) const {
+    MumbleProto::UserState state;
+    state.set_session(user.session);
+    state.set_name(user.name);
+    state.set_channel_id(user.channelId);
+    state.set_self_mute(user.selfMute);
+    state.set_self_deaf(user.selfDeaf);
+    return state;
+}
+
+// =============================================================================
+// Voice
+// =============================================================================
+
+void MockMumbleServerImpl::receiveUdp() {
+    uint8_t buffer[kMaxDatagram];
+    uint8_t plain[kMaxDatagram];
+
+    while (true) {
+        sockaddr_storage from{};
+        socklen_t fromLength = sizeof(from);
+        ssize_t n = recvfrom(udpFd_, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
+        if (n <= 0) {
+            return;
+        }
+        stats_.bytesIn += static_cast<uint64_t>(n);
+        size_t length = static_cast<size_t>(n);
+
+        std::string key = addressKey(from);
+        auto peer = udpPeers_.find(key);
+        Connection* connection = peer != udpPeers_.end() ? peer->second : nullptr;
+
+        if (!connection) {
+            // Murmur's unencrypted connect ping: 4 zero bytes + 8 byte ident
+            if (length == 12 && std::memcmp(buffer, "\0\0\0\0", 4) == 0) {
+                uint8_t reply[24];
+                size_t connected = 0;
+                for (const auto& pair : users_) {
+                    connected += pair.second.connection ? 1 : 0;
+                }
+                writeBigEndian32(reply, MUMBLE_VERSION);
+                std::memcpy(reply + 4, buffer + 4, 8);
+                writeBigEndian32(reply + 12, static_cast<uint32_t>(connected));
+                writeBigEndian32(reply + 16, config_.maxUsers);
+                writeBigEndian32(reply + 20, config_.maxBandwidth);
+                sendto(udpFd_, reply, sizeof(reply), 0, reinterpret_cast<sockaddr*>(&from), fromLength);
+                stats_.bytesOut += sizeof(reply);
+                stats_.pingsAnswered++;
+                continue;
+            }
+            // UdpPing's reachability probe is echoed as is
+            if (length == 9 && buffer[0] == 0x20) {
+                sendto(udpFd_, buffer, length, 0, reinterpret_cast<sockaddr*>(&from), fromLength);
+                stats_.bytesOut += length;
+                stats_.pingsAnswered++;
+                continue;
+            }
+
+            // First packet from this address: find the client whose key opens it
+            std::string host = hostOf(key);
+            for (auto& pair : connections_) {
+                Connection& candidate = *pair.second;
+                if (candidate.session != 0 && !candidate.udpValid && candidate.crypt.isValid() &&
+                    candidate.peerHost == host && length > 4 &&
+                    candidate.crypt.decrypt(buffer, plain, length)) {
+                    connection = &candidate;
+                    break;
+                }
+            }
+            if (!connection) {
+                stats_.udpDecryptFailures++;
+                continue;
+            }
+            connection->udpValid = true;
+            connection->udpAddress = from;
+            connection->udpAddressLength = fromLength;
+            udpPeers_[key] = connection;
+        } else if (length <= 4 || !connection->crypt.decrypt(buffer, plain, length)) {
+            stats_.udpDecryptFailures++;
+            continue;
+        }
+
+        connection->lastActivityUs = nowUs();
+        size_t plainLength = length - 4;
+        if (plainLength >= 1 && voiceType(plain[0]) == UdpMessageType::Ping) {
+            // Encrypted UDP ping: the payload comes back unchanged
+            sendUdp(*connection, plain, plainLength);
+            stats_.pingsAnswered++;
+            continue;
+        }
+        handleVoice(users_[connection->session], plain, plainLength);
+    }
+}
+
+void MockMumbleServerImpl::handleVoice(ServerUser& sender, const uint8_t* data, size_t length) {
+    if (length < 2) {
+        return;
+    }
+    stats_.voicePacketsIn++;
+
+    uint8_t header = data[0];
+    uint8_t target = voiceTarget(header);
+    if (voiceType(header) == UdpMessageType::Ping || sender.selfMute) {
+        return;
+    }
+    // Whisper targets are not modelled
+    if (target != kVoiceTargetNormal && target != kVoiceTargetLoopback) {
+        return;
+    }
+
+    // Client form: header, sequence, payload. Server form inserts the session.
+    std::vector<uint8_t> packet;
+    packet.reserve(length + 5);
+    uint8_t session[9];
+    size_t sessionLength = writeVarint(session, sender.session);
+    packet.push_back(voiceHeader(voiceType(header), kVoiceTargetNormal));
+    packet.insert(packet.end(), session, session + sessionLength);
+    packet.insert(packet.end(), data + 1, data + length);
+
+    if (target == kVoiceTargetLoopback) {
+        if (sender.connection) {
+            deliverVoice(*sender.connection, packet, nowUs());
+        }
+        return;
+    }
+    routeVoice(sender, packet, echo_);
+}
+
+void MockMumbleServerImpl::routeVoice(const ServerUser& sender, const std::vector<uint8_t>& packet,
+                                      bool toSender) {
+    int64_t now = nowUs();
+    for (auto& pair : users_) {
+        ServerUser& user = pair.second;
+        if (!user.connection || user.selfDeaf) {
+            continue;
+        }
+        bool isSender = user.session == sender.session;
+        if ((isSender && toSender) || (!isSender && user.channelId == sender.channelId)) {
+            deliverVoice(*user.connection, packet, now);
+        }
+    }
+}
+
+void MockMumbleServerImpl::deliverVoice(Connection& connection, const std::vector<uint8_t>& packet,
+                                        int64_t now) {
+    if (!impairVoice_ || !connection.impairment) {
+        sendVoiceNow(connection, packet);
+        return;
+    }
+
+    std::vector<double> arrivals;
+    double nowMs = now / 1000.0;
+    connection.impairment->transmit(nowMs, arrivals);
+    if (arrivals.empty()) {
+        stats_.voicePacketsDropped++;
+        return;
+    }
+    for (double arrivalMs : arrivals) {
+        delayed_.push({static_cast<int64_t>(arrivalMs * 1000.0), delayedOrder_++, connection.session, packet});
+    }
+}
+
+void MockMumbleServerImpl::sendVoiceNow(Connection& connection, const std::vector<uint8_t>& packet) {
+    stats_.voicePacketsOut++;
+    if (sendUdp(connection, packet.data(), packet.size())) {
+        return;
+    }
+
+    // No UDP path yet: tunnel through the control channel
+    stats_.voicePacketsTunnelled++;
+    queueRaw(connection, MessageType::UDPTunnel, packet.data(), packet.size());
+}
+
+bool MockMumbleServerImpl::sendUdp(Connection& connection, const uint8_t* data, size_t length) {
+    if (!connection.udpValid || udpFd_ < 0 || length > kMaxDatagram) {
+        return false;
+    }
+    uint8_t encrypted[kMaxDatagram + 4];
+    if (!connection.crypt.encrypt(data, encrypted, length)) {
+        return false;
+    }
+    sendto(udpFd_, encrypted, length + 4, 0,
+           reinterpret_cast<const sockaddr*>(&connection.udpAddress), connection.udpAddressLength);
+    stats_.bytesOut += length + 4;
+    return true;
+}
+
+void MockMumbleServerImpl::tickTalkers(int64_t now) {
+    int64_t talkUs = static_cast<int64_t>(config_.talkMs) * 1000;
+    int64_t cycleUs = talkUs + static_cast<int64_t>(config_.silenceMs) * 1000;
+
+    std::vector<uint8_t> packet;
+    for (auto& pair : users_) {
+        ServerUser& user = pair.second;
+        if (user.connection) {
+            continue;
+        }
+
+        bool talking;
+        bool last;
+        if (user.dutyCycle) {
+            int64_t phase = cycleUs > 0 ? (now - user.phaseStartUs) % cycleUs : 0;
+            talking = phase < talkUs;
+            last = phase + kFrameUs >= talkUs;
+        } else {
+            // Manual talkers end with one terminator frame after setTalking(false)
+            talking = user.talking || user.inTransmission;
+            last = !user.talking;
+        }
+        if (!talking) {
+            continue;
+        }
+        user.inTransmission = !last;
+
+        const std::vector<uint8_t>& opus = talkerPackets_[user.packetIndex];
+        user.packetIndex = (user.packetIndex + 1) % talkerPackets_.size();
+
+        uint8_t varint[9];
+        packet.clear();
+        packet.push_back(voiceHeader(UdpMessageType::Opus, kVoiceTargetNormal));
+        packet.insert(packet.end(), varint, varint + writeVarint(varint, user.session));
+        packet.insert(packet.end(), varint, varint + writeVarint(varint, user.sequence++));
+        uint64_t size = opus.size() | (last ? kOpusTerminator : 0);
+        packet.insert(packet.end(), varint, varint + writeVarint(varint, size));
+        packet.insert(packet.end(), opus.begin(), opus.end());
+
+        routeVoice(user, packet, false);
+    }
+}
+
+void MockMumbleServerImpl::resetImpairment(Connection& connection) {
+    bench::NetworkImpairment::Config network = network_;
+    network.seed += connection.session;   // Independent but reproducible per client
+    connection.impairment = std::make_unique<bench::NetworkImpairment>(network);
+}
+
+// =============================================================================
+// Scripting
+// =============================================================================
+
+MockMumbleServer::Stats MockMumbleServerImpl::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.clientsConnected = 0;
+    for (const auto& pair : connections_) {
+        stats.clientsConnected += pair.second->session != 0 ? 1 : 0;
+    }
+    return stats;
+}
+
+uint32_t MockMumbleServerImpl::addChannel(const std::string& name, uint32_t parentId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!channels_.count(parentId)) {
+        parentId = kRootChannel;
+    }
+    uint32_t id = nextChannelId_++;
+    ServerChannel& channel = channels_[id];
+    channel = {id, parentId, name, static_cast<int32_t>(id)};
+    broadcast(MessageType::ChannelState, channelState(channel));
+    wake();
+    return id;
+}
+
+uint32_t MockMumbleServerImpl::addUser(const std::string& name, uint32_t channelId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!channels_.count(channelId)) {
+        channelId = kRootChannel;
+    }
+    uint32_t session = nextSession_++;
+    ServerUser& user = users_[session];
+    user = {session, name, channelId};
+    user.packetIndex = (session * 37) % talkerPackets_.size();
+    broadcast(MessageType::UserState, userState(user));
+    wake();
+    return session;
+}
+
+void MockMumbleServerImpl::setTalking(uint32_t session, bool talking) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = users_.find(session);
+    if (it == users_.end() || it->second.connection) {
+        return;
+    }
+    ServerUser& user = it->second;
+    if (user.dutyCycle) {
+        // Manual control takes over; stopping still sends a terminator
+        user.dutyCycle = false;
+        user.inTransmission = true;
+    }
+    user.talking = talking;
+}
+
+void MockMumbleServerImpl::setEcho(bool echo) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    echo_ = echo;
+}
+
+void MockMumbleServerImpl::setImpairment(bool enabled, const bench::NetworkImpairment::Config& network) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    impairVoice_ = enabled;
+    network_ = network;
+    for (auto& pair : connections_) {
+        if (pair.second->session != 0) {
+            resetImpairment(*pair.second);
+        }
+    }
+}
+
+}  // namespace sayses
@@ -0,0 +1,123 @@
+/**
+ * Mock Mumble Server
+ * Small in-process Murmur stand-in for integration and performance tests
+ */
+
+#pragma once
+
+#include "network_impairment.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sayses {
+
+/**
+ * Speaks enough of the Mumble 1.3 protocol to drive MumbleClient end to end:
+ * - TLS control channel: Version, Authenticate, CryptSetup, CodecVersion,
+ *   ChannelState, UserState, ServerSync, ServerConfig, Ping, UserRemove
+ * - Voice over UDP (CryptState) or tunnelled through UDPTunnel, routed to
+ *   the other users of the sender's channel
+ * - Connect pings (Murmur's 12-byte form and UdpPing's 0x20 probe)
+ *
+ * The server is scriptable: it can populate a channel tree and idle users,
+ * run synthetic talkers, delay/drop outgoing voice through
+ * NetworkImpairment and echo voice back to its sender.
+ *
+ * Everything runs on one event-loop thread. The scripting methods may be
+ * called from any thread while the server is running.
+ */
+class MockMumbleServer {
+public:
+    struct Config {
+        std::string host = "127.0.0.1";
+        int port = 0;                      // TCP and UDP, 0 = pick a free port
+        std::string certificatePath;       // PEM; empty = generate a self-signed certificate
+        std::string privateKeyPath;
+        std::string password;              // Empty = no server password
+        std::string welcomeText = "SAYses mock server";
+        uint32_t maxUsers = 1000;
+        uint32_t maxBandwidth = 72000;
+
+        // Initial population
+        int channels = 4;                  // Below the root channel
+        int idleUsers = 0;                 // Synthetic users spread over the channels
+        int talkers = 0;                   // Synthetic users that talk
+        int talkMs = 2000;                 // Talker duty cycle
+        int silenceMs = 1000;
+
+        bool udp = true;                   // Accept UDP voice (else everything is tunnelled)
+        bool echo = false;                 // Also send each voice packet back to its sender
+        int idleTimeoutMs = 30000;         // Drop clients that stay silent this long
+
+        bool impairVoice = false;          // Apply `network` to voice sent to clients
+        bench::NetworkImpairment::Config network;
+    };
+
+    struct Stats {
+        uint32_t clientsConnected = 0;
+        uint64_t clientsAccepted = 0;
+        uint64_t clientsRejected = 0;
+        uint64_t voicePacketsIn = 0;       // From clients, UDP and tunnel
+        uint64_t voicePacketsTunnelled = 0;
+        uint64_t voicePacketsOut = 0;      // To clients after impairment
+        uint64_t voicePacketsDropped = 0;  // Lost to impairment
+        uint64_t udpDecryptFailures = 0;
+        uint64_t pingsAnswered = 0;        // TCP and UDP
+        uint64_t bytesIn = 0;              // TCP payload and UDP datagrams
+        uint64_t bytesOut = 0;
+    };
+
+    static std::unique_ptr<MockMumbleServer> create(const Config& config);
+
+    virtual ~MockMumbleServer() = default;
+
+    /**
+     * Bind, populate the initial channels/users and start the event loop.
+     * @return false if the sockets or TLS context could not be set up
+     */
+    virtual bool start() = 0;
+
+    /**
+     * Disconnect everyone and stop the event loop.
+     */
+    virtual void stop() = 0;
+
+    /**
+     * Port actually bound (useful with Config::port = 0).
+     */
+    virtual int getPort() const = 0;
+
+    virtual Stats getStats() const = 0;
+
+    /**
+     * Add a channel and announce it to connected clients.
+     * @return The new channel ID
+     */
+    virtual uint32_t addChannel(const std::string& name, uint32_t parentId = 0) = 0;
+
+    /**
+     * Add a synthetic user (no connection) and announce it.
+     * @return The user's session ID
+     */
+    virtual uint32_t addUser(const std::string& name, uint32_t channelId) = 0;
+
+    /**
+     * Start or stop a synthetic user's transmission. Talkers created from
+     * Config::talkers follow their duty cycle instead.
+     */
+    virtual void setTalking(uint32_t session, bool talking) = 0;
+
+    virtual void setEcho(bool echo) = 0;
+
+    /**
+     * Replace the voice impairment. Applies to packets sent from now on.
+     */
+    virtual void setImpairment(bool enabled, const bench::NetworkImpairment::Config& network) = 0;
+
+protected:
+    MockMumbleServer() = default;
+};
+
+}  // namespace sayses
@@ -0,0 +1,204 @@
+/**
+ * Mock Mumble Server CLI
+ * Runs MockMumbleServer standalone, e.g. as the target of SaysesLoadGen or
+ * a desktop Mumble client.
+ *
+ * Usage: SaysesMockServer [--key=value ...], see printUsage().
+ */
+
+#include "mock_mumble_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> gStop{false};
+
+void onSignal(int) {
+    gStop = true;
+}
+
+struct Options {
+    sayses::MockMumbleServer::Config server;
+    int seconds = 0;          // 0 = until interrupted
+    int statsInterval = 5;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: SaysesMockServer [options]\n"
+        "  --host=ADDR             Bind address (default 127.0.0.1)\n"
+        "  --port=N                TCP/UDP port, 0 = any (default 64738)\n"
+        "  --cert=PEM --key=PEM    Server certificate (default: self-signed)\n"
+        "  --password=PW           Server password\n"
+        "  --max-users=N           Reject beyond N clients (default 1000)\n"
+        "  --channels=N            Channels below Root (default 4)\n"
+        "  --idle-users=N          Synthetic idle users (default 0)\n"
+        "  --talkers=N             Synthetic talkers (default 0)\n"
+        "  --talk-ms=N --silence-ms=N  Talker duty cycle (default 2000/1000)\n"
+        "  --echo                  Send voice back to its sender too\n"
+        "  --no-udp                Tunnel all voice over TCP\n"
+        "  --idle-timeout-ms=N     Drop silent clients (default 30000, 0 = never)\n"
+        "  --seed=N --delay-ms=X --jitter=none|uniform|normal|pareto --jitter-ms=X\n"
+        "  --burst-p=X --burst-r=X --loss-good=X --loss-bad=X\n"
+        "  --reorder=X --reorder-ms=X --duplicate=X\n"
+        "                          Impair voice sent to clients (any of these enables it)\n"
+        "  --seconds=N             Exit after N seconds (default: run until Ctrl-C)\n"
+        "  --stats-interval=N      Print counters every N seconds (default 5, 0 = off)\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    auto& s = options.server;
+    auto& n = s.network;
+    s.port = 64738;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--", 2) != 0) {
+            return false;
+        }
+        const char* eq = std::strchr(arg, '=');
+        std::string key = eq ? std::string(arg + 2, eq) : std::string(arg + 2);
+        const char* value = eq ? eq + 1 : "";
+
+        if (key == "echo") {
+            s.echo = true;
+        } else if (key == "no-udp") {
+            s.udp = false;
+        } else if (!eq) {
+            return false;
+        } else if (key == "host") {
+            s.host = value;
+        } else if (key == "port") {
+            s.port = std::atoi(value);
+        } else if (key == "cert") {
+            s.certificatePath = value;
+        } else if (key == "key") {
+            s.privateKeyPath = value;
+        } else if (key == "password") {
+            s.password = value;
+        } else if (key == "max-users") {
+            s.maxUsers = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (key == "channels") {
+            s.channels = std::atoi(value);
+        } else if (key == "idle-users") {
+            s.idleUsers = std::atoi(value);
+        } else if (key == "talkers") {
+            s.talkers = std::atoi(value);
+        } else if (key == "talk-ms") {
+            s.talkMs = std::atoi(value);
+        } else if (key == "silence-ms") {
+            s.silenceMs = std::atoi(value);
+        } else if (key == "idle-timeout-ms") {
+            s.idleTimeoutMs = std::atoi(value);
+        } else if (key == "seconds") {
+            options.seconds = std::atoi(value);
+        } else if (key == "stats-interval") {
+            options.statsInterval = std::atoi(value);
+        } else {
+            // Everything else configures the voice impairment
+            s.impairVoice = true;
+            if (key == "seed") {
+                n.seed = std::strtoull(value, nullptr, 10);
+            } else if (key == "delay-ms") {
+                n.baseDelayMs = std::atof(value);
+            } else if (key == "jitter") {
+                using Jitter = sayses::bench::NetworkImpairment::Jitter;
+                if (std::strcmp(value, "none") == 0) {
+                    n.jitter = Jitter::None;
+                } else if (std::strcmp(value, "uniform") == 0) {
+                    n.jitter = Jitter::Uniform;
+                } else if (std::strcmp(value, "normal") == 0) {
+                    n.jitter = Jitter::Normal;
+                } else if (std::strcmp(value, "pareto") == 0) {
+                    n.jitter = Jitter::Pareto;
+                } else {
+                    return false;
+                }
+            } else if (key == "jitter-ms") {
+                n.jitterMs = std::atof(value);
+            } else if (key == "burst-p") {
+                n.burstP = std::atof(value);
+            } else if (key == "burst-r") {
+                n.burstR = std::atof(value);
+            } else if (key == "loss-good") {
+                n.lossGood = std::atof(value);
+            } else if (key == "loss-bad") {
+                n.lossBad = std::atof(value);
+            } else if (key == "reorder") {
+                n.reorderProbability = std::atof(value);
+            } else if (key == "reorder-ms") {
+                n.reorderDelayMs = std::atof(value);
+            } else if (key == "duplicate") {
+                n.duplicateProbability = std::atof(value);
+            } else {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void printStats(const sayses::MockMumbleServer::Stats& stats) {
+    std::printf("clients %u (accepted %llu, rejected %llu) | voice in %llu out %llu tunnelled %llu "
+                "dropped %llu | pings %llu | udp auth failures %llu | kB in %.1f out %.1f\n",
+                stats.clientsConnected,
+                static_cast<unsigned long long>(stats.clientsAccepted),
+                static_cast<unsigned long long>(stats.clientsRejected),
+                static_cast<unsigned long long>(stats.voicePacketsIn),
+                static_cast<unsigned long long>(stats.voicePacketsOut),
+                static_cast<unsigned long long>(stats.voicePacketsTunnelled),
+                static_cast<unsigned long long>(stats.voicePacketsDropped),
+                static_cast<unsigned long long>(stats.pingsAnswered),
+                static_cast<unsigned long long>(stats.udpDecryptFailures),
+                stats.bytesIn / 1024.0, stats.bytesOut / 1024.0);
+    std::fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    auto server = sayses::MockMumbleServer::create(options.server);
+    if (!server->start()) {
+        std::fprintf(stderr, "Cannot start the server on %s:%d\n",
+                     options.server.host.c_str(), options.server.port);
+        return 1;
+    }
+    std::printf("Mock Mumble server listening on %s:%d\n", options.server.host.c_str(), server->getPort());
+    std::fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastStats = start;
+    while (!gStop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+
+        if (options.statsInterval > 0 && now - lastStats >= std::chrono::seconds(options.statsInterval)) {
+            printStats(server->getStats());
+            lastStats = now;
+        }
+        if (options.seconds > 0 && now - start >= std::chrono::seconds(options.seconds)) {
+            break;
+        }
+    }
+
+    printStats(server->getStats());
+    server->stop();
+    return 0;
+}
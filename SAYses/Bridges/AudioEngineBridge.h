@@ -9,6 +9,7 @@ NS_ASSUME_NONNULL_BEGIN
 @interface AudioEngineBridge : NSObject
 
 typedef void (^AudioCaptureCallback)(const int16_t *data, size_t frames);
+typedef void (^AudioFloatCaptureCallback)(const float *data, size_t frames);
 typedef size_t (^AudioPlaybackCallback)(int16_t *data, size_t frames);
 
 @property (nonatomic, readonly) BOOL isCapturing;
@@ -22,6 +23,8 @@ typedef size_t (^AudioPlaybackCallback)(int16_t *data, size_t frames);
 
 // Capture
 - (BOOL)startCaptureWithCallback:(AudioCaptureCallback)callback;
+/// Capture as float (full scale +/-1.0), skipping the int16 conversion before the encoder
+- (BOOL)startFloatCaptureWithCallback:(AudioFloatCaptureCallback)callback;
 - (void)stopCapture;
 
 // Playback
@@ -44,18 +47,43 @@ typedef size_t (^AudioPlaybackCallback)(int16_t *data, size_t frames);
               frames:(size_t)frames
             sequence:(int64_t)sequence;
 
+/// Add decoded float audio for a user (full scale +/-1.0, no int16 quantization)
+/// @param userId User/session ID
+/// @param samples Decoded float samples
+/// @param frames Number of samples
+/// @param sequence Packet sequence number for jitter buffer
+- (void)addUserAudio:(uint32_t)userId
+        floatSamples:(const float *)samples
+              frames:(size_t)frames
+            sequence:(int64_t)sequence;
+
 /// Remove user's audio buffer
 - (void)removeUser:(uint32_t)userId;
 
 /// Notify that user stopped talking (triggers crossfade)
 - (void)notifyUserTalkingEnded:(uint32_t)userId;
 
+/// Set a user's local playback gain (1.0 = unchanged, max 4.0)
+- (void)setUserVolume:(uint32_t)userId gain:(float)gain;
+
+/// Locally mute/unmute a user (muted audio is discarded, not mixed)
+- (void)setUserMuted:(uint32_t)userId muted:(BOOL)muted;
+
+/// Mark a user as priority speaker (ducks everyone else while talking)
+- (void)setUserPrioritySpeaker:(uint32_t)userId priority:(BOOL)priority;
+
+/// Set the gain for other users while a priority speaker talks (0.0 - 1.0)
+- (void)setPriorityDuckingLevel:(float)gain;
+
 /// Start playback using internal user mixing (no callback needed)
 - (BOOL)startMixedPlayback;
 
 /// Get playback callback invocation count (for liveness detection)
 @property (nonatomic, readonly) uint64_t playbackCallbackCount;
 
+/// Captured frames dropped because the capture callback fell behind
+@property (nonatomic, readonly) uint64_t captureDroppedFrames;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -5,6 +5,7 @@
 @implementation AudioEngineBridge {
     std::unique_ptr<sayses::AudioEngine> _engine;
     AudioCaptureCallback _captureCallback;
+    AudioFloatCaptureCallback _floatCaptureCallback;
     AudioPlaybackCallback _playbackCallback;
 }
 
@@ -67,11 +68,33 @@
     return result;
 }
 
+- (BOOL)startFloatCaptureWithCallback:(AudioFloatCaptureCallback)callback {
+    NSLog(@"[AudioEngineBridge] startFloatCapture called, engine=%p", _engine.get());
+
+    if (!_engine) {
+        NSLog(@"[AudioEngineBridge] ERROR: No engine!");
+        return NO;
+    }
+
+    _floatCaptureCallback = [callback copy];
+
+    BOOL result = _engine->startCapture([self](const float* data, size_t frames,
+                                               const sayses::AudioEngine::CaptureTimestamp&) {
+        if (_floatCaptureCallback) {
+            _floatCaptureCallback(data, frames);
+        }
+    });
+
+    NSLog(@"[AudioEngineBridge] startFloatCapture result=%d", result);
+    return result;
+}
+
 - (void)stopCapture {
     if (_engine) {
         _engine->stopCapture();
     }
     _captureCallback = nil;
+    _floatCaptureCallback = nil;
 }
 
 - (BOOL)startPlaybackWithCallback:(AudioPlaybackCallback)callback {
@@ -115,6 +138,15 @@
     }
 }
 
+- (void)addUserAudio:(uint32_t)userId
+        floatSamples:(const float *)samples
+              frames:(size_t)frames
+            sequence:(int64_t)sequence {
+    if (_engine) {
+        _engine->addUserAudio(userId, samples, frames, sequence);
+    }
+}
+
 - (void)removeUser:(uint32_t)userId {
     if (_engine) {
         _engine->removeUser(userId);
@@ -127,6 +159,30 @@
     }
 }
 
+- (void)setUserVolume:(uint32_t)userId gain:(float)gain {
+    if (_engine) {
+        _engine->setUserVolume(userId, gain);
+    }
+}
+
+- (void)setUserMuted:(uint32_t)userId muted:(BOOL)muted {
+    if (_engine) {
+        _engine->setUserMuted(userId, muted);
+    }
+}
+
+- (void)setUserPrioritySpeaker:(uint32_t)userId priority:(BOOL)priority {
+    if (_engine) {
+        _engine->setUserPrioritySpeaker(userId, priority);
+    }
+}
+
+- (void)setPriorityDuckingLevel:(float)gain {
+    if (_engine) {
+        _engine->setPriorityDuckingLevel(gain);
+    }
+}
+
 - (BOOL)startMixedPlayback {
     if (!_engine) return NO;
     return _engine->startMixedPlayback();
@@ -136,4 +192,8 @@
     return _engine ? _engine->getPlaybackCallbackCount() : 0;
 }
 
+- (uint64_t)captureDroppedFrames {
+    return _engine ? _engine->getCaptureDroppedFrames() : 0;
+}
+
 @end
@@ -35,13 +35,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 /// Add PCM samples to internal buffer and encode when 480 samples are available
 /// iOS AudioUnit may deliver variable frame counts (512, 1024, etc.)
-/// This method buffers samples and encodes in 480-sample chunks
+/// This method buffers samples, encodes in 480-sample chunks and merges
+/// framesPerPacket chunks into one Opus packet
 /// @param pcmData PCM samples (16-bit signed integers)
 /// @param frameCount Number of samples (can be any size)
-/// @param callback Called for each encoded 480-sample chunk
+/// @param callback Called for each packet with the 10ms frames it holds
+///                 (advance the voice sequence number by that many)
 - (void)addSamplesAndEncode:(const int16_t *)pcmData
                  frameCount:(int)frameCount
-                   callback:(void (^)(NSData *encodedData))callback;
+                   callback:(void (^)(NSData *encodedData, int packetFrames))callback;
+
+/// Float variant of addSamplesAndEncode (full scale +/-1.0)
+/// Feeds the encoder without an int16 round trip; use with AudioEngine's float capture
+/// @param pcmData PCM samples (float)
+/// @param frameCount Number of samples (can be any size)
+/// @param callback Called for each packet with the 10ms frames it holds
+- (void)addFloatSamplesAndEncode:(const float *)pcmData
+                      frameCount:(int)frameCount
+                        callback:(void (^)(NSData *encodedData, int packetFrames))callback;
+
+/// Send the frames still waiting for a full packet (end of transmission)
+/// @param callback Called once if frames were pending
+- (void)flushPacket:(void (^)(NSData *encodedData, int packetFrames))callback;
 
 /// Decode Opus to PCM audio
 /// @param opusData Encoded Opus data
@@ -59,6 +74,33 @@ NS_ASSUME_NONNULL_BEGIN
 - (int)decodePLCWithOutputBuffer:(int16_t *)outputBuffer
                        maxFrames:(int)maxFrames;
 
+/// Decode Opus to float PCM (full scale +/-1.0), for AudioEngine's float user audio
+/// @param opusData Encoded Opus data
+/// @param outputBuffer Buffer for decoded float samples
+/// @param maxFrames Maximum frames to decode
+/// @return Number of decoded frames, or -1 on error
+- (int)decodeWithOpusData:(NSData *)opusData
+        floatOutputBuffer:(float *)outputBuffer
+                maxFrames:(int)maxFrames;
+
+/// Float variant of decodePLCWithOutputBuffer
+/// @param outputBuffer Buffer for generated float samples
+/// @param maxFrames Maximum frames to generate
+/// @return Number of generated frames, or -1 on error
+- (int)decodePLCWithFloatOutputBuffer:(float *)outputBuffer
+                            maxFrames:(int)maxFrames;
+
+/// Adapt encoder bitrate, FEC and frames per packet to the link and the server's bandwidth limit
+/// Call on each ping reply, always from the same thread; decisions are made
+/// at most every few seconds, a changed limit or transport applies at once
+/// @param rttMs Latest round-trip time in milliseconds (0 if unknown)
+/// @param maxBandwidth Server limit in bps including packet overhead (0 = unlimited)
+/// @param tcpTunnel YES if voice is sent through the TCP tunnel
+/// @return YES if the encoder settings changed
+- (BOOL)updateLinkWithRTT:(float)rttMs
+             maxBandwidth:(uint32_t)maxBandwidth
+                tcpTunnel:(BOOL)tcpTunnel;
+
 /// Reset encoder and decoder state
 - (void)reset;
 
@@ -71,6 +113,9 @@ NS_ASSUME_NONNULL_BEGIN
 /// Sample rate (48000)
 @property (nonatomic, readonly) int sampleRate;
 
+/// 10ms frames merged into each packet (1, 2, 4 or 6), chosen by updateLinkWithRTT
+@property (nonatomic, readonly) int framesPerPacket;
+
 @end
 
 NS_ASSUME_NONNULL_END
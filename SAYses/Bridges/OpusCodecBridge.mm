@@ -7,16 +7,25 @@
 
 #import "OpusCodecBridge.h"
 #include "codec.h"
+#include "encoder_controller.h"
+#include "opus_packetizer.h"
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <algorithm>
+#include <chrono>
 
 @implementation OpusCodecBridge {
     std::unique_ptr<sayses::Codec> _codec;
+    std::unique_ptr<sayses::EncoderController> _controller;  // Link adaptation, see updateLinkWithRTT
+    std::unique_ptr<sayses::OpusPacketizer> _packetizer;     // Merges frames per packet (under _bufferMutex)
+    std::vector<uint8_t> _packetBuffer;                      // Completed packet (preallocated)
     int _frameSize;
     int _sampleRate;
-    std::vector<int16_t> _sampleBuffer;  // Buffer for accumulating samples
-    std::mutex _bufferMutex;  // Protects _sampleBuffer from concurrent access (IO thread + main thread)
+    std::vector<float> _frameBuffer;    // Partial frame carried between calls (one frame, preallocated)
+    size_t _frameFill;                  // Samples currently staged in _frameBuffer
+    std::vector<float> _convertBuffer;  // int16 input converted for the float encoder (preallocated)
+    std::mutex _bufferMutex;  // Protects _frameBuffer from concurrent access (IO thread + main thread)
 }
 
 - (instancetype)init {
@@ -30,6 +39,9 @@
     if (self) {
         _sampleRate = sampleRate;
         _frameSize = sampleRate / 100;  // 10ms frame = sampleRate / 100
+        _frameBuffer.resize(_frameSize);
+        _frameFill = 0;
+        _convertBuffer.resize(_frameSize);
 
         sayses::Codec::Config config;
         config.sampleRate = sampleRate;
@@ -44,6 +56,14 @@
             _codec = sayses::Codec::createOpus(config);
             NSLog(@"[OpusCodecBridge] Created: sampleRate=%d, channels=%d, bitrate=%d, frameSize=%d",
                   sampleRate, channels, bitrate, _frameSize);
+
+            sayses::EncoderController::Config controllerConfig;
+            controllerConfig.maxBitrate = bitrate;
+            controllerConfig.minBitrate = std::min(controllerConfig.minBitrate, bitrate);
+            controllerConfig.frameDurationUs = static_cast<int>(int64_t{_frameSize} * 1000000 / sampleRate);
+            _controller = sayses::EncoderController::create(controllerConfig);
+            _packetizer = sayses::OpusPacketizer::create();
+            _packetBuffer.resize(sayses::OpusPacketizer::kMaxPacketBytes);
         } catch (const std::exception& e) {
             NSLog(@"[OpusCodecBridge] ERROR: Failed to create codec: %s", e.what());
             return nil;
@@ -81,32 +101,102 @@
 
 - (void)addSamplesAndEncode:(const int16_t *)pcmData
                  frameCount:(int)frameCount
-                   callback:(void (^)(NSData *encodedData))callback {
+                   callback:(void (^)(NSData *encodedData, int packetFrames))callback {
     if (!_codec || !pcmData || frameCount <= 0 || !callback) {
         return;
     }
 
     std::lock_guard<std::mutex> lock(_bufferMutex);
 
-    // Add samples to buffer
-    _sampleBuffer.insert(_sampleBuffer.end(), pcmData, pcmData + frameCount);
+    // Convert in frame-sized chunks so the scratch buffer never grows
+    constexpr float kScale = 1.0f / 32768.0f;
+    const size_t count = static_cast<size_t>(frameCount);
+    for (size_t offset = 0; offset < count; offset += _convertBuffer.size()) {
+        size_t chunk = std::min(_convertBuffer.size(), count - offset);
+        for (size_t i = 0; i < chunk; ++i) {
+            _convertBuffer[i] = pcmData[offset + i] * kScale;
+        }
+        [self stageSamples:_convertBuffer.data() count:chunk callback:callback];
+    }
+}
+
+- (void)addFloatSamplesAndEncode:(const float *)pcmData
+                      frameCount:(int)frameCount
+                        callback:(void (^)(NSData *encodedData, int packetFrames))callback {
+    if (!_codec || !pcmData || frameCount <= 0 || !callback) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    [self stageSamples:pcmData count:static_cast<size_t>(frameCount) callback:callback];
+}
 
-    // Encode in chunks of _frameSize (480 samples)
-    while (_sampleBuffer.size() >= static_cast<size_t>(_frameSize)) {
-        constexpr size_t kMaxPacketSize = 4000;
-        uint8_t outputBuffer[kMaxPacketSize];
+/// Encode whole frames from pcmData, staging the remainder (caller holds _bufferMutex)
+- (void)stageSamples:(const float *)pcmData
+               count:(size_t)count
+            callback:(void (^)(NSData *encodedData, int packetFrames))callback {
 
-        int encodedBytes = _codec->encode(_sampleBuffer.data(), _frameSize, outputBuffer, kMaxPacketSize);
+    const size_t frameSize = static_cast<size_t>(_frameSize);
+    size_t offset = 0;
 
-        // Remove encoded samples from buffer
-        _sampleBuffer.erase(_sampleBuffer.begin(), _sampleBuffer.begin() + _frameSize);
+    // Complete a partial frame from the previous call first
+    if (_frameFill > 0) {
+        size_t copyFrames = std::min(count, frameSize - _frameFill);
+        std::copy(pcmData, pcmData + copyFrames, _frameBuffer.begin() + _frameFill);
+        _frameFill += copyFrames;
+        offset = copyFrames;
 
-        if (encodedBytes > 0) {
-            NSData *encoded = [NSData dataWithBytes:outputBuffer length:encodedBytes];
-            callback(encoded);
-        } else {
-            NSLog(@"[OpusCodecBridge] Encode error in addSamplesAndEncode: %d", encodedBytes);
+        if (_frameFill < frameSize) {
+            return;
         }
+        [self encodeFrame:_frameBuffer.data() callback:callback];
+        _frameFill = 0;
+    }
+
+    // Encode whole frames straight from the input (always the case when fed
+    // by AudioEngine, which delivers exact 10ms frames)
+    while (offset + frameSize <= count) {
+        [self encodeFrame:pcmData + offset callback:callback];
+        offset += frameSize;
+    }
+
+    // Stage the remainder for the next call
+    _frameFill = count - offset;
+    std::copy(pcmData + offset, pcmData + count, _frameBuffer.begin());
+}
+
+- (void)encodeFrame:(const float *)pcmData
+           callback:(void (^)(NSData *encodedData, int packetFrames))callback {
+    constexpr size_t kMaxPacketSize = 4000;
+    uint8_t outputBuffer[kMaxPacketSize];
+
+    int encodedBytes = _codec->encode(pcmData, _frameSize, outputBuffer, kMaxPacketSize);
+
+    if (encodedBytes <= 0) {
+        NSLog(@"[OpusCodecBridge] Encode error in addSamplesAndEncode: %d", encodedBytes);
+        return;
+    }
+
+    int packetFrames = 0;
+    int packetBytes = _packetizer->addFrame(outputBuffer, encodedBytes,
+                                            _packetBuffer.data(), _packetBuffer.size(), packetFrames);
+    if (packetBytes > 0) {
+        callback([NSData dataWithBytes:_packetBuffer.data() length:packetBytes], packetFrames);
+    } else if (packetBytes < 0) {
+        NSLog(@"[OpusCodecBridge] Packetizer error: %d", packetBytes);
+    }
+}
+
+- (void)flushPacket:(void (^)(NSData *encodedData, int packetFrames))callback {
+    if (!_packetizer || !callback) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    int packetFrames = 0;
+    int packetBytes = _packetizer->flush(_packetBuffer.data(), _packetBuffer.size(), packetFrames);
+    if (packetBytes > 0) {
+        callback([NSData dataWithBytes:_packetBuffer.data() length:packetBytes], packetFrames);
     }
 }
 
@@ -146,20 +236,94 @@
     return generatedFrames;
 }
 
+- (int)decodeWithOpusData:(NSData *)opusData
+        floatOutputBuffer:(float *)outputBuffer
+                maxFrames:(int)maxFrames {
+    if (!_codec || !opusData || !outputBuffer) {
+        return -1;
+    }
+
+    int decodedFrames = _codec->decode(
+        static_cast<const uint8_t *>(opusData.bytes),
+        opusData.length,
+        outputBuffer,
+        maxFrames
+    );
+
+    if (decodedFrames < 0) {
+        NSLog(@"[OpusCodecBridge] Decode error: %d", decodedFrames);
+    }
+
+    return decodedFrames;
+}
+
+- (int)decodePLCWithFloatOutputBuffer:(float *)outputBuffer
+                            maxFrames:(int)maxFrames {
+    if (!_codec || !outputBuffer) {
+        return -1;
+    }
+
+    int generatedFrames = _codec->decodePLC(outputBuffer, maxFrames);
+
+    if (generatedFrames < 0) {
+        NSLog(@"[OpusCodecBridge] PLC error: %d", generatedFrames);
+    }
+
+    return generatedFrames;
+}
+
+- (BOOL)updateLinkWithRTT:(float)rttMs
+             maxBandwidth:(uint32_t)maxBandwidth
+                tcpTunnel:(BOOL)tcpTunnel {
+    if (!_codec || !_controller) {
+        return NO;
+    }
+
+    _controller->setMaxBandwidth(maxBandwidth);
+    _controller->setTransport(tcpTunnel ? sayses::EncoderController::Transport::TcpTunnel
+                                        : sayses::EncoderController::Transport::Udp);
+
+    // TCP hides loss behind retransmission, so only RTT and the budget act there
+    sayses::EncoderController::LinkStats stats;
+    stats.rttMs = rttMs;
+    if (!_controller->update(stats, std::chrono::steady_clock::now())) {
+        return NO;
+    }
+
+    sayses::Codec::EncoderSettings settings = _controller->getSettings();
+    if (!_codec->setEncoderSettings(settings)) {
+        return NO;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_bufferMutex);
+        _packetizer->setFramesPerPacket(_controller->getFramesPerPacket());
+    }
+    NSLog(@"[OpusCodecBridge] Encoder: bitrate=%d, fec=%d, loss=%d%%, frames/packet=%d, on-wire=%d bps",
+          settings.bitrate, settings.inbandFec ? 1 : 0, settings.packetLossPercent,
+          _controller->getFramesPerPacket(), _controller->getTotalBitrate());
+    return YES;
+}
+
 - (void)reset {
     if (_codec) {
         _codec->reset();
     }
     {
         std::lock_guard<std::mutex> lock(_bufferMutex);
-        _sampleBuffer.clear();
+        _frameFill = 0;
+        if (_packetizer) {
+            _packetizer->reset();
+        }
     }
     NSLog(@"[OpusCodecBridge] Reset (buffer cleared)");
 }
 
 - (void)clearBuffer {
     std::lock_guard<std::mutex> lock(_bufferMutex);
-    _sampleBuffer.clear();
+    _frameFill = 0;
+    if (_packetizer) {
+        _packetizer->reset();
+    }
 }
 
 - (int)frameSize {
@@ -170,4 +334,9 @@
     return _sampleRate;
 }
 
+- (int)framesPerPacket {
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    return _packetizer ? _packetizer->getFramesPerPacket() : 1;
+}
+
 @end
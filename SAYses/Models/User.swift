@@ -9,10 +9,11 @@ struct User: Identifiable, Hashable {
     let isSelfMuted: Bool
     let isSelfDeafened: Bool
     let isSuppressed: Bool
+    let isPrioritySpeaker: Bool
 
     var id: UInt32 { session }
 
-    init(session: UInt32 = 0, channelId: UInt32 = 0, name: String, isMuted: Bool = false, isDeafened: Bool = false, isSelfMuted: Bool = false, isSelfDeafened: Bool = false, isSuppressed: Bool = false) {
+    init(session: UInt32 = 0, channelId: UInt32 = 0, name: String, isMuted: Bool = false, isDeafened: Bool = false, isSelfMuted: Bool = false, isSelfDeafened: Bool = false, isSuppressed: Bool = false, isPrioritySpeaker: Bool = false) {
         self.session = session
         self.channelId = channelId
         self.name = name
@@ -21,6 +22,7 @@ struct User: Identifiable, Hashable {
         self.isSelfMuted = isSelfMuted
         self.isSelfDeafened = isSelfDeafened
         self.isSuppressed = isSuppressed
+        self.isPrioritySpeaker = isPrioritySpeaker
     }
 
     var displayStatus: String {
@@ -17,7 +17,7 @@ class AudioService: ObservableObject {
     private let frameSize: Int32 = 480  // 10ms at 48kHz
 
     // Callbacks
-    private var captureCallback: ((UnsafePointer<Int16>, Int) -> Void)?
+    private var captureCallback: ((UnsafePointer<Float>, Int) -> Void)?
     private var captureCallbackInvocations: Int = 0
     private var lastCaptureCallbackTime: Date?
     private var playbackCallback: ((UnsafeMutablePointer<Int16>, Int) -> Int)?
@@ -111,7 +111,7 @@ class AudioService: ObservableObject {
             return
         }
 
-        let success = engine.startCapture { [weak self] data, frames in
+        let success = engine.startFloatCapture { [weak self] data, frames in
             guard let self = self else { return }
             self.lastCaptureCallbackTime = Date()
             self.captureCallback?(data, frames)
@@ -142,7 +142,7 @@ class AudioService: ObservableObject {
 
     // MARK: - Capture
 
-    func startCapture(callback: @escaping (UnsafePointer<Int16>, Int) -> Void) {
+    func startCapture(callback: @escaping (UnsafePointer<Float>, Int) -> Void) {
         NSLog("[AudioService] startCapture called, isCapturing=\(isCapturing)")
 
         // Store the callback - this is called for each audio buffer
@@ -182,7 +182,7 @@ class AudioService: ObservableObject {
             return
         }
 
-        let success = engine.startCapture { [weak self] data, frames in
+        let success = engine.startFloatCapture { [weak self] data, frames in
             guard let self = self else { return }
             self.lastCaptureCallbackTime = Date()
             // Call the current callback (may be updated later)
@@ -295,6 +295,11 @@ class AudioService: ObservableObject {
         audioEngine?.addUserAudio(userId, samples: samples, frames: frames, sequence: sequence)
     }
 
+    /// Add decoded float audio for a user (no int16 quantization before mixing)
+    func addUserAudio(userId: UInt32, samples: UnsafePointer<Float>, frames: Int, sequence: Int64) {
+        audioEngine?.addUserAudio(userId, floatSamples: samples, frames: frames, sequence: sequence)
+    }
+
     /// Remove user's audio buffer
     func removeUser(_ userId: UInt32) {
         audioEngine?.removeUser(userId)
@@ -306,6 +311,21 @@ class AudioService: ObservableObject {
         audioEngine?.notifyUserTalkingEnded(userId)
     }
 
+    /// Set a user's local playback gain (1.0 = unchanged)
+    func setUserVolume(_ userId: UInt32, gain: Float) {
+        audioEngine?.setUserVolume(userId, gain: gain)
+    }
+
+    /// Locally mute/unmute a user
+    func setUserMuted(_ userId: UInt32, muted: Bool) {
+        audioEngine?.setUserMuted(userId, muted: muted)
+    }
+
+    /// Mark a user as priority speaker (ducks other users while talking)
+    func setUserPrioritySpeaker(_ userId: UInt32, priority: Bool) {
+        audioEngine?.setUserPrioritySpeaker(userId, priority: priority)
+    }
+
     /// Start playback using internal C++ user mixing
     func startMixedPlayback() -> Bool {
         guard let engine = audioEngine else {
@@ -11,8 +11,9 @@ protocol MumbleConnectionDelegate: AnyObject {
     func connectionError(_ message: String)
     func permissionQueryReceived(channelId: UInt32, permissions: Int, flush: Bool)
     func textMessageReceived(_ message: ParsedTextMessage)
-    func audioReceived(session: UInt32, pcmData: UnsafePointer<Int16>, frames: Int, sequence: Int64)
+    func audioReceived(session: UInt32, pcmData: UnsafePointer<Float>, frames: Int, sequence: Int64)
     func userAudioEnded(session: UInt32)
+    func userPrioritySpeakerChanged(session: UInt32, prioritySpeaker: Bool)
     func latencyUpdated(_ latencyMs: Int64)
     func tlsCipherSuiteDetected(_ cipherSuite: String)
 }
@@ -36,9 +37,10 @@ class MumbleConnection: MumbleTcpConnectionDelegate {
     private var userDecoders: [UInt32: OpusCodecBridge] = [:]
     private let decoderQueue = DispatchQueue(label: "de.sempara.mumble.decoder", qos: .userInteractive)
 
-    // PCM buffer for decoded audio (max 120ms at 48kHz mono = 5760 samples)
+    // Float PCM buffer for decoded audio (max 120ms at 48kHz mono = 5760 samples)
     // Opus packets can contain multiple frames (10ms, 20ms, 40ms, 60ms, or 120ms)
-    private var decodedPcmBuffer = [Int16](repeating: 0, count: 5760)
+    // Decoded as float so the mixer gets it without an int16 round trip
+    private var decodedPcmBuffer = [Float](repeating: 0, count: 5760)
 
     init() {
         tcpConnection.delegate = self
@@ -318,7 +320,8 @@ class MumbleConnection: MumbleTcpConnectionDelegate {
                 isDeafened: state.deaf,
                 isSelfMuted: state.selfMute,
                 isSelfDeafened: state.selfDeaf,
-                isSuppressed: state.suppress
+                isSuppressed: state.suppress,
+                isPrioritySpeaker: state.hasPrioritySpeaker ? state.prioritySpeaker : (existingUser?.isPrioritySpeaker ?? false)
             )
             users[state.session] = user
             print("[MumbleConnection] User stored: \(state.name) (session=\(state.session), channel=\(resolvedChannelId))")
@@ -333,7 +336,8 @@ class MumbleConnection: MumbleTcpConnectionDelegate {
                 isDeafened: state.hasDeaf ? state.deaf : existing.isDeafened,
                 isSelfMuted: state.hasSelfMute ? state.selfMute : existing.isSelfMuted,
                 isSelfDeafened: state.hasSelfDeaf ? state.selfDeaf : existing.isSelfDeafened,
-                isSuppressed: state.hasSuppress ? state.suppress : existing.isSuppressed
+                isSuppressed: state.hasSuppress ? state.suppress : existing.isSuppressed,
+                isPrioritySpeaker: state.hasPrioritySpeaker ? state.prioritySpeaker : existing.isPrioritySpeaker
             )
             users[state.session] = user
             if user.isSuppressed != existing.isSuppressed {
@@ -343,6 +347,11 @@ class MumbleConnection: MumbleTcpConnectionDelegate {
         }
         // If no name and no existing user, ignore (incomplete user state)
 
+        // Priority speakers duck everyone else in the playback mix
+        if let user = users[state.session], user.isPrioritySpeaker != (existingUser?.isPrioritySpeaker ?? false) {
+            delegate?.userPrioritySpeakerChanged(session: user.session, prioritySpeaker: user.isPrioritySpeaker)
+        }
+
         updateChannelUserCounts()
         delegate?.usersUpdated(getUserList())
     }
@@ -458,9 +467,9 @@ class MumbleConnection: MumbleTcpConnectionDelegate {
             return
         }
 
-        // Decode Opus to PCM
+        // Decode Opus to float PCM
         let decodedFrames = decoder.decode(withOpusData: packet.opusData,
-                                            outputBuffer: &decodedPcmBuffer,
+                                            floatOutputBuffer: &decodedPcmBuffer,
                                             maxFrames: Int32(decodedPcmBuffer.count))
 
         guard decodedFrames > 0 else {
@@ -378,6 +378,7 @@ struct ParsedUserState {
     var hasSuppress: Bool = false
     var hasSelfMute: Bool = false
     var hasSelfDeaf: Bool = false
+    var hasPrioritySpeaker: Bool = false
 }
 
 struct ParsedUserRemove {
@@ -496,7 +497,7 @@ struct MumbleParsers {
             case 8: result.suppress = decoder.readBool() ?? false; result.hasSuppress = true
             case 9: result.selfMute = decoder.readBool() ?? false; result.hasSelfMute = true
             case 10: result.selfDeaf = decoder.readBool() ?? false; result.hasSelfDeaf = true
-            case 18: result.prioritySpeaker = decoder.readBool() ?? false
+            case 18: result.prioritySpeaker = decoder.readBool() ?? false; result.hasPrioritySpeaker = true
             case 19: result.recording = decoder.readBool() ?? false
             default: decoder.skip(wireType: wireType)
             }
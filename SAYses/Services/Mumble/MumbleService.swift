@@ -1611,7 +1611,7 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
         }
     }
 
-    private func encodeAndSendAudio(data: UnsafePointer<Int16>, frames: Int) {
+    private func encodeAndSendAudio(data: UnsafePointer<Float>, frames: Int) {
         audioDebugCounter += 1
         if audioDebugCounter % 100 == 1 {
             NSLog("[MumbleService] encodeAndSendAudio called (#%d, frames=%d, seq=%lld, codec=%@, state=%@)",
@@ -1629,23 +1629,13 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
             return
         }
 
-        // Buffer samples and encode in 480-sample chunks (iOS may deliver 512, 1024, etc.)
+        // Buffer samples and encode in 480-sample chunks (iOS may deliver 512, 1024, etc.),
+        // merged into 10-60ms packets as the codec's link adaptation decides
         var encodedCount = 0
-        codec.addSamplesAndEncode(data, frameCount: Int32(frames)) { [weak self] opusData in
+        codec.addFloatSamplesAndEncode(data, frameCount: Int32(frames)) { [weak self] opusData, packetFrames in
             guard let self = self else { return }
             encodedCount += 1
-
-            // Send encoded packet to server
-            // IMPORTANT: isTerminator must be true for single-frame packets!
-            // This tells the server this is the last frame in the UDP packet.
-            // Without this bit, the server waits for more frames and doesn't process the audio.
-            self.mumbleConnection.sendAudioPacket(
-                opusData: opusData,
-                sequenceNumber: self.audioSequenceNumber,
-                isTerminator: true
-            )
-
-            self.audioSequenceNumber += 1
+            self.sendEncodedPacket(opusData, frames: packetFrames)
         }
 
         if audioDebugCounter % 100 == 1 {
@@ -1653,11 +1643,30 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
         }
     }
 
+    /// Send one Opus packet; the sequence number counts 10ms frames, not packets
+    private func sendEncodedPacket(_ opusData: Data, frames: Int32) {
+        // IMPORTANT: isTerminator must be true for single-packet messages!
+        // This tells the server this is the last Opus packet in the voice message.
+        // Without this bit, the server waits for more packets and doesn't process the audio.
+        mumbleConnection.sendAudioPacket(
+            opusData: opusData,
+            sequenceNumber: audioSequenceNumber,
+            isTerminator: true
+        )
+
+        audioSequenceNumber += Int64(frames)
+    }
+
     func stopTransmitting() {
         NSLog("[MumbleService] Stop transmitting")
         audioService.stopCapture()
 
-        // Clear any buffered samples
+        // Send frames still waiting for a full packet, then clear any buffered samples
+        if connectionState == .synchronized {
+            opusCodec?.flushPacket { [weak self] opusData, packetFrames in
+                self?.sendEncodedPacket(opusData, frames: packetFrames)
+            }
+        }
         opusCodec?.clearBuffer()
 
         // Send terminator packet to indicate end of transmission
@@ -3241,6 +3250,7 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
             } else {
                 self.serverInfo = info
             }
+            self.updateEncoderLink()
         }
     }
 
@@ -3489,7 +3499,7 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
 
     private var audioReceivedLogCounter = 0
 
-    func audioReceived(session: UInt32, pcmData: UnsafePointer<Int16>, frames: Int, sequence: Int64) {
+    func audioReceived(session: UInt32, pcmData: UnsafePointer<Float>, frames: Int, sequence: Int64) {
         audioReceivedLogCounter += 1
         if audioReceivedLogCounter % 500 == 1 {
             NSLog("[MumbleService] audioReceived #%d: session=%u, frames=%d, seq=%lld, muted=%d, playbackStarted=%d, isPlaying=%d",
@@ -3525,6 +3535,11 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
         audioService.notifyUserTalkingEnded(session)
     }
 
+    func userPrioritySpeakerChanged(session: UInt32, prioritySpeaker: Bool) {
+        // Engine ducks the other talkers while a priority speaker talks
+        audioService.setUserPrioritySpeaker(session, priority: prioritySpeaker)
+    }
+
     func latencyUpdated(_ latencyMs: Int64) {
         DispatchQueue.main.async {
             self.latencyMs = latencyMs
@@ -3533,9 +3548,18 @@ class MumbleService: NSObject, ObservableObject, MumbleConnectionDelegate, Chann
                 info.latencyMs = latencyMs
                 self.serverInfo = info
             }
+            self.updateEncoderLink()
         }
     }
 
+    /// Adapt the encoder to the ping RTT and the server's bandwidth limit (main thread).
+    /// Voice always goes through the TCP tunnel here.
+    private func updateEncoderLink() {
+        opusCodec?.updateLink(withRTT: Float(max(latencyMs, 0)),
+                              maxBandwidth: serverInfo?.maxBandwidth ?? 0,
+                              tcpTunnel: true)
+    }
+
     func tlsCipherSuiteDetected(_ cipherSuite: String) {
         DispatchQueue.main.async {
             self.tlsCipherSuite = cipherSuite